@@ -44,6 +44,9 @@ public class MultiplayerSessions : ModuleRules
 				"Slate",
 				"SlateCore",
 				"UMG",
+				"Sockets",
+				"RHI",
+				"EngineSettings",
 				"DeathEcho"
 				// ... add private dependencies that you statically link with here ...	
 			}
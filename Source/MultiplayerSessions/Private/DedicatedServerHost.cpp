@@ -0,0 +1,178 @@
+#include "DedicatedServerHost.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/GameInstance.h"
+#include "GameFramework/GameModeBase.h"
+#include "Misc/CommandLine.h"
+#include "Misc/PackageName.h"
+#include "SessionLog.h"
+#include "SessionStats.h"
+
+namespace DedicatedServerHost
+{
+    static constexpr float EmptyCheckInterval = 1.f;//seconds between two player counts
+}
+
+bool UDedicatedServerHost::ShouldCreateSubsystem(UObject * Outer) const
+{
+    return IsRunningDedicatedServer() && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UDedicatedServerHost::Initialize(FSubsystemCollectionBase & Collection)
+{
+    UMultiplayerSessionsSubsystem * Sessions = Collection.InitializeDependency<UMultiplayerSessionsSubsystem>();
+
+    Super::Initialize(Collection);
+
+    const TCHAR * CommandLine = FCommandLine::Get();
+
+    FParse::Value(CommandLine, TEXT("FleetInstance="), FleetInstance);
+    FParse::Value(CommandLine, TEXT("SessionSlots="), NumPublicConnections);
+    FParse::Value(CommandLine, TEXT("MatchType="), MatchType);
+
+    if(Sessions)
+    {
+        FParse::Value(CommandLine, TEXT("QosPort="), Sessions->QosPort);//instances on one machine each answer probes on their own port
+
+        SessionCompleteHandle = Sessions->MultiplayerOnNamedSessionComplete.AddUObject(this, &ThisClass::OnSessionComplete);
+    }
+
+    PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ThisClass::OnPostLoadMap);
+
+    if(EmptyRecycleSeconds > 0.f)
+    {
+        EmptyRecycleTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::TickEmptyRecycle), DedicatedServerHost::EmptyCheckInterval);
+    }
+}
+
+void UDedicatedServerHost::Deinitialize()
+{
+    FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+
+    FTSTicker::GetCoreTicker().RemoveTicker(EmptyRecycleTickerHandle);
+    EmptyRecycleTickerHandle.Reset();
+
+    UMultiplayerSessionsSubsystem * Sessions = GetGameInstance()->GetSubsystem<UMultiplayerSessionsSubsystem>();
+
+    if(Sessions)
+    {
+        Sessions->MultiplayerOnNamedSessionComplete.Remove(SessionCompleteHandle);
+    }
+
+    Super::Deinitialize();
+}
+
+/**
+ * Destroys the session so it stops being listed right away, the process exits once the destroy completed.
+ */
+void UDedicatedServerHost::RecycleInstance()
+{
+    if(bRecycling) return;
+
+    bRecycling = true;
+
+    UMultiplayerSessionsSubsystem * Sessions = GetGameInstance()->GetSubsystem<UMultiplayerSessionsSubsystem>();
+
+    SESSION_LOG(Display, TEXT("Recycling fleet instance %d"), FleetInstance);
+
+    if(!Sessions || !bSessionRegistered)
+    {
+        ExitInstance(EDedicatedServerExit::Recycled);
+
+        return;
+    }
+
+    Sessions->DestroySession();//OnSessionComplete exits, whether or not the backend managed to destroy it
+}
+
+/**
+ * Registers the session once the server runs its first map, later travels keep it.
+ */
+void UDedicatedServerHost::OnPostLoadMap(UWorld * LoadedWorld)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(DedicatedServer_RegisterSession);
+
+    if(!bRegisterSession || bSessionRegistered || bRegistering || bRecycling || !LoadedWorld) return;
+
+    UMultiplayerSessionsSubsystem * Sessions = GetGameInstance()->GetSubsystem<UMultiplayerSessionsSubsystem>();
+
+    if(!Sessions || !Sessions->GetSessionInterface().IsValid())
+    {
+        SESSION_LOG(Error, TEXT("Fleet instance %d has no session interface to register with"), FleetInstance);
+
+        ExitInstance(EDedicatedServerExit::RegisterFailed);
+
+        return;
+    }
+
+    const FString SessionMatchType = MatchType.IsEmpty() ? FPackageName::GetShortName(LoadedWorld->GetOutermost()->GetName()) : MatchType;
+
+    SESSION_LOG(Display, TEXT("Fleet instance %d registers a %s session with %d slots"), FleetInstance, *SessionMatchType, NumPublicConnections);
+
+    bRegistering = true;
+
+    Sessions->CreateSession(NumPublicConnections, SessionMatchType);
+}
+
+void UDedicatedServerHost::OnSessionComplete(FName SessionName, FSessionOperation::EType Operation, bool bWasSuccessful)
+{
+    if(SessionName != NAME_GameSession) return;
+
+    if(Operation == FSessionOperation::EType::Create && bRegistering)
+    {
+        bRegistering = false;
+        bSessionRegistered = bWasSuccessful;
+
+        if(!bWasSuccessful)
+        {
+            SESSION_LOG(Error, TEXT("Fleet instance %d could not register its session"), FleetInstance);
+
+            ExitInstance(EDedicatedServerExit::RegisterFailed);
+        }
+    }
+    else if(Operation == FSessionOperation::EType::Destroy && bRecycling)
+    {
+        ExitInstance(EDedicatedServerExit::Recycled);
+    }
+}
+
+/**
+ * Recycles an instance whose match is over because everyone left, an instance nobody joined yet keeps waiting.
+ */
+bool UDedicatedServerHost::TickEmptyRecycle(float DeltaTime)
+{
+    const UWorld * World = GetGameInstance()->GetWorld();
+    const AGameModeBase * GameMode = World ? World->GetAuthGameMode() : nullptr;
+
+    if(!GameMode || bRecycling) return true;
+
+    if(GameMode->GetNumPlayers() > 0)
+    {
+        bHadPlayers = true;
+        EmptySince = 0.0;
+
+        return true;
+    }
+
+    if(!bHadPlayers) return true;
+
+    const double Now = FPlatformTime::Seconds();
+
+    if(EmptySince == 0.0)
+    {
+        EmptySince = Now;
+    }
+    else if(Now - EmptySince >= EmptyRecycleSeconds)
+    {
+        RecycleInstance();
+    }
+
+    return true;
+}
+
+void UDedicatedServerHost::ExitInstance(EDedicatedServerExit::Type ExitCode)
+{
+    SESSION_LOG(Display, TEXT("Fleet instance %d exits (%d)"), FleetInstance, (int32)ExitCode);
+
+    FPlatformMisc::RequestExitWithStatus(false, ExitCode);
+}
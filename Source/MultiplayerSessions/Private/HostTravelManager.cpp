@@ -0,0 +1,168 @@
+#include "HostTravelManager.h"
+#include "Engine/World.h"
+#include "Engine/GameInstance.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameMapsSettings.h"
+#include "Misc/PackageName.h"
+#include "MapPreloader.h"
+#include "SessionLog.h"
+#include "SessionStats.h"
+
+void UHostTravelManager::Initialize(FSubsystemCollectionBase & Collection)
+{
+    Collection.InitializeDependency<UMapPreloader>();
+
+    Super::Initialize(Collection);
+}
+
+void UHostTravelManager::Deinitialize()
+{
+    FTSTicker::GetCoreTicker().RemoveTicker(PendingTravelTickerHandle);
+    PendingTravelTickerHandle.Reset();
+
+    Super::Deinitialize();
+}
+
+/**
+ * @param MapName A match type, a map package or a travel URL.
+ */
+void UHostTravelManager::PrepareTravel(const FString & MapName)
+{
+    UMapPreloader * MapPreloader = GetGameInstance()->GetSubsystem<UMapPreloader>();
+
+    if(MapPreloader)
+    {
+        MapPreloader->Preload(MapName);
+    }
+}
+
+/**
+ * @param LobbyUrl The lobby map with its options, "?listen" is added if it is missing.
+ * @return False if there is no world to travel from.
+ */
+bool UHostTravelManager::HostLobby(const FString & LobbyUrl)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(HostTravel_HostLobby);
+
+    FString Url = LobbyUrl;
+
+    if(!Url.Contains(TEXT("?listen")))
+    {
+        Url += TEXT("?listen");
+    }
+
+    return ServerTravel(Url, false);//the listen server is only opened by a hard travel
+}
+
+/**
+ * Travels once the destination is loaded, or once MaxPreloadWaitSeconds have passed, whichever comes first.
+ *
+ * @param MapName The match type naming the map, or a map package.
+ * @param Options Travel URL options, e.g. "?game=...".
+ * @return False if we are not the server or MapName does not name a map.
+ */
+bool UHostTravelManager::TravelToMatch(const FString & MapName, const FString & Options)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(HostTravel_TravelToMatch);
+
+    UWorld * World = GetGameInstance()->GetWorld();
+
+    if(!World || World->GetNetMode() == NM_Client)
+    {
+        SESSION_LOG(Warning, TEXT("Only the server can travel to a match"));
+
+        return false;
+    }
+
+    UMapPreloader * MapPreloader = GetGameInstance()->GetSubsystem<UMapPreloader>();
+
+    const FName PackageName = MapPreloader ? MapPreloader->Preload(MapName) : FName(*MapName);//a no-op when PrepareTravel already started it
+
+    if(PackageName.IsNone()) return false;
+
+    if(bSeamlessTravel)
+    {
+        ApplyTransitionMap();
+    }
+
+    FTSTicker::GetCoreTicker().RemoveTicker(PendingTravelTickerHandle);
+    PendingTravelTickerHandle.Reset();
+
+    PendingTravelUrl = PackageName.ToString() + Options;
+    PendingTravelPackage = PackageName;
+
+    if(MapPreloader && MapPreloader->IsLoading(PackageName) && MaxPreloadWaitSeconds > 0.f)
+    {
+        SESSION_LOG(Log, TEXT("Travel to %s waits for its preload"), *PendingTravelUrl);
+
+        PendingTravelDeadline = FPlatformTime::Seconds() + MaxPreloadWaitSeconds;
+        PendingTravelTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::TickPendingTravel));
+
+        return true;
+    }
+
+    return ServerTravel(PendingTravelUrl, bSeamlessTravel);
+}
+
+bool UHostTravelManager::TickPendingTravel(float DeltaTime)
+{
+    UMapPreloader * MapPreloader = GetGameInstance()->GetSubsystem<UMapPreloader>();
+
+    const bool bLoading = MapPreloader && MapPreloader->IsLoading(PendingTravelPackage);
+
+    if(bLoading && FPlatformTime::Seconds() < PendingTravelDeadline) return true;
+
+    if(bLoading)
+    {
+        SESSION_LOG(Warning, TEXT("Preload of %s did not finish in %.1fs, travelling anyway"), *PendingTravelPackage.ToString(), MaxPreloadWaitSeconds);
+    }
+
+    PendingTravelTickerHandle.Reset();//removed by returning false
+
+    ServerTravel(PendingTravelUrl, bSeamlessTravel);
+
+    return false;
+}
+
+/**
+ * @param Url The travel URL.
+ * @param bSeamless Whether the connected clients travel along without reconnecting, the game mode decides per travel.
+ */
+bool UHostTravelManager::ServerTravel(const FString & Url, bool bSeamless)
+{
+    UWorld * World = GetGameInstance()->GetWorld();
+
+    if(!World) return false;
+
+    AGameModeBase * GameMode = World->GetAuthGameMode();
+
+    if(GameMode)
+    {
+        GameMode->bUseSeamlessTravel = bSeamless;//the editor still falls back to a hard travel unless net.AllowPIESeamlessTravel is set
+    }
+
+    SESSION_LOG(Log, TEXT("Server travel to %s (%s)"), *Url, bSeamless ? TEXT("seamless") : TEXT("hard"));
+
+    World->ServerTravel(Url);
+
+    return true;
+}
+
+/**
+ * A seamless travel passes through the project's transition map, or an empty world without one.
+ * TransitionMap only fills in for a project that does not set one and is preloaded, so entering it costs next to nothing.
+ */
+void UHostTravelManager::ApplyTransitionMap()
+{
+    UGameMapsSettings * MapsSettings = GetMutableDefault<UGameMapsSettings>();
+
+    if(MapsSettings->TransitionMap.IsNull() && !TransitionMap.IsEmpty() && FPackageName::DoesPackageExist(TransitionMap))
+    {
+        MapsSettings->TransitionMap = FSoftObjectPath(FString::Printf(TEXT("%s.%s"), *TransitionMap, *FPackageName::GetShortName(TransitionMap)));
+    }
+
+    if(!MapsSettings->TransitionMap.IsNull())
+    {
+        PrepareTravel(MapsSettings->TransitionMap.GetLongPackageName());
+    }
+}
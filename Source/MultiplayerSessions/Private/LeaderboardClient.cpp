@@ -0,0 +1,301 @@
+#include "LeaderboardClient.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/MemoryReader.h"
+#include "Misc/CommandLine.h"
+#include "SessionLog.h"
+#include "SessionStats.h"
+
+/**
+ * -LeaderboardUrl= overrides the configured service.
+ */
+void ULeaderboardClient::Initialize(FSubsystemCollectionBase & Collection)
+{
+    Super::Initialize(Collection);
+
+    FParse::Value(FCommandLine::Get(), TEXT("LeaderboardUrl="), BaseUrl);
+
+    BaseUrl.RemoveFromEnd(TEXT("/"));
+}
+
+void ULeaderboardClient::Deinitialize()
+{
+    TMap<int32, FPendingPage> Pending = MoveTemp(PendingPages);
+
+    for(TPair<int32, FPendingPage> & Page : Pending)
+    {
+        Page.Value.Request->OnProcessRequestComplete().Unbind();
+        Page.Value.Request->CancelRequest();
+    }
+
+    Super::Deinitialize();
+}
+
+/**
+ * Delivers a page of the top players, from the cache when it can.
+ *
+ * @param PageIndex The page, 0 is the top PageSize players.
+ * @param OnPage Called with the page, once, or twice when a stale cached page is followed by the revalidated one.
+ * @param OnFailed Called when the page could not be fetched and nothing was cached.
+ */
+void ULeaderboardClient::GetTopPlayers(int32 PageIndex, FOnLeaderboardPage && OnPage, FOnLeaderboardFailed && OnFailed)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Leaderboard_GetTopPlayers);
+
+    FCachedPage * Cached = Cache.Find(PageIndex);
+
+    if(Cached)
+    {
+        Cached->LastUsed = ++UseCounter;
+
+        if(FPlatformTime::Seconds() - Cached->FetchedTime < MaxAgeSeconds)
+        {
+            OnPage.ExecuteIfBound(Cached->Page, true);
+            return;
+        }
+
+        OnPage.ExecuteIfBound(Cached->Page, false);//shown right away, replaced if the revalidation brings a newer page
+    }
+
+    const bool bInFlight = PendingPages.Contains(PageIndex);
+
+    FPendingPage & Pending = PendingPages.FindOrAdd(PageIndex);
+    Pending.OnPage.Add(MoveTemp(OnPage));
+    Pending.OnFailed.Add(MoveTemp(OnFailed));
+
+    if(!bInFlight)
+    {
+        RequestPage(PageIndex, Cached);
+    }
+}
+
+const FLeaderboardPage * ULeaderboardClient::PeekPage(int32 PageIndex) const
+{
+    const FCachedPage * Cached = Cache.Find(PageIndex);
+
+    return Cached ? &Cached->Page : nullptr;
+}
+
+void ULeaderboardClient::ClearCache()
+{
+    Cache.Reset();
+}
+
+/**
+ * @param PageIndex The page to fetch.
+ * @param Cached The cached version of the page, its validators make the request conditional.
+ */
+void ULeaderboardClient::RequestPage(int32 PageIndex, const FCachedPage * Cached)
+{
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+
+    Request->SetURL(FString::Printf(TEXT("%s/leaderboard/top?offset=%d&limit=%d"), *BaseUrl, PageIndex * PageSize, PageSize));
+    Request->SetVerb(TEXT("GET"));
+    Request->SetHeader(TEXT("Accept"), TEXT("application/json"));
+    Request->SetTimeout(RequestTimeoutSeconds);
+
+    if(Cached && !Cached->ETag.IsEmpty())
+    {
+        Request->SetHeader(TEXT("If-None-Match"), Cached->ETag);
+    }
+
+    if(Cached && !Cached->LastModified.IsEmpty())
+    {
+        Request->SetHeader(TEXT("If-Modified-Since"), Cached->LastModified);
+    }
+
+    Request->OnProcessRequestComplete().BindUObject(this, &ThisClass::OnPageResponse, PageIndex);
+
+    PendingPages.FindChecked(PageIndex).Request = Request;
+
+    if(BaseUrl.IsEmpty() || !Request->ProcessRequest())
+    {
+        SESSION_LOG(Warning, TEXT("Leaderboard request for page %d could not be sent, is a leaderboard url configured?"), PageIndex);
+
+        OnPageResponse(Request, nullptr, false, PageIndex);
+    }
+}
+
+/**
+ * A 304 keeps the cached page and only refreshes its age, a 200 replaces it. A failure falls back to a cached page when there is one.
+ */
+void ULeaderboardClient::OnPageResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bConnectedSuccessfully, int32 PageIndex)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Leaderboard_OnPageResponse);
+
+    FPendingPage Pending;
+
+    if(!PendingPages.RemoveAndCopyValue(PageIndex, Pending)) return;
+
+    const int32 ResponseCode = bConnectedSuccessfully && Response.IsValid() ? Response->GetResponseCode() : 0;
+
+    FCachedPage * Cached = Cache.Find(PageIndex);
+    bool bChanged = false;
+
+    if(ResponseCode == 304 && Cached)
+    {
+        Cached->FetchedTime = FPlatformTime::Seconds();
+    }
+    else if(ResponseCode == 200)
+    {
+        FLeaderboardPage Page;
+        Page.PageIndex = PageIndex;
+
+        if(ParsePage(Response->GetContent(), Page))
+        {
+            Cached = &AddToCache(PageIndex);
+            Cached->Page = MoveTemp(Page);
+            Cached->ETag = Response->GetHeader(TEXT("ETag"));
+            Cached->LastModified = Response->GetHeader(TEXT("Last-Modified"));
+            Cached->FetchedTime = FPlatformTime::Seconds();
+
+            bChanged = true;
+        }
+        else
+        {
+            SESSION_LOG(Warning, TEXT("Leaderboard page %d could not be parsed"), PageIndex);
+        }
+    }
+    else
+    {
+        SESSION_LOG(Warning, TEXT("Leaderboard request for page %d failed (%d)"), PageIndex, ResponseCode);
+    }
+
+    if(!Cached)
+    {
+        for(FOnLeaderboardFailed & OnFailed : Pending.OnFailed)
+        {
+            OnFailed.ExecuteIfBound();
+        }
+
+        return;
+    }
+
+    if(!bChanged)
+    {
+        SESSION_LOG(Verbose, TEXT("Leaderboard page %d unchanged (%d)"), PageIndex, ResponseCode);
+    }
+
+    // a caller that was served a stale page gets it again as final, so it knows the revalidation is over
+    for(FOnLeaderboardPage & OnPage : Pending.OnPage)
+    {
+        OnPage.ExecuteIfBound(Cached->Page, true);
+    }
+}
+
+/**
+ * Evicts the least recently used page when the cache is full.
+ */
+ULeaderboardClient::FCachedPage & ULeaderboardClient::AddToCache(int32 PageIndex)
+{
+    if(!Cache.Contains(PageIndex) && Cache.Num() >= FMath::Max(1, MaxCachedPages))
+    {
+        int32 OldestPage = INDEX_NONE;
+        uint64 OldestUse = MAX_uint64;
+
+        for(const TPair<int32, FCachedPage> & Entry : Cache)
+        {
+            if(Entry.Value.LastUsed < OldestUse)
+            {
+                OldestPage = Entry.Key;
+                OldestUse = Entry.Value.LastUsed;
+            }
+        }
+
+        Cache.Remove(OldestPage);
+    }
+
+    FCachedPage & Entry = Cache.FindOrAdd(PageIndex);
+    Entry.LastUsed = ++UseCounter;
+
+    return Entry;
+}
+
+/**
+ * Reads the rows straight out of the UTF-8 body, token by token.
+ *
+ * @param Content The response body.
+ * @param OutPage Receives the rows and the total.
+ * @return False if the body is not valid JSON.
+ */
+bool ULeaderboardClient::ParsePage(const TArray<uint8> & Content, FLeaderboardPage & OutPage)
+{
+    SESSION_LLM_SCOPE(SearchResults);
+
+    FMemoryReaderView Stream(MakeArrayView(Content));
+    TSharedRef<TJsonReader<UTF8CHAR>> Reader = TJsonReaderFactory<UTF8CHAR>::Create(&Stream);
+
+    int32 Depth = 0;
+    bool bInEntries = false;
+    FLeaderboardRow Row;
+
+    EJsonNotation Notation;
+
+    while(Reader->ReadNext(Notation))
+    {
+        switch(Notation)
+        {
+        case EJsonNotation::ObjectStart:
+            if(bInEntries && Depth == 2)
+            {
+                Row = FLeaderboardRow();
+                Row.NameOffset = OutPage.Names.Len();
+            }
+            ++Depth;
+            break;
+        case EJsonNotation::ObjectEnd:
+            --Depth;
+            if(bInEntries && Depth == 2)
+            {
+                OutPage.Rows.Add(Row);
+            }
+            break;
+        case EJsonNotation::ArrayStart:
+            if(Depth == 1 && Reader->GetIdentifier() == TEXT("entries"))
+            {
+                bInEntries = true;
+                OutPage.Rows.Reserve(32);
+            }
+            ++Depth;
+            break;
+        case EJsonNotation::ArrayEnd:
+            --Depth;
+            if(Depth == 1)
+            {
+                bInEntries = false;
+            }
+            break;
+        case EJsonNotation::Number:
+            if(Depth == 1 && Reader->GetIdentifier() == TEXT("total"))
+            {
+                OutPage.TotalEntries = (int32)Reader->GetValueAsNumber();
+            }
+            else if(bInEntries && Depth == 3 && Reader->GetIdentifier() == TEXT("rank"))
+            {
+                Row.Rank = (int32)Reader->GetValueAsNumber();
+            }
+            else if(bInEntries && Depth == 3 && Reader->GetIdentifier() == TEXT("score"))
+            {
+                Row.Score = (int64)Reader->GetValueAsNumber();
+            }
+            break;
+        case EJsonNotation::String:
+            if(bInEntries && Depth == 3 && Reader->GetIdentifier() == TEXT("name"))
+            {
+                const FString & Name = Reader->GetValueAsString();
+
+                Row.NameOffset = OutPage.Names.Len();
+                Row.NameLength = Name.Len();
+                OutPage.Names += Name;
+            }
+            break;
+        case EJsonNotation::Error:
+            return false;
+        default:
+            break;//booleans, nulls and unknown fields are skipped
+        }
+    }
+
+    return !Reader->GetErrorMessage().Len() && Depth == 0;
+}
@@ -1 +1 @@
-#include "ListViewEntry.h"
+#include "ListViewEntry.h"
\ No newline at end of file
@@ -1,32 +1,133 @@
 #include "ListViewEntryWidget.h"
 #include "Components/Button.h"
+#include "Components/TextBlock.h"
+#include "ListViewEntry.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "Misc/StringBuilder.h"
+#include "SessionStats.h"
 
 
 void UListViewEntryWidget::NativeConstruct()
 {
+    SESSION_LLM_SCOPE(Widgets);
+
     Super::NativeConstruct();
 
     if(JoinButton)
     {
-        JoinButton->OnClicked.AddDynamic(this, &UListViewEntryWidget::JoinGame);
+        JoinButton->OnClicked.AddUniqueDynamic(this, &UListViewEntryWidget::JoinGame);//recycled widgets can be constructed more than once
     }
 }
 
+/**
+ * Called by the list view when this widget is assigned a row.
+ *
+ * @param ListItemObject The UListViewEntry item of the row.
+ */
+void UListViewEntryWidget::NativeOnListItemObjectSet(UObject * ListItemObject)
+{
+    IUserObjectListEntry::NativeOnListItemObjectSet(ListItemObject);
 
-void UListViewEntryWidget::JoinGame()
+    UpdateRow();
+}
+
+/**
+ * Fills the widget from the session table row of the current list item.
+ * The handle is read from the item every time, refreshes re-point items to the new table without touching the widgets.
+ */
+void UListViewEntryWidget::UpdateRow()
+{
+    SESSION_SCOPE_CYCLE_COUNTER(ListEntry_UpdateRow);
+
+    UListViewEntry * Entry = GetListItem<UListViewEntry>();
+    UGameInstance * GameInstance = GetGameInstance();
+
+    UMultiplayerSessionsSubsystem * MultiplayerSessionsSubsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+
+    if(!Entry || !MultiplayerSessionsSubsystem || !MultiplayerSessionsSubsystem->GetSessionTable().IsValid(Entry->GetSessionHandle()))
+    {
+        ClearRow();
+
+        return;
+    }
+
+    const FSessionHandle SessionHandle = Entry->GetSessionHandle();
+    const FSessionDescriptorTable & Table = MultiplayerSessionsSubsystem->GetSessionTable();
+
+    const int32 Row = SessionHandle.Index;
+    const uint8 RowFlags = Table.GetRowFlags(Row);
+
+    if(ServerTitle)
+    {
+        TStringBuilder<128> Title;//formatted on the stack straight from the table views
+        Title << TEXT("Server: ") << Table.GetOwnerName(Row) << TEXT(" | Map: ") << Table.GetMapName(Row);
+
+        if(RowFlags & ESessionRowFlags::LastSeen)
+        {
+            Title << TEXT(" (last seen)");//from the snapshot of the last launch, until the search confirms it
+        }
+
+        ServerTitle->SetText(FText::FromStringView(Title.ToView()));
+    }
+
+    if(PingText)
+    {
+        PingText->SetText(FText::AsNumber(Table.GetPingInMs(Row)));
+    }
+
+    if(OpenSlotsText)
+    {
+        OpenSlotsText->SetText(FText::AsNumber(Table.GetOpenSlots(Row)));
+    }
+
+    const bool bDisappeared = (RowFlags & ESessionRowFlags::Disappeared) != 0;
+
+    SetRenderOpacity(bDisappeared ? 0.5f : 1.f);//greyed out rows are no longer listed by the backend
+
+    if(JoinButton)
+    {
+        JoinButton->SetIsEnabled(!bDisappeared);//the previous row may have disabled it
+        JoinButton->SetToolTipText(FText::FromStringView(Table.GetSessionId(Row)));
+    }
+}
+
+void UListViewEntryWidget::ClearRow()
 {
-    FString Id = Session.GetSessionIdStr();
+    if(ServerTitle)
+    {
+        ServerTitle->SetText(FText::GetEmpty());
+    }
+
+    if(PingText)
+    {
+        PingText->SetText(FText::GetEmpty());
+    }
 
+    if(OpenSlotsText)
+    {
+        OpenSlotsText->SetText(FText::GetEmpty());
+    }
+
+    if(JoinButton)
+    {
+        JoinButton->SetIsEnabled(false);
+        JoinButton->SetToolTipText(FText::GetEmpty());
+    }
+}
+
+void UListViewEntryWidget::JoinGame()
+{
+    UListViewEntry * Entry = GetListItem<UListViewEntry>();
     UGameInstance * GameInstance = GetGameInstance();
 
-    if(GameInstance)
+    if(Entry && GameInstance)
     {
         UMultiplayerSessionsSubsystem * MultiplayerSessionsSubsystem = GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>();
 
         if(MultiplayerSessionsSubsystem)
         {
             JoinButton->SetIsEnabled(false);
-            MultiplayerSessionsSubsystem->JoinSession(Session);//add the join session complete delegate
+            MultiplayerSessionsSubsystem->JoinSession(Entry->GetSessionHandle());//add the join session complete delegate
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,200 @@
+#include "MapPreloader.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+#include "SessionLog.h"
+#include "SessionStats.h"
+
+namespace MapPreloader
+{
+    // Ahead of the streaming the current world may still be doing, the join is waiting on these
+    static constexpr int32 PackagePriority = 100;
+}
+
+void UMapPreloader::Initialize(FSubsystemCollectionBase & Collection)
+{
+    Super::Initialize(Collection);
+
+    PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ThisClass::OnPostLoadMap);
+}
+
+void UMapPreloader::Deinitialize()
+{
+    FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+
+    ReleaseAll();
+
+    Super::Deinitialize();
+}
+
+/**
+ * Called as soon as the player commits to a join, before the backend join completes.
+ *
+ * @param MatchType The match type the session advertises, it names the map the match plays on.
+ */
+void UMapPreloader::PreloadForJoin(const FString & MatchType)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(MapPreloader_PreloadForJoin);
+
+    if(!bEnabled) return;
+
+    TArray<FName, TInlineAllocator<4>> JoinPackages;
+
+    for(const FString & MapName : JoinTravelMaps)
+    {
+        JoinPackages.AddUnique(ResolvePackageName(MapName));
+    }
+
+    if(bPreloadMatchMap && !MatchType.IsEmpty())
+    {
+        JoinPackages.AddUnique(ResolvePackageName(MatchType));
+    }
+
+    // a quick match failing over to its next candidate keeps the maps both joins travel to
+    for(auto It = PreloadedWorlds.CreateIterator(); It; ++It)
+    {
+        if(!JoinPackages.Contains(It.Key()))
+        {
+            It.RemoveCurrent();
+        }
+    }
+
+    for(auto It = PendingPackages.CreateIterator(); It; ++It)
+    {
+        if(!JoinPackages.Contains(*It))
+        {
+            It.RemoveCurrent();//the load finishes, but nothing holds on to it
+        }
+    }
+
+    for(const FName PackageName : JoinPackages)
+    {
+        if(!PackageName.IsNone())
+        {
+            Preload(PackageName.ToString());
+        }
+    }
+}
+
+/**
+ * @param MapName A map name such as "Arena_2", or a long package name such as "/Game/Maps/Lobby?listen".
+ * @return The package name of the map, None if MapName does not name one.
+ */
+FName UMapPreloader::Preload(const FString & MapName)
+{
+    const FName PackageName = ResolvePackageName(MapName);
+
+    if(PackageName.IsNone())
+    {
+        SESSION_LOG(Warning, TEXT("Cannot preload %s, it is not a map package name"), *MapName);
+
+        return NAME_None;
+    }
+
+    if(IsPreloaded(PackageName)) return PackageName;
+
+    if(FindPackage(nullptr, *PackageName.ToString()))
+    {
+        return PackageName;//already in memory, e.g. the world we are in
+    }
+
+    FTSTicker::GetCoreTicker().RemoveTicker(ReleaseTickerHandle);
+    ReleaseTickerHandle.Reset();
+
+    PendingPackages.Add(PackageName);
+
+    SESSION_LOG(Log, TEXT("Preloading %s"), *PackageName.ToString());
+
+    LoadPackageAsync(PackageName.ToString(), FLoadPackageAsyncDelegate::CreateUObject(this, &ThisClass::OnPackageLoaded), MapPreloader::PackagePriority);
+
+    return PackageName;
+}
+
+void UMapPreloader::ReleaseAll()
+{
+    FTSTicker::GetCoreTicker().RemoveTicker(ReleaseTickerHandle);
+    ReleaseTickerHandle.Reset();
+
+    PreloadedWorlds.Reset();//collected with the next garbage collection, unless the engine is using them by then
+    PendingPackages.Reset();
+}
+
+bool UMapPreloader::IsPreloaded(FName PackageName) const
+{
+    return PreloadedWorlds.Contains(PackageName) || PendingPackages.Contains(PackageName);
+}
+
+/**
+ * @param MapName A map name, a package path and/or travel URL options.
+ * @return The long package name of the map, None if it is not a valid one.
+ */
+FName UMapPreloader::ResolvePackageName(const FString & MapName) const
+{
+    FString PackageName = MapName;
+
+    int32 OptionsStart;
+
+    if(PackageName.FindChar(TEXT('?'), OptionsStart))
+    {
+        PackageName.LeftInline(OptionsStart);
+    }
+
+    if(!PackageName.StartsWith(TEXT("/")))
+    {
+        PackageName = MapDirectory / PackageName;
+    }
+
+    return FPackageName::IsValidLongPackageName(PackageName) ? FName(*PackageName) : NAME_None;
+}
+
+/**
+ * Holds on to the loaded world until the engine travels to it, unless the preload was released while it was loading.
+ */
+void UMapPreloader::OnPackageLoaded(const FName & PackageName, UPackage * Package, EAsyncLoadingResult::Type Result)
+{
+    if(!PendingPackages.Remove(PackageName)) return;
+
+    UWorld * World = Result == EAsyncLoadingResult::Succeeded && Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+
+    if(!World)
+    {
+        SESSION_LOG(Warning, TEXT("Preloading %s failed (%d)"), *PackageName.ToString(), (int32)Result);
+
+        return;
+    }
+
+    SESSION_LOG(Log, TEXT("Preloaded %s"), *PackageName.ToString());
+
+    PreloadedWorlds.Add(PackageName, World);
+}
+
+/**
+ * The engine has loaded a map: its preload served its purpose and the others are released after ReleaseDelaySeconds,
+ * long enough for the lobby to travel on to the match map.
+ */
+void UMapPreloader::OnPostLoadMap(UWorld * LoadedWorld)
+{
+    if(LoadedWorld)
+    {
+        const FName PackageName = LoadedWorld->GetOutermost()->GetFName();
+
+        PreloadedWorlds.Remove(PackageName);
+        PendingPackages.Remove(PackageName);
+    }
+
+    FTSTicker::GetCoreTicker().RemoveTicker(ReleaseTickerHandle);
+    ReleaseTickerHandle.Reset();
+
+    if(PreloadedWorlds.Num() > 0 || PendingPackages.Num() > 0)
+    {
+        ReleaseTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnReleaseDelayElapsed), ReleaseDelaySeconds);
+    }
+}
+
+bool UMapPreloader::OnReleaseDelayElapsed(float DeltaTime)
+{
+    ReleaseTickerHandle.Reset();//removed by returning false
+
+    ReleaseAll();
+
+    return false;
+}
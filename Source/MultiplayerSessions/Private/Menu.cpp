@@ -3,21 +3,24 @@
 #include "Components/TextBlock.h"
 #include "Components/Slider.h"
 #include "Components/ComboBoxString.h"
-// #include "Components/ListView.h"
-#include "Components/StackBox.h"
+#include "Components/ListView.h"
+#include "Components/EditableTextBox.h"
+#include "Components/SpinBox.h"
 #include "MultiplayerSessionsSubsystem.h"
 #include "ButtonWithParameter.h"
-// #include "ListViewEntry.h"
+#include "ListViewEntry.h"
+#include "ListViewEntryWidget.h"
 #include "OnlineSessionSettings.h"
 #include "OnlineSubsystem.h"
-#include "DebugHelper.h"
+#include "SessionLog.h"
+#include "SessionStats.h"
+#include "MenuDataCache.h"
+#include "QualityGovernor.h"
+#include "LeaderboardClient.h"
+#include "HostTravelManager.h"
 // #include "GameFramework/GameUserSettings.h"
 #include "DeathEcho/Settings/DESettings.h"
-//include master sound class
-#include "Sound/SoundClass.h"
 #include "Kismet/GameplayStatics.h"
-#include "Kismet/KismetSystemLibrary.h"
-#include "ListViewEntryWidget.h"
 
 /**
  * Sets up the menu with the specified parameters. OVERLOADED
@@ -84,7 +87,7 @@ void UMenu::SetupWidget()
 /**
  * Sets up the multiplayer subsystem for the menu.
  * This function retrieves the game instance and assigns the multiplayer sessions subsystem to the class member variable.
- * It also binds custom delegates to their respective functions.
+ * It also binds custom delegates to their respective functions and starts a speculative search so the browser opens filled.
  */
 void UMenu::SetupMultiplayerSubsystem()
 {
@@ -99,10 +102,66 @@ void UMenu::SetupMultiplayerSubsystem()
     {
         MultiplayerSessionsSubsystem->MultiplayerOnCreateSessionComplete.AddDynamic(this, &UMenu::OnCreateSession);//moze i &ThisClass
         MultiplayerSessionsSubsystem->MultiplayerOnFindSessionsComplete.AddUObject(this, &UMenu::OnFindSessions);
+        MultiplayerSessionsSubsystem->MultiplayerOnFindSessionsBatch.AddUObject(this, &UMenu::OnFindSessionsBatch);
+        MultiplayerSessionsSubsystem->MultiplayerOnSessionListUpdated.AddUObject(this, &UMenu::OnSessionListUpdated);
+        MultiplayerSessionsSubsystem->MultiplayerOnSessionQosUpdated.AddUObject(this, &UMenu::OnSessionQosUpdated);
         MultiplayerSessionsSubsystem->MultiplayerOnJoinSessionComplete.AddUObject(this, &UMenu::OnJoinSession);
         MultiplayerSessionsSubsystem->MultiplayerOnDestroySessionComplete.AddDynamic(this, &UMenu::OnDestroySession);
         MultiplayerSessionsSubsystem->MultiplayerOnStartSessionComplete.AddDynamic(this, &UMenu::OnStartSession);
+        MultiplayerSessionsSubsystem->MultiplayerOnQuickMatchComplete.AddUObject(this, &UMenu::OnQuickMatch);
+
+        ApplyServerListFilters();//the filter engine outlives the menu, start from what this menu's widgets show
+
+        MultiplayerSessionsSubsystem->PrefetchSessions(MakeSessionQuery());//warm the session cache while the player is still looking at the menu
     }
+
+    GetTopPlayers();
+}
+
+/**
+ * Shows the first page of the leaderboard. A menu opened again shows the cached page at once, while it is revalidated.
+ */
+void UMenu::GetTopPlayers()
+{
+    UGameInstance * GameInstance = GetGameInstance();
+    ULeaderboardClient * Leaderboard = GameInstance ? GameInstance->GetSubsystem<ULeaderboardClient>() : nullptr;
+
+    if(!TopPlayersText || !Leaderboard) return;
+
+    Leaderboard->GetTopPlayers(0, FOnLeaderboardPage::CreateUObject(this, &UMenu::OnTopPlayers));
+}
+
+/**
+ * @param Page The leaderboard page.
+ * @param bIsFinal False if the page is a stale one that is being revalidated.
+ */
+void UMenu::OnTopPlayers(const FLeaderboardPage & Page, bool bIsFinal)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_OnTopPlayers);
+
+    if(!TopPlayersText) return;
+
+    TStringBuilder<1024> Lines;
+
+    for(const FLeaderboardRow & Row : Page.Rows)
+    {
+        Lines.Appendf(TEXT("%d. "), Row.Rank);
+        Lines.Append(Page.GetName(Row));
+        Lines.Appendf(TEXT("  %lld\n"), Row.Score);
+    }
+
+    TopPlayersText->SetText(FText::FromString(Lines.ToString()));
+}
+
+/**
+ * The search the server browser runs: joinable sessions of this game and build.
+ * The backend filters on these constraints, so every returned result is a candidate.
+ *
+ * @return The query used for searching, prefetching and refreshing.
+ */
+FSessionQuery UMenu::MakeSessionQuery() const
+{
+    return FSessionQuery::Default().WithMaxResults(MaxSearchResults).WithMinOpenSlots(1);
 }
 
 /**
@@ -114,8 +173,16 @@ void UMenu::SetupMultiplayerSubsystem()
  */
 bool UMenu::Initialize()
 {
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_Initialize);
+    SESSION_LLM_SCOPE(Widgets);
+
     if(!Super::Initialize()) return false;
 
+    if(!ServerList)
+    {
+        SESSION_LOG(Warning, TEXT("%s has no ListView named ServerList, found sessions are not listed"), *GetClass()->GetName());
+    }
+
     if(HostButton)
     {
         HostButton->OnClicked.AddDynamic(this, &UMenu::HostButtonClicked);
@@ -126,6 +193,11 @@ bool UMenu::Initialize()
         JoinButton->OnClicked.AddDynamic(this, &UMenu::JoinButtonClicked);
     }
 
+    if(QuickMatchButton)
+    {
+        QuickMatchButton->OnClicked.AddDynamic(this, &UMenu::QuickMatchButtonClicked);
+    }
+
     if(SaveGraphicsButton)
     {
         SaveGraphicsButton->OnClicked.AddDynamic(this, &UMenu::SaveGraphicsButtonClicked);
@@ -151,6 +223,49 @@ bool UMenu::Initialize()
         MadQuality->OnClicked.AddDynamic(this, &UMenu::GraphicsQualityMadButtonClicked);
     }
 
+    SettingsTransaction.OnCommitted.BindUObject(this, &UMenu::OnSettingsCommitted);
+
+    if(UGameInstance * GameInstance = GetGameInstance())
+    {
+        SettingsTransaction.SetQualityGovernor(GameInstance->GetSubsystem<UQualityGovernor>());
+    }
+
+    if(MapFilterSelect)
+    {
+        MapFilterSelect->ClearOptions();
+        MapFilterSelect->AddOption(TEXT("Any"));
+
+        for(int32 Index = 0; MapSelect && Index < MapSelect->GetOptionCount(); ++Index)
+        {
+            MapFilterSelect->AddOption(MapSelect->GetOptionAtIndex(Index));
+        }
+
+        MapFilterSelect->SetSelectedIndex(0);
+        MapFilterSelect->OnSelectionChanged.AddDynamic(this, &UMenu::ServerListSelectionFilterChanged);
+    }
+
+    if(ServerSortSelect)
+    {
+        ServerSortSelect->ClearOptions();//same order as ESessionSortKey
+        ServerSortSelect->AddOption(TEXT("Ping"));
+        ServerSortSelect->AddOption(TEXT("Free slots"));
+        ServerSortSelect->AddOption(TEXT("Host"));
+        ServerSortSelect->AddOption(TEXT("Map"));
+
+        ServerSortSelect->SetSelectedIndex(0);
+        ServerSortSelect->OnSelectionChanged.AddDynamic(this, &UMenu::ServerListSelectionFilterChanged);
+    }
+
+    if(HostNameFilterText)
+    {
+        HostNameFilterText->OnTextChanged.AddDynamic(this, &UMenu::ServerListTextFilterChanged);
+    }
+
+    if(MinOpenSlotsFilter)
+    {
+        MinOpenSlotsFilter->OnValueChanged.AddDynamic(this, &UMenu::ServerListValueFilterChanged);
+    }
+
     UDESettings * Settings = Cast<UDESettings>(UDESettings::GetGameUserSettings());
 
     if(Settings)
@@ -159,11 +274,10 @@ bool UMenu::Initialize()
         {
             float MasterVolume = Settings->GetMasterSoundVolume();
             GlobalVolumeSlider->SetValue(MasterVolume);
-            
-            USoundClass* MasterSoundClass = LoadObject<USoundClass>(nullptr, TEXT("/Engine/EngineSounds/Master.Master"));
-            if (MasterSoundClass)
+
+            if(UMenuDataCache * MenuData = GetMenuDataCache())
             {
-                MasterSoundClass->Properties.Volume = MasterVolume;
+                MenuData->SetMasterVolume(MasterVolume);//applied once the sound class is loaded
             }
         }
 
@@ -179,19 +293,12 @@ bool UMenu::Initialize()
 
         if(ResolutionSelect)
         {
-            TArray<FIntPoint> SupportedResolutions;
-
-            UKismetSystemLibrary::GetSupportedFullscreenResolutions(SupportedResolutions);
+            ResolutionSelect->SetSelectedOption(UMenuDataCache::FormatResolution(Settings->GetScreenResolution()));//the options are added once the cache has them
 
-            for(FIntPoint Resolution : SupportedResolutions)
+            if(UMenuDataCache * MenuData = GetMenuDataCache())
             {
-                ResolutionSelect->AddOption(FString::Printf(TEXT("%dx%d"), Resolution.X, Resolution.Y));
+                MenuData->RequestMenuData(FOnMenuDataReady::CreateUObject(this, &ThisClass::OnMenuDataReady));
             }
-
-            FIntPoint CurrentScreenResolution = Settings->GetScreenResolution();
-            FString CurrentScreenResolutionString = FString::Printf(TEXT("%dx%d"), CurrentScreenResolution.X, CurrentScreenResolution.Y);
-
-            ResolutionSelect->SetSelectedOption(CurrentScreenResolutionString);
         }
 
         if(FullScreenModeSelect)
@@ -222,6 +329,37 @@ bool UMenu::Initialize()
     return true;
 }
 
+/**
+ * Fills the resolution combo box from the cached options and selects the current resolution.
+ *
+ * @param MenuData The prepared menu data.
+ */
+void UMenu::OnMenuDataReady(const UMenuDataCache & MenuData)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_OnMenuDataReady);
+    SESSION_LLM_SCOPE(Widgets);
+
+    UDESettings * Settings = Cast<UDESettings>(UDESettings::GetGameUserSettings());
+
+    if(!ResolutionSelect || !Settings) return;
+
+    ResolutionSelect->ClearOptions();
+
+    for(const FString & Option : MenuData.GetResolutionOptions())
+    {
+        ResolutionSelect->AddOption(Option);
+    }
+
+    ResolutionSelect->SetSelectedOption(UMenuDataCache::FormatResolution(Settings->GetScreenResolution()));
+}
+
+UMenuDataCache * UMenu::GetMenuDataCache() const
+{
+    UGameInstance * GameInstance = GetGameInstance();
+
+    return GameInstance ? GameInstance->GetSubsystem<UMenuDataCache>() : nullptr;//null in the designer
+}
+
 void UMenu::SaveGraphicsButtonClicked()
 {
     SaveGraphicsSettings();
@@ -248,49 +386,72 @@ void UMenu::GraphicsQualityMadButtonClicked()
 }
 
 
+/**
+ * Stages the quality level, rapid clicks through the levels are applied once, after the last one.
+ *
+ * @param QualityLevel The overall scalability level, 0 (low) to 3 (epic).
+ */
 void UMenu::GraphicsQualityUpdate(int32 QualityLevel)
 {
-    UDESettings * Settings = Cast<UDESettings>(UDESettings::GetGameUserSettings());
+    SESSION_LOG(Log, TEXT("Overall Scalability Level: %d"), QualityLevel);
 
-    if(Settings)
-    {
-        DebugHelper::PrintToLog(FString::Printf(TEXT("Current Resolution: %d x %d"), Settings->GetScreenResolution().X, Settings->GetScreenResolution().Y), FColor::Green);
+    SettingsTransaction.SetScalabilityLevel(QualityLevel);
+    SettingsTransaction.CommitDebounced();
+}
 
-        Settings->SetOverallScalabilityLevel(QualityLevel);
+/**
+ * Applies the side effects of committed settings that live outside UDESettings.
+ *
+ * @param Result What the commit applied.
+ */
+void UMenu::OnSettingsCommitted(const FSettingsCommitResult & Result)
+{
+    if(Result.Applied & ESettingsChange::Audio)
+    {
+        if(UMenuDataCache * MenuData = GetMenuDataCache())
+        {
+            MenuData->SetMasterVolume(GlobalVolumeSlider ? GlobalVolumeSlider->GetValue() : 1.f);
+        }
+    }
 
-        DebugHelper::PrintToLog(FString::Printf(TEXT("Current Overall Scalability Level: %d"), Settings->GetOverallScalabilityLevel()), FColor::Green);
+    if(Result.Applied & ESettingsChange::Scalability)
+    {
+        UGameInstance * GameInstance = GetGameInstance();
+        UQualityGovernor * QualityGovernor = GameInstance ? GameInstance->GetSubsystem<UQualityGovernor>() : nullptr;
 
-        Settings->ApplySettings(false);
+        if(QualityGovernor)
+        {
+            QualityGovernor->ResetCeiling();//the picked level is the most the governor goes back up to
+        }
     }
-    else
+
+    if(Result.RestartRequired != ESettingsChange::None)
     {
-        DebugHelper::PrintToLog("Game User Settings is null", FColor::Red);
+        SESSION_LOG(Display, TEXT("Some settings take effect after a restart"));
     }
 }
 
+/**
+ * Stages the values of the settings widgets and applies the ones that differ from the current settings right away.
+ */
 void UMenu::SaveGraphicsSettings()
 {
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_SaveGraphicsSettings);
+
     UDESettings * Settings = Cast<UDESettings>(UDESettings::GetGameUserSettings());
 
     if(Settings)
     {
         if(MouseSensitivitySlider)
         {
-            UE_LOG(LogTemp, Display, TEXT("Current Mouse Sensitivity: %f"), MouseSensitivitySlider->GetValue());
-            Settings->SetMouseSensitivity(MouseSensitivitySlider->GetValue());
+            SESSION_LOG(Verbose, TEXT("Current Mouse Sensitivity: %f"), MouseSensitivitySlider->GetValue());
+            SettingsTransaction.SetMouseSensitivity(MouseSensitivitySlider->GetValue());
         }
 
         if(GlobalVolumeSlider)
         {
-            UE_LOG(LogTemp, Display, TEXT("Current Global Volume: %f"), GlobalVolumeSlider->GetValue());
-            Settings->SetMasterSoundVolume(GlobalVolumeSlider->GetValue());
-
-            USoundClass* MasterSoundClass = LoadObject<USoundClass>(nullptr, TEXT("/Engine/EngineSounds/Master.Master"));
-
-            if (MasterSoundClass)
-            {
-                MasterSoundClass->Properties.Volume = GlobalVolumeSlider->GetValue();
-            }
+            SESSION_LOG(Verbose, TEXT("Current Global Volume: %f"), GlobalVolumeSlider->GetValue());
+            SettingsTransaction.SetMasterVolume(GlobalVolumeSlider->GetValue());
         }
     
         if(VersionText)
@@ -312,7 +473,7 @@ void UMenu::SaveGraphicsSettings()
 
                 if(Width > 0 && Height > 0)//if the Atoi string conversion fails one of them will be 0 
                 {
-                    Settings->SetScreenResolution(FIntPoint(Width, Height));
+                    SettingsTransaction.SetResolution(FIntPoint(Width, Height));
                 }
             }
         }
@@ -322,10 +483,10 @@ void UMenu::SaveGraphicsSettings()
             int32 WindowMode = FullScreenModeSelect->GetSelectedIndex();
             EWindowMode::Type FullScreenMode = EWindowMode::ConvertIntToWindowMode(WindowMode);
 
-            Settings->SetFullscreenMode(FullScreenMode);
+            SettingsTransaction.SetWindowMode(FullScreenMode);
         }
 
-        Settings->ApplySettings(false);
+        SettingsTransaction.Commit();//also applies a quality change that is still being debounced
     }
 }
 
@@ -335,6 +496,9 @@ void UMenu::SaveGraphicsSettings()
  */
 void UMenu::HostButtonClicked()
 {
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_HostButtonClicked);
+    SESSION_SPAN_BEGIN(Host);
+
     HostButton->SetIsEnabled(false);
     JoinButton->SetIsEnabled(false);
 
@@ -345,17 +509,73 @@ void UMenu::HostButtonClicked()
 
     if(MultiplayerSessionsSubsystem)
     {
-        MultiplayerSessionsSubsystem->DestroySession();//in case destroy a session if its alive
-        MultiplayerSessionsSubsystem->CreateSession(NumPublicConnections, MatchType);
+        MultiplayerSessionsSubsystem->CreateSession(NumPublicConnections, MatchType);//destroys a session that is still alive first
+    }
+
+    UHostTravelManager * HostTravelManager = GetGameInstance()->GetSubsystem<UHostTravelManager>();
+
+    if(HostTravelManager)
+    {
+        HostTravelManager->PrepareTravel(PathToLobby);//the lobby loads while the session is created and started
+    }
+}
+
+/**
+ * Called when the quick match button is clicked.
+ * The subsystem searches, joins the best session and hosts the selected map if nothing fits in time, clicking again cancels.
+ */
+void UMenu::QuickMatchButtonClicked()
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_QuickMatchButtonClicked);
+
+    if(!MultiplayerSessionsSubsystem || bIsJoining) return;
+
+    if(MultiplayerSessionsSubsystem->IsQuickMatchInProgress())
+    {
+        MultiplayerSessionsSubsystem->CancelQuickMatch();
+
+        return;
+    }
+
+    HostButton->SetIsEnabled(false);
+    JoinButton->SetIsEnabled(false);
+
+    if(MapSelect)
+    {
+        MatchType = MapSelect->GetSelectedOption();
+    }
+
+    FQuickMatchParams Params;
+    Params.Query = MakeSessionQuery();
+    Params.PreferredMatchType = MatchType;
+    Params.FallbackMatchType = MatchType;
+    Params.FallbackNumPublicConnections = NumPublicConnections;
+
+    MultiplayerSessionsSubsystem->QuickMatch(Params);
+}
+
+/**
+ * Callback function called when a quick match ended. Joining and hosting continue through OnJoinSession and OnCreateSession.
+ *
+ * @param Result How the quick match ended.
+ */
+void UMenu::OnQuickMatch(EQuickMatchResult::Type Result)
+{
+    if(Result == EQuickMatchResult::Failed || Result == EQuickMatchResult::Cancelled)
+    {
+        HostButton->SetIsEnabled(true);
+        JoinButton->SetIsEnabled(true);
     }
 }
 
 /**
  * Called when the join button is clicked.
- * It checks if the MultiplayerSessionsSubsystem is valid and calls the FindSessions function with a timeout of 10000 milliseconds.
+ * Lists the cached sessions immediately and asks the MultiplayerSessionsSubsystem to refresh them if they are stale.
  */
 void UMenu::JoinButtonClicked()
 {
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_JoinButtonClicked);
+
     // JoinButton->SetIsEnabled(false);
     if(bIsJoining)
     {
@@ -366,22 +586,33 @@ void UMenu::JoinButtonClicked()
     HostButton->SetIsEnabled(false);
     JoinText->SetText(FText::FromString("Cancel"));
 
+    bIsJoining = true;
+
+    SESSION_SPAN_BEGIN(Search);
+
     if(MultiplayerSessionsSubsystem)
     {
-        MultiplayerSessionsSubsystem->DestroySession();//in case destroy a session if its alive
-        MultiplayerSessionsSubsystem->FindSessions(10);//The size of the search results shouldn't really matter.  Epic's documentation for BuildUniqueId is Used to keep different builds from seeing each other during searches
-    }
+        ShowSessionTable();//whatever is cached (or already streamed by a speculative search) is listed right away
 
-    bIsJoining = true;
+        MultiplayerSessionsSubsystem->FindSessionsCached(MakeSessionQuery());//revalidates in the background when the cache is stale
+
+        if(AutoRefreshInterval > 0.f)
+        {
+            MultiplayerSessionsSubsystem->StartAutoRefresh(MakeSessionQuery(), AutoRefreshInterval);//keeps the open list live, updates arrive through OnSessionListUpdated
+        }
+    }
 }
 
 void UMenu::JoinCanceled()
 {
     bIsJoining = false;
 
-    if(MultiplayerSessionsSubsystem && MultiplayerSessionsSubsystem->GetSessionInterface())
+    SESSION_SPAN_CANCEL(Search);
+
+    if(MultiplayerSessionsSubsystem)
     {
-        MultiplayerSessionsSubsystem->GetSessionInterface()->CancelFindSessions();
+        MultiplayerSessionsSubsystem->StopAutoRefresh();
+        MultiplayerSessionsSubsystem->AbortSearch();//not CancelFindSessions on the interface, the search's completion delegate would stay bound
     }
 
     HostButton->SetIsEnabled(true);
@@ -397,6 +628,11 @@ void UMenu::MenuTearDown()
 {
     RemoveFromParent();
 
+    if(MultiplayerSessionsSubsystem)
+    {
+        MultiplayerSessionsSubsystem->StopAutoRefresh();
+    }
+
     UWorld * World = GetWorld();
 
     if(World)
@@ -418,6 +654,9 @@ void UMenu::MenuTearDown()
  */
 void UMenu::NativeDestruct()
 {
+	SettingsTransaction.Commit();//a quality click within the debounce delay is not lost
+	SettingsTransaction.OnCommitted.Unbind();
+
 	MenuTearDown();
  
 	Super::NativeDestruct();
@@ -430,15 +669,19 @@ void UMenu::NativeDestruct()
  */
 void UMenu::OnCreateSession(bool bWasSuccessful)
 {
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_OnCreateSession);
+
     if(bWasSuccessful)
     {
-        DebugHelper::PrintToLog("Session Created Successfully", FColor::Green);
+        SESSION_LOG(Display, TEXT("Session Created Successfully"));//the subsystem starts it right away, OnStartSession travels
 
-        MultiplayerSessionsSubsystem->StartSession();
+        SESSION_SPAN_MARK(Host, STAT_HostToCreatedMs);
     }
     else
     {
-        DebugHelper::PrintToLog("Session Creation Failed", FColor::Red);
+        SESSION_LOG(Error, TEXT("Session Creation Failed"));
+
+        SESSION_SPAN_CANCEL(Host);
 
         HostButton->SetIsEnabled(true);
         JoinButton->SetIsEnabled(true);
@@ -447,91 +690,324 @@ void UMenu::OnCreateSession(bool bWasSuccessful)
 
 /**
  * Callback function called when finding sessions is completed.
+ * If the list already shows every row of the current session table (streamed in through OnFindSessionsBatch or served from the cache)
+ * it is left as is, otherwise it is rebuilt.
  *
  * @param SessionResults The array of session search results.
  * @param bWasSuccessful Indicates whether the session search was successful or not.
  */
 void UMenu::OnFindSessions(const TArray<FOnlineSessionSearchResult> & SessionResults, bool bWasSuccessful)
 {
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_OnFindSessions);
+
+    if(MultiplayerSessionsSubsystem == nullptr || !bIsJoining) return;//speculative searches only fill the cache
+
+    const FSessionDescriptorTable & Table = MultiplayerSessionsSubsystem->GetSessionTable();
+
+    if(ListedGeneration != Table.GetGeneration() || ListedItemsByRow.Num() != Table.Num())
+    {
+        ShowSessionTable();
+    }
+
+    if(!bWasSuccessful && !MultiplayerSessionsSubsystem->IsAutoRefreshEnabled())//an auto refreshing list stays open and retries
+    {
+        // JoinButton->SetIsEnabled(true);
+        HostButton->SetIsEnabled(true);
+        JoinText->SetText(FText::FromString("Search"));
+    }
+}
+
+/**
+ * Callback function called while a search is running, with the results that arrived since the previous batch.
+ *
+ * @param NewResults The newly found sessions.
+ * @param FirstResultIndex Index of the first new result in the complete result set.
+ */
+void UMenu::OnFindSessionsBatch(TArrayView<const FOnlineSessionSearchResult> NewResults, int32 FirstResultIndex)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_OnFindSessionsBatch);
+    SESSION_LLM_SCOPE(Widgets);
+
+    if(MultiplayerSessionsSubsystem == nullptr || !bIsJoining) return;
+
+    const FSessionDescriptorTable & Table = MultiplayerSessionsSubsystem->GetSessionTable();
+
+    if(ListedGeneration != Table.GetGeneration())//first batch of a new search
+    {
+        ClearServerList();
+        ListedGeneration = Table.GetGeneration();
+    }
+
+    if(FirstResultIndex != ListedItemsByRow.Num()) return;//out of order batch, OnFindSessions will rebuild the list
+
+    for (int32 Index = FirstResultIndex; Index < FirstResultIndex + NewResults.Num(); ++Index)
+    {
+        AddServerListEntry(Table.MakeHandle(Index));
+    }
+
+    ShowVisibleServerListRows();
+}
+
+/**
+ * Callback function called when a refresh replaced the session table.
+ * Existing items are re-pointed to their new rows and kept, so only added and dropped sessions create or release items
+ * and only the visible rows that actually changed are redrawn.
+ *
+ * @param Diff What changed between the listed table and the new one.
+ */
+void UMenu::OnSessionListUpdated(const FSessionTableDiff & Diff)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_OnSessionListUpdated);
+    SESSION_LLM_SCOPE(Widgets);
+
+    if(MultiplayerSessionsSubsystem == nullptr || !bIsJoining) return;
+
+    const FSessionDescriptorTable & Table = MultiplayerSessionsSubsystem->GetSessionTable();
+
+    if(Diff.PreviousGeneration != ListedGeneration)//the list does not show the table the diff is based on
+    {
+        ShowSessionTable();
+
+        return;
+    }
+
+    TArray<UListViewEntry *> PreviousItemsByRow = MoveTemp(ListedItemsByRow);
+    ListedItemsByRow.Reset(Table.Num());
+
+    for (int32 PreviousRow : Diff.Dropped)
+    {
+        UListViewEntry * Item = PreviousItemsByRow.IsValidIndex(PreviousRow) ? PreviousItemsByRow[PreviousRow] : nullptr;
+
+        if(Item)
+        {
+            ServerListItemPool.Add(Item);//leaves the list with the next ShowVisibleServerListRows
+        }
+    }
+
+    for (int32 Row = 0; Row < Table.Num(); ++Row)
+    {
+        const int32 PreviousRow = Diff.PreviousRows[Row];
+
+        if(!PreviousItemsByRow.IsValidIndex(PreviousRow))//a new session
+        {
+            AddServerListEntry(Table.MakeHandle(Row));
+
+            continue;
+        }
+
+        UListViewEntry * Item = PreviousItemsByRow[PreviousRow];
+
+        if(Item)
+        {
+            Item->SetSessionHandle(Table.MakeHandle(Row));
+        }
+
+        ListedItemsByRow.Add(Item);
+    }
+
+    ListedGeneration = Table.GetGeneration();
+
+    ShowVisibleServerListRows();
+
+    for (int32 Row : Diff.Changed)
+    {
+        RefreshServerListRow(Row);
+    }
+
+    for (int32 Row : Diff.Removed)
+    {
+        RefreshServerListRow(Row);
+    }
+}
+
+/**
+ * Callback function called when the measured pings of the listed sessions arrived.
+ */
+void UMenu::OnSessionQosUpdated()
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_OnSessionQosUpdated);
+
+    if(MultiplayerSessionsSubsystem == nullptr || !bIsJoining) return;
+
+    if(ListedGeneration != MultiplayerSessionsSubsystem->GetSessionTable().GetGeneration()) return;//OnFindSessions lists the new table sorted anyway
+
+    ShowVisibleServerListRows(true);//visible rows show the new pings
+}
+
+/**
+ * Pushes the state of the filter and sort widgets to the subsystem's filter engine.
+ * Only the predicates that actually changed are evaluated again, the list is only updated if anything changed.
+ */
+void UMenu::ApplyServerListFilters()
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_ApplyServerListFilters);
+
     if(MultiplayerSessionsSubsystem == nullptr) return;
 
-    if(ServerList)
+    FSessionFilterEngine & Filter = MultiplayerSessionsSubsystem->GetSessionFilter();
+
+    bool bChanged = false;
+
+    const int32 MapIndex = MapFilterSelect ? MapFilterSelect->GetSelectedIndex() : 0;
+    bChanged |= Filter.SetMapFilter(MapIndex > 0 ? MapFilterSelect->GetSelectedOption() : FString());//index 0 is "Any"
+
+    bChanged |= Filter.SetMinOpenSlots(MinOpenSlotsFilter ? FMath::RoundToInt(MinOpenSlotsFilter->GetValue()) : 0);
+    bChanged |= Filter.SetHostNameFilter(HostNameFilterText ? HostNameFilterText->GetText().ToString() : FString());
+
+    const int32 SortIndex = ServerSortSelect ? ServerSortSelect->GetSelectedIndex() : 0;
+    const ESessionSortKey::Type SortKey = SortIndex > 0 && SortIndex < ESessionSortKey::Num ? (ESessionSortKey::Type)SortIndex : ESessionSortKey::Latency;
+    bChanged |= Filter.SetSortKey(SortKey, SortKey == ESessionSortKey::OpenSlots);//emptiest servers first
+
+    if(bChanged && bIsJoining && ListedGeneration == MultiplayerSessionsSubsystem->GetSessionTable().GetGeneration())
     {
-        ServerList->ClearChildren();
+        ShowVisibleServerListRows();
     }
+}
 
-	for (auto Result : SessionResults)
-	{
-        if(!bIsJoining) return;
+void UMenu::ServerListSelectionFilterChanged(FString SelectedItem, ESelectInfo::Type SelectionType)
+{
+    ApplyServerListFilters();
+}
 
-        // MultiplayerSessionsSubsystem->JoinSession(Result);
+void UMenu::ServerListTextFilterChanged(const FText & Text)
+{
+    ApplyServerListFilters();
+}
 
-        FString Id = Result.GetSessionIdStr();
-        FString UserName = Result.Session.OwningUserName;
-        FString SettingsValue;
-        FString GameType;
+void UMenu::ServerListValueFilterChanged(float Value)
+{
+    ApplyServerListFilters();
+}
 
-        Result.Session.SessionSettings.Get(FName("MatchType"), SettingsValue);
-        Result.Session.SessionSettings.Get(FName("GameType"), GameType);
+/**
+ * Hands the listed items of the rows that pass the filters to the list view, in the order of the filter engine.
+ * Items are reused, only the list's item array changes and the list view regenerates the widgets of the visible rows.
+ *
+ * @param bRedrawRows Redraws the entry widgets that stay visible too, for when the values of the rows changed.
+ */
+void UMenu::ShowVisibleServerListRows(bool bRedrawRows)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_ShowVisibleServerListRows);
+    SESSION_LLM_SCOPE(Widgets);
+
+    if(!ServerList || MultiplayerSessionsSubsystem == nullptr) return;
 
-        DebugHelper::PrintToLog(FString::Printf(TEXT("Session %s - %s | Map: %s"), *Id, *UserName, *SettingsValue), FColor::Green);
+    TArray<int32> Rows;
+    MultiplayerSessionsSubsystem->GetSessionFilter().GetVisibleRows(Rows);
 
-        if(ServerList && GameType == FString("DeathEcho"))
+    TArray<UListViewEntry *> VisibleItems;
+    VisibleItems.Reserve(Rows.Num());
+
+    for (int32 Row : Rows)
+    {
+        if(ListedItemsByRow.IsValidIndex(Row) && ListedItemsByRow[Row])//rows that did not match the query or were not listed yet have no item
         {
-            //create a new widget 
-            if(ListEntryWidget)
-            {
-                UWorld* World = GetWorld();
-                if (World)
-                {
-                    UListViewEntryWidget * NewWidget = CreateWidget<UListViewEntryWidget>(World, ListEntryWidget);
-                    if (NewWidget)
-                    {
-                        
-                        //from NewWidget get a reference to the ServerTitle Text Block widget and change the server title
-                        UTextBlock * ServerTitle = Cast<UTextBlock>(NewWidget->GetWidgetFromName("ServerTitle"));
-
-                        if(ServerTitle)
-                        {
-                            ServerTitle->SetText(FText::FromString(FString::Printf(TEXT("Server: %s | Map: %s"),*UserName, *SettingsValue)));
-                        }
-
-                        NewWidget->Session = Result;
-
-                        UButton * ServerJoinButton = Cast<UButton>(NewWidget->GetWidgetFromName("JoinButton"));
-
-                        if(ServerJoinButton)
-                        {
-                            ServerJoinButton->SetToolTipText(FText::FromString(Id));
-                        }
-
-                        //add the new widget to ServerList StackBox
-                        ServerList->AddChild(NewWidget);
-                    }
-                }
-            }
+            VisibleItems.Add(ListedItemsByRow[Row]);
         }
-	}
+    }
+
+    ServerList->SetListItems(VisibleItems);
 
-    if(!bWasSuccessful)
+    if(VisibleItems.Num() > 0)
     {
-        // JoinButton->SetIsEnabled(true);
-        HostButton->SetIsEnabled(true);
-        JoinText->SetText(FText::FromString("Search"));
+        SESSION_SPAN_END(Search, STAT_SearchToFirstRowMs);
+    }
+
+    if(bRedrawRows)
+    {
+        ServerList->RegenerateAllEntries();
     }
 }
 
-void UMenu::JoinSession(FOnlineSessionSearchResult Session)
+/**
+ * Redraws the entry widget of a row if the row is currently visible.
+ *
+ * @param Row The session table row.
+ */
+void UMenu::RefreshServerListRow(int32 Row)
 {
-    FString Id = Session.GetSessionIdStr();
-    FString UserName = Session.Session.OwningUserName;
-    FString SettingsValue;
+    UListViewEntry * Item = ListedItemsByRow.IsValidIndex(Row) ? ListedItemsByRow[Row] : nullptr;
 
-    Session.Session.SessionSettings.Get(FName("MatchType"), SettingsValue);
+    if(!Item || !ServerList) return;
 
-    DebugHelper::PrintToLog(FString::Printf(TEXT("Session %s - %s | Map: %s"), *Id, *UserName, *SettingsValue), FColor::Green);
+    if(UListViewEntryWidget * EntryWidget = ServerList->GetEntryWidgetFromItem<UListViewEntryWidget>(Item))//only visible rows have a widget
+    {
+        EntryWidget->UpdateRow();
+    }
+}
+
+/**
+ * Creates the item for the given session, rows must be added in table order. ShowVisibleServerListRows puts the items into the list.
+ * Only an item object is created (or taken from the pool), the list view creates entry widgets for the visible rows only.
+ * Rows that do not satisfy the search query are skipped, for backends that do not filter on every query setting.
+ *
+ * @param Handle Handle of the session in the subsystem's session table.
+ */
+void UMenu::AddServerListEntry(FSessionHandle Handle)
+{
+    const FSessionDescriptorTable & Table = MultiplayerSessionsSubsystem->GetSessionTable();
+
+    if(!ServerList || !Table.IsValid(Handle) || !MultiplayerSessionsSubsystem->GetSessionTableQuery().Matches(Table, Handle.Index))
+    {
+        ListedItemsByRow.Add(nullptr);
+
+        return;
+    }
 
-    MultiplayerSessionsSubsystem->JoinSession(Session);//add the join session complete delegate
+    UListViewEntry * Item = AcquireServerListItem();
+    Item->SetSessionHandle(Handle);
+
+    ListedItemsByRow.Add(Item);
+}
+
+UListViewEntry * UMenu::AcquireServerListItem()
+{
+    SESSION_LLM_SCOPE(Widgets);
+
+    return ServerListItemPool.Num() > 0 ? ServerListItemPool.Pop() : NewObject<UListViewEntry>(this);
+}
+
+/**
+ * Removes every row from the server list, the item objects stay in the pool for the next search.
+ */
+void UMenu::ClearServerList()
+{
+    if(ServerList)
+    {
+        ServerList->ClearListItems();
+    }
+
+    for (UListViewEntry * Item : ListedItemsByRow)
+    {
+        if(Item)
+        {
+            ServerListItemPool.Add(Item);
+        }
+    }
+
+    ListedItemsByRow.Reset();
+}
+
+/**
+ * Rebuilds the server list from every row of the subsystem's current session table, filtered and sorted by the filter engine.
+ */
+void UMenu::ShowSessionTable()
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_ShowSessionTable);
+    SESSION_LLM_SCOPE(Widgets);
+
+    ClearServerList();
+
+    const FSessionDescriptorTable & Table = MultiplayerSessionsSubsystem->GetSessionTable();
+
+    for (int32 Index = 0; Index < Table.Num(); ++Index)
+    {
+        AddServerListEntry(Table.MakeHandle(Index));
+    }
+
+    ListedGeneration = Table.GetGeneration();
+
+    ShowVisibleServerListRows();
 }
 
 /**
@@ -541,11 +1017,11 @@ void UMenu::JoinSession(FOnlineSessionSearchResult Session)
  */
 void UMenu::OnJoinSession(EOnJoinSessionCompleteResult::Type Result)
 {
-    IOnlineSubsystem * Subsystem = IOnlineSubsystem::Get();
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_OnJoinSession);
 
-    if(Subsystem)
+    if(MultiplayerSessionsSubsystem)
     {
-        IOnlineSessionPtr SessionInterface = Subsystem->GetSessionInterface();
+        IOnlineSessionPtr SessionInterface = MultiplayerSessionsSubsystem->GetSessionInterface();//the subsystem's, which may be the synthetic backend
 
         if(SessionInterface.IsValid())
         {
@@ -556,6 +1032,8 @@ void UMenu::OnJoinSession(EOnJoinSessionCompleteResult::Type Result)
 
             if(PlayerController)
             {
+                SESSION_SPAN_END(Join, STAT_JoinToTravelMs);
+
                 PlayerController->ClientTravel(Address, ETravelType::TRAVEL_Absolute);
             }        
         }
@@ -563,6 +1041,8 @@ void UMenu::OnJoinSession(EOnJoinSessionCompleteResult::Type Result)
 
     if(Result != EOnJoinSessionCompleteResult::Success)
     {
+        SESSION_SPAN_CANCEL(Join);
+
         // JoinButton->SetIsEnabled(true);
         HostButton->SetIsEnabled(true);
         JoinText->SetText(FText::FromString("Search"));
@@ -578,7 +1058,16 @@ void UMenu::OnJoinSession(EOnJoinSessionCompleteResult::Type Result)
  */
 void UMenu::OnDestroySession(bool bWasSuccessful)
 {
-    bWasSuccessful ? DebugHelper::PrintToLog("Session Destroyed Successfully", FColor::Green) : DebugHelper::PrintToLog("Session Destroy Failed", FColor::Red);
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_OnDestroySession);
+
+    if(bWasSuccessful)
+    {
+        SESSION_LOG(Display, TEXT("Session Destroyed Successfully"));
+    }
+    else
+    {
+        SESSION_LOG(Error, TEXT("Session Destroy Failed"));
+    }
 }
 
 /**
@@ -588,13 +1077,25 @@ void UMenu::OnDestroySession(bool bWasSuccessful)
  */
 void UMenu::OnStartSession(bool bWasSuccessful)
 {
-    bWasSuccessful ? DebugHelper::PrintToLog("Session Started Successfully", FColor::Green) : DebugHelper::PrintToLog("Session Start Failed", FColor::Red);
+    SESSION_SCOPE_CYCLE_COUNTER(Menu_OnStartSession);
 
-    UWorld * World = GetWorld();
+    if(bWasSuccessful)
+    {
+        SESSION_LOG(Display, TEXT("Session Started Successfully"));
+    }
+    else
+    {
+        SESSION_LOG(Error, TEXT("Session Start Failed"));
+    }
 
-    if(World)
+    SESSION_SPAN_MARK(Host, STAT_HostToStartedMs);
+
+    UHostTravelManager * HostTravelManager = GetGameInstance()->GetSubsystem<UHostTravelManager>();
+
+    if(HostTravelManager)
     {
-        // World->ServerTravel("/Game/Maps/Arena_2?listen");//this should be the lobby level
-        World->ServerTravel(PathToLobby);
+        SESSION_SPAN_END(Host, STAT_HostToTravelMs);
+
+        HostTravelManager->HostLobby(PathToLobby);//hard travel into the listen server, the lobby travels on to the match seamlessly
     }
 }
\ No newline at end of file
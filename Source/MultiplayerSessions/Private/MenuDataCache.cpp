@@ -0,0 +1,145 @@
+#include "MenuDataCache.h"
+#include "Sound/SoundClass.h"
+#include "Kismet/KismetSystemLibrary.h"
+#include "SessionLog.h"
+#include "SessionStats.h"
+
+namespace MenuData
+{
+    static const FSoftObjectPath MasterSoundClassPath(TEXT("/Engine/EngineSounds/Master.Master"));
+}
+
+/**
+ * A dedicated server never opens the menu.
+ */
+bool UMenuDataCache::ShouldCreateSubsystem(UObject * Outer) const
+{
+    return !IsRunningDedicatedServer() && Super::ShouldCreateSubsystem(Outer);
+}
+
+/**
+ * Starts the async load of the master sound class and defers the resolution enumeration to the first tick,
+ * so neither runs inside the game instance's init or a widget's Initialize.
+ */
+void UMenuDataCache::Initialize(FSubsystemCollectionBase & Collection)
+{
+    Super::Initialize(Collection);
+
+    SESSION_LLM_SCOPE(Widgets);
+
+    MasterSoundClassHandle = Streamable.RequestAsyncLoad(MenuData::MasterSoundClassPath, FStreamableDelegate::CreateUObject(this, &ThisClass::OnMasterSoundClassLoaded));
+
+    if(!MasterSoundClassHandle.IsValid())//the request failed right away, the delegate is not called
+    {
+        OnMasterSoundClassLoaded();
+    }
+
+    ResolutionTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::EnumerateResolutions));
+}
+
+void UMenuDataCache::Deinitialize()
+{
+    FTSTicker::GetCoreTicker().RemoveTicker(ResolutionTickerHandle);
+    ResolutionTickerHandle.Reset();
+
+    if(MasterSoundClassHandle.IsValid())
+    {
+        MasterSoundClassHandle->CancelHandle();
+        MasterSoundClassHandle.Reset();
+    }
+
+    PendingRequests.Reset();
+
+    Super::Deinitialize();
+}
+
+/**
+ * @param OnReady Called with the prepared data, bind it to the requesting widget so it is dropped when the widget goes away.
+ */
+void UMenuDataCache::RequestMenuData(FOnMenuDataReady && OnReady)
+{
+    if(IsReady())
+    {
+        OnReady.ExecuteIfBound(*this);
+        return;
+    }
+
+    PendingRequests.Add(MoveTemp(OnReady));
+}
+
+/**
+ * @param Volume The master volume, 0 to 1.
+ */
+void UMenuDataCache::SetMasterVolume(float Volume)
+{
+    MasterVolume = Volume;
+
+    if(MasterSoundClass)
+    {
+        MasterSoundClass->Properties.Volume = Volume;
+    }
+}
+
+FString UMenuDataCache::FormatResolution(FIntPoint Resolution)
+{
+    return FString::Printf(TEXT("%dx%d"), Resolution.X, Resolution.Y);
+}
+
+void UMenuDataCache::OnMasterSoundClassLoaded()
+{
+    MasterSoundClass = Cast<USoundClass>(MenuData::MasterSoundClassPath.ResolveObject());
+    bMasterSoundClassResolved = true;
+
+    if(MasterSoundClass)
+    {
+        if(MasterVolume.IsSet())
+        {
+            MasterSoundClass->Properties.Volume = MasterVolume.GetValue();//set by a menu before the load finished
+        }
+    }
+    else
+    {
+        SESSION_LOG(Warning, TEXT("Master sound class %s could not be loaded"), *MenuData::MasterSoundClassPath.ToString());
+    }
+
+    NotifyIfReady();
+}
+
+/**
+ * Runs once, on the first tick after the game instance started. The supported resolutions do not change while the game runs.
+ */
+bool UMenuDataCache::EnumerateResolutions(float DeltaTime)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(MenuData_EnumerateResolutions);
+    SESSION_LLM_SCOPE(Widgets);
+
+    TArray<FIntPoint> SupportedResolutions;
+
+    UKismetSystemLibrary::GetSupportedFullscreenResolutions(SupportedResolutions);
+
+    ResolutionOptions.Reset(SupportedResolutions.Num());
+
+    for(const FIntPoint & Resolution : SupportedResolutions)
+    {
+        ResolutionOptions.Add(FormatResolution(Resolution));
+    }
+
+    bResolutionsEnumerated = true;
+    ResolutionTickerHandle.Reset();
+
+    NotifyIfReady();
+
+    return false;//removes the ticker
+}
+
+void UMenuDataCache::NotifyIfReady()
+{
+    if(!IsReady()) return;
+
+    TArray<FOnMenuDataReady> Requests = MoveTemp(PendingRequests);
+
+    for(FOnMenuDataReady & Request : Requests)
+    {
+        Request.ExecuteIfBound(*this);
+    }
+}
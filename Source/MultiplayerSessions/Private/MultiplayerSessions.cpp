@@ -1,18 +1,24 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "MultiplayerSessions.h"
+#include "SessionLog.h"
+#include "Misc/CoreDelegates.h"
 
 #define LOCTEXT_NAMESPACE "FMultiplayerSessionsModule"
 
 void FMultiplayerSessionsModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+#if MULTIPLAYERSESSIONS_LOGGING
+	SystemErrorHandle = FCoreDelegates::OnHandleSystemError.AddStatic(&SessionLog::DumpRecentEvents);//the crash log ends with the last session events
+#endif
 }
 
 void FMultiplayerSessionsModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	FCoreDelegates::OnHandleSystemError.Remove(SystemErrorHandle);
 }
 
 #undef LOCTEXT_NAMESPACE
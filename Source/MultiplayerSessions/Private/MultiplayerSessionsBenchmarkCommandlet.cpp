@@ -0,0 +1,385 @@
+#include "MultiplayerSessionsBenchmarkCommandlet.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "Menu.h"
+#include "SessionQuery.h"
+#include "SessionSettingsSchema.h"
+#include "SessionLog.h"
+#include "OnlineSessionSettings.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Blueprint/UserWidget.h"
+#include "Components/ListView.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTLS.h"
+
+namespace SessionBenchmark
+{
+    /**
+     * Forwards everything to the allocator it wraps and counts the allocations made on the thread that installed it.
+     * Installed as GMalloc only around the measured calls.
+     */
+    class FCountingMalloc : public FMalloc
+    {
+    public:
+        explicit FCountingMalloc(FMalloc * InInner) : Inner(InInner), OwnerThreadId(FPlatformTLS::GetCurrentThreadId()) {}
+
+        virtual void * Malloc(SIZE_T Count, uint32 Alignment) override { Track(Count); return Inner->Malloc(Count, Alignment); }
+        virtual void * TryMalloc(SIZE_T Count, uint32 Alignment) override { Track(Count); return Inner->TryMalloc(Count, Alignment); }
+        virtual void * Realloc(void * Original, SIZE_T Count, uint32 Alignment) override { Track(Count); return Inner->Realloc(Original, Count, Alignment); }
+        virtual void * TryRealloc(void * Original, SIZE_T Count, uint32 Alignment) override { Track(Count); return Inner->TryRealloc(Original, Count, Alignment); }
+        virtual void Free(void * Original) override { Inner->Free(Original); }
+        virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+        virtual bool GetAllocationSize(void * Original, SIZE_T & SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+        virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+        virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+        virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+        virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+        virtual const TCHAR * GetDescriptiveName() override { return TEXT("SessionBenchmarkCountingMalloc"); }
+
+        void Reset() { Allocations = 0; AllocatedBytes = 0; }
+
+        uint64 Allocations = 0;
+        uint64 AllocatedBytes = 0;
+
+    private:
+        void Track(SIZE_T Count)
+        {
+            if(FPlatformTLS::GetCurrentThreadId() != OwnerThreadId) return;
+
+            ++Allocations;
+            AllocatedBytes += Count;
+        }
+
+        FMalloc * Inner;
+        uint32 OwnerThreadId;
+    };
+
+    struct FResult
+    {
+        int32 Sessions = 0;
+        TArray<double> Milliseconds;
+        TArray<uint64> Allocations;
+        uint64 AllocatedBytes = 0;
+        int32 ListedRows = 0;
+        TArray<FString> Failures;
+
+        double MedianMs() const
+        {
+            TArray<double> Sorted = Milliseconds;
+            Sorted.Sort();
+
+            return Sorted.Num() > 0 ? Sorted[Sorted.Num() / 2] : 0.0;
+        }
+
+        uint64 MedianAllocations() const
+        {
+            TArray<uint64> Sorted = Allocations;
+            Sorted.Sort();
+
+            return Sorted.Num() > 0 ? Sorted[Sorted.Num() / 2] : 0;
+        }
+    };
+
+    // The plugin's menu, its ServerList is the list view the rows are built for
+    static constexpr const TCHAR * DefaultMenuClass = TEXT("/MultiplayerSessions/WBP_Menu.WBP_Menu_C");
+
+    // Coarse ceilings that hold without a baseline, the baseline catches the smaller regressions.
+    // They include handing every listed row to the server list (a pooled item per row and the list's item array),
+    // tighten them from the first baseline of a run that lists rows.
+    static double GetBudgetMs(int32 Sessions) { return 2.0 + 0.08 * Sessions; }
+    static uint64 GetBudgetAllocations(int32 Sessions) { return 512 + 96 * (uint64)Sessions; }
+
+    /**
+     * Builds a result set that looks like what a backend returns for FSessionQuery::Default: every 8th session is full (never the first),
+     * hosts, maps and pings vary so sorting and filtering have work to do.
+     *
+     * @param Count The number of sessions.
+     * @return The search results.
+     */
+    static TArray<FOnlineSessionSearchResult> MakeResults(int32 Count)
+    {
+        static const TCHAR * Maps[] = { TEXT("D_ShootingRange"), TEXT("Arena_2"), TEXT("Canyon"), TEXT("Harbor") };
+
+        TArray<FOnlineSessionSearchResult> Results;
+        Results.SetNum(Count);
+
+        for(int32 Index = 0; Index < Count; ++Index)
+        {
+            FOnlineSessionSearchResult & Result = Results[Index];
+            FOnlineSessionSettings & Settings = Result.Session.SessionSettings;
+
+            Result.PingInMs = 15 + (Index * 37) % 220;
+            Result.Session.OwningUserName = FString::Printf(TEXT("Host_%05d"), (Index * 7919) % 100000);
+            Result.Session.NumOpenPublicConnections = Index % 8 == 7 ? 0 : 8 - Index % 8;//a single session is listed too
+
+            Settings.NumPublicConnections = 8;
+            SessionSchema::Set<SessionSchema::FMatchType>(Settings, FString(Maps[Index % UE_ARRAY_COUNT(Maps)]));
+            SessionSchema::Set<SessionSchema::FGameType>(Settings, FString(UMultiplayerSessionsSubsystem::SessionGameType));
+            SessionSchema::Set<SessionSchema::FBuildId>(Settings, UMultiplayerSessionsSubsystem::SessionBuildId);
+        }
+
+        return Results;
+    }
+
+    /**
+     * Compares a result against the built-in budgets and the same result set of a baseline run.
+     *
+     * @param Result The result, failures are added to it.
+     * @param Baseline The results of the baseline run, may be null.
+     * @param Tolerance Allowed growth over the baseline, 0.25 allows 25%.
+     */
+    static void CheckThresholds(FResult & Result, const TArray<TSharedPtr<FJsonValue>> * Baseline, double Tolerance)
+    {
+        const double MedianMs = Result.MedianMs();
+        const uint64 Allocations = Result.MedianAllocations();
+
+        if(MedianMs > GetBudgetMs(Result.Sessions))
+        {
+            Result.Failures.Add(FString::Printf(TEXT("%.3f ms is over the budget of %.3f ms"), MedianMs, GetBudgetMs(Result.Sessions)));
+        }
+
+        if(Allocations > GetBudgetAllocations(Result.Sessions))
+        {
+            Result.Failures.Add(FString::Printf(TEXT("%llu allocations are over the budget of %llu"), Allocations, GetBudgetAllocations(Result.Sessions)));
+        }
+
+        if(!Baseline) return;
+
+        for(const TSharedPtr<FJsonValue> & Value : *Baseline)
+        {
+            const TSharedPtr<FJsonObject> * Entry = nullptr;
+
+            if(!Value->TryGetObject(Entry) || (*Entry)->GetIntegerField(TEXT("Sessions")) != Result.Sessions) continue;
+
+            const double BaselineMs = (*Entry)->GetNumberField(TEXT("MedianMs"));
+            const double BaselineAllocations = (*Entry)->GetNumberField(TEXT("Allocations"));
+
+            if(MedianMs > BaselineMs * (1.0 + Tolerance))
+            {
+                Result.Failures.Add(FString::Printf(TEXT("%.3f ms regressed from the baseline's %.3f ms"), MedianMs, BaselineMs));
+            }
+
+            if(Allocations > BaselineAllocations * (1.0 + Tolerance))
+            {
+                Result.Failures.Add(FString::Printf(TEXT("%llu allocations regressed from the baseline's %.0f"), Allocations, BaselineAllocations));
+            }
+        }
+    }
+}
+
+UMultiplayerSessionsBenchmarkCommandlet::UMultiplayerSessionsBenchmarkCommandlet()
+{
+    IsClient = true;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UMultiplayerSessionsBenchmarkCommandlet::Main(const FString & Params)
+{
+    using namespace SessionBenchmark;
+
+    FString SizesString = TEXT("1,100,1000,10000");
+    FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks/MultiplayerSessions.json");
+    FString BaselinePath;
+    FString MenuClassPath = DefaultMenuClass;
+    int32 Iterations = 10;
+    double Tolerance = 0.25;
+
+    FParse::Value(*Params, TEXT("Sizes="), SizesString);
+    FParse::Value(*Params, TEXT("Output="), OutputPath);
+    FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+    FParse::Value(*Params, TEXT("MenuClass="), MenuClassPath);
+    FParse::Value(*Params, TEXT("Iterations="), Iterations);
+    FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+
+    Iterations = FMath::Max(Iterations, 1);
+
+    TArray<FString> SizeStrings;
+    SizesString.ParseIntoArray(SizeStrings, TEXT(","));
+
+    TSharedPtr<FJsonObject> BaselineJson;
+    const TArray<TSharedPtr<FJsonValue>> * BaselineResults = nullptr;
+
+    if(!BaselinePath.IsEmpty())
+    {
+        FString BaselineText;
+
+        if(!FFileHelper::LoadFileToString(BaselineText, *BaselinePath) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineText), BaselineJson) || !BaselineJson.IsValid())
+        {
+            SESSION_LOG(Error, TEXT("Could not read the baseline %s"), *BaselinePath);
+
+            return 1;
+        }
+
+        BaselineJson->TryGetArrayField(TEXT("Results"), BaselineResults);
+    }
+
+    // A standalone game instance gives the subsystem and the menu a world without a viewport
+    UGameInstance * GameInstance = NewObject<UGameInstance>(GEngine);
+    GameInstance->InitializeStandalone();
+
+    UMultiplayerSessionsSubsystem * Subsystem = GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>();
+
+    if(!Subsystem || !Subsystem->GetSessionInterface().IsValid())
+    {
+        SESSION_LOG(Error, TEXT("No session interface, run with -ini:Engine:[OnlineSubsystem]:DefaultPlatformService=Null"));
+
+        GameInstance->Shutdown();
+
+        return 1;
+    }
+
+    Subsystem->bStreamSearchResults = false;
+
+    TSubclassOf<UMenu> MenuClass = LoadClass<UMenu>(nullptr, *MenuClassPath);
+
+    if(!MenuClass)
+    {
+        SESSION_LOG(Error, TEXT("Could not load the menu class %s"), *MenuClassPath);
+
+        GameInstance->Shutdown();
+
+        return 1;
+    }
+
+    UMenu * Menu = CreateWidget<UMenu>(GameInstance, MenuClass);
+
+    if(!Menu || !Menu->ServerList)//the bare UMenu has no widget tree, nothing of the server list would be measured
+    {
+        SESSION_LOG(Error, TEXT("%s has no ListView named ServerList, pass the class of a menu that has one with -MenuClass="), *MenuClassPath);
+
+        GameInstance->Shutdown();
+
+        return 1;
+    }
+
+    Menu->MultiplayerSessionsSubsystem = Subsystem;//bound like SetupMultiplayerSubsystem does, without the viewport and the speculative search
+    Menu->bIsJoining = true;
+    Subsystem->MultiplayerOnFindSessionsComplete.AddUObject(Menu, &UMenu::OnFindSessions);
+
+    FCountingMalloc CountingMalloc(GMalloc);
+    FMalloc * const OriginalMalloc = GMalloc;
+
+    TArray<FResult> Results;
+    bool bPassed = true;
+
+    for(const FString & SizeString : SizeStrings)
+    {
+        FResult & Result = Results.AddDefaulted_GetRef();
+        Result.Sessions = FCString::Atoi(*SizeString);
+
+        const TArray<FOnlineSessionSearchResult> Template = MakeResults(Result.Sessions);
+        const FSessionQuery Query = FSessionQuery::Default().WithMaxResults(Result.Sessions).WithMinOpenSlots(1);
+
+        for(int32 Iteration = -1; Iteration < Iterations; ++Iteration)//the first run warms the pools and is not recorded
+        {
+            TArray<FOnlineSessionSearchResult> SearchResults = Template;
+
+            CountingMalloc.Reset();
+            GMalloc = &CountingMalloc;
+
+            const double StartTime = FPlatformTime::Seconds();
+
+            Subsystem->InjectSearchResults(MoveTemp(SearchResults), Query);
+
+            const double EndTime = FPlatformTime::Seconds();
+
+            GMalloc = OriginalMalloc;
+
+            if(Iteration < 0) continue;
+
+            Result.Milliseconds.Add((EndTime - StartTime) * 1000.0);
+            Result.Allocations.Add(CountingMalloc.Allocations);
+            Result.AllocatedBytes = CountingMalloc.AllocatedBytes;
+        }
+
+        Result.ListedRows = Menu->ServerList->GetNumItems();//what the list view was handed, not just what the menu prepared
+
+        if(Result.Sessions > 0 && Result.ListedRows == 0)
+        {
+            Result.Failures.Add(TEXT("No rows reached the server list, the measurement does not cover it"));
+        }
+
+        CheckThresholds(Result, BaselineResults, Tolerance);
+
+        bPassed &= Result.Failures.Num() == 0;
+
+        SESSION_LOG(Display, TEXT("%6d sessions: %8.3f ms, %6llu allocations, %d rows listed%s"),
+            Result.Sessions, Result.MedianMs(), Result.MedianAllocations(), Result.ListedRows, Result.Failures.Num() > 0 ? TEXT(" FAILED") : TEXT(""));
+
+        for(const FString & Failure : Result.Failures)
+        {
+            SESSION_LOG(Error, TEXT("    %s"), *Failure);
+        }
+    }
+
+    // JSON report
+    TArray<TSharedPtr<FJsonValue>> ResultValues;
+
+    for(const FResult & Result : Results)
+    {
+        TSharedRef<FJsonObject> Entry = MakeShared<FJsonObject>();
+        TArray<double> Sorted = Result.Milliseconds;
+        Sorted.Sort();
+
+        Entry->SetNumberField(TEXT("Sessions"), Result.Sessions);
+        Entry->SetNumberField(TEXT("MedianMs"), Result.MedianMs());
+        Entry->SetNumberField(TEXT("MinMs"), Sorted.Num() > 0 ? Sorted[0] : 0.0);
+        Entry->SetNumberField(TEXT("MaxMs"), Sorted.Num() > 0 ? Sorted.Last() : 0.0);
+        Entry->SetNumberField(TEXT("Allocations"), (double)Result.MedianAllocations());
+        Entry->SetNumberField(TEXT("AllocatedBytes"), (double)Result.AllocatedBytes);
+        Entry->SetNumberField(TEXT("ListedRows"), Result.ListedRows);
+        Entry->SetNumberField(TEXT("BudgetMs"), GetBudgetMs(Result.Sessions));
+        Entry->SetNumberField(TEXT("BudgetAllocations"), (double)GetBudgetAllocations(Result.Sessions));
+        Entry->SetBoolField(TEXT("Passed"), Result.Failures.Num() == 0);
+
+        TArray<TSharedPtr<FJsonValue>> Failures;
+
+        for(const FString & Failure : Result.Failures)
+        {
+            Failures.Add(MakeShared<FJsonValueString>(Failure));
+        }
+
+        Entry->SetArrayField(TEXT("Failures"), Failures);
+
+        ResultValues.Add(MakeShared<FJsonValueObject>(Entry));
+    }
+
+    TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+    Report->SetStringField(TEXT("Benchmark"), TEXT("MultiplayerSessions.SearchToRender"));
+    Report->SetStringField(TEXT("MenuClass"), MenuClass->GetPathName());
+    Report->SetNumberField(TEXT("Iterations"), Iterations);
+    Report->SetNumberField(TEXT("Tolerance"), Tolerance);
+    Report->SetStringField(TEXT("Baseline"), BaselinePath);
+    Report->SetBoolField(TEXT("Passed"), bPassed);
+    Report->SetArrayField(TEXT("Results"), ResultValues);
+
+    FString ReportText;
+    FJsonSerializer::Serialize(Report, TJsonWriterFactory<>::Create(&ReportText));
+
+    if(!FFileHelper::SaveStringToFile(ReportText, *OutputPath))
+    {
+        SESSION_LOG(Error, TEXT("Could not write %s"), *OutputPath);
+
+        bPassed = false;
+    }
+
+    Subsystem->MultiplayerOnFindSessionsComplete.RemoveAll(Menu);
+
+    UWorld * World = GameInstance->GetWorld();
+    GameInstance->Shutdown();
+
+    if(World)
+    {
+        GEngine->DestroyWorldContext(World);
+        World->DestroyWorld(false);
+    }
+
+    return bPassed ? 0 : 1;
+}
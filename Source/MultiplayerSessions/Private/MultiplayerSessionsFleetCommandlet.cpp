@@ -0,0 +1,250 @@
+#include "MultiplayerSessionsFleetCommandlet.h"
+#include "DedicatedServerHost.h"
+#include "SessionLog.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+
+namespace SessionFleet
+{
+    static constexpr float PollInterval = 0.5f;//seconds between two checks of the instances
+    static constexpr double MinHealthyUptime = 30.0;//an instance that exits sooner counts as failed, whatever its exit code
+    static constexpr double RestartBackoff = 2.0;//seconds before the first restart of a failed instance, doubled for every failure in a row
+    static constexpr double MaxRestartBackoff = 60.0;
+    static constexpr const TCHAR * TasksetPath = TEXT("/usr/bin/taskset");
+
+    struct FInstance
+    {
+        int32 Index = 0;
+        int32 Port = 0;
+        int32 QueryPort = 0;
+        int32 QosPort = 0;
+        FString Cores;//taskset CPU list, empty when not pinned
+
+        FProcHandle Process;
+        double StartTime = 0.0;
+        double RestartTime = 0.0;
+        int32 FailuresInARow = 0;
+        int32 Launches = 0;
+    };
+
+    /**
+     * @return The CPU list of the cores from FirstCore on, wrapped around NumCores when the machine has fewer.
+     */
+    static FString MakeCoreList(int32 FirstCore, int32 NumInstanceCores, int32 NumCores)
+    {
+        TStringBuilder<64> Cores;
+
+        for(int32 Core = FirstCore; Core < FirstCore + NumInstanceCores; ++Core)
+        {
+            if(Cores.Len() > 0)
+            {
+                Cores << TEXT(',');
+            }
+
+            Cores << (Core % NumCores);
+        }
+
+        return FString(Cores.ToView());
+    }
+
+    static bool Launch(FInstance & Instance, const FString & Executable, const FString & CommonArgs)
+    {
+        FString Args = FString::Printf(TEXT("%s -port=%d -QueryPort=%d -QosPort=%d -FleetInstance=%d -log=FleetInstance%d.log"),
+            *CommonArgs, Instance.Port, Instance.QueryPort, Instance.QosPort, Instance.Index, Instance.Index);
+
+        FString Url = Executable;
+
+        if(!Instance.Cores.IsEmpty())//the instance is pinned from its first instruction on, so its thread pools are sized to its cores
+        {
+            Args = FString::Printf(TEXT("-c %s \"%s\" %s"), *Instance.Cores, *Executable, *Args);
+            Url = TasksetPath;
+        }
+
+        Instance.Process = FPlatformProcess::CreateProc(*Url, *Args, false, true, true, nullptr, 0, nullptr, nullptr);
+        Instance.StartTime = FPlatformTime::Seconds();
+        ++Instance.Launches;
+
+        if(!Instance.Process.IsValid())
+        {
+            SESSION_LOG(Error, TEXT("Could not launch fleet instance %d: %s %s"), Instance.Index, *Url, *Args);
+
+            return false;
+        }
+
+        SESSION_LOG(Display, TEXT("Fleet instance %d launched on port %d, cores %s (launch %d)"), Instance.Index, Instance.Port,
+            Instance.Cores.IsEmpty() ? TEXT("all") : *Instance.Cores, Instance.Launches);
+
+        return true;
+    }
+
+    /**
+     * Schedules the replacement of an instance that exited: a recycled one right away, a failed one after its back-off.
+     */
+    static void ScheduleRestart(FInstance & Instance, int32 ReturnCode, double Now)
+    {
+        const double Uptime = Now - Instance.StartTime;
+
+        if(ReturnCode == EDedicatedServerExit::Recycled && Uptime >= MinHealthyUptime)
+        {
+            Instance.FailuresInARow = 0;
+            Instance.RestartTime = Now;
+
+            SESSION_LOG(Display, TEXT("Fleet instance %d recycled after %.0f s"), Instance.Index, Uptime);
+
+            return;
+        }
+
+        ++Instance.FailuresInARow;
+
+        const double Backoff = FMath::Min(RestartBackoff * FMath::Pow(2.0, (double)FMath::Min(Instance.FailuresInARow - 1, 16)), MaxRestartBackoff);
+
+        Instance.RestartTime = Now + Backoff;
+
+        SESSION_LOG(Warning, TEXT("Fleet instance %d exited with %d after %.0f s, restarting in %.0f s"), Instance.Index, ReturnCode, Uptime, Backoff);
+    }
+}
+
+UMultiplayerSessionsFleetCommandlet::UMultiplayerSessionsFleetCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UMultiplayerSessionsFleetCommandlet::Main(const FString & Params)
+{
+    using namespace SessionFleet;
+
+    FString Map;
+    FString Executable = FPlatformProcess::ExecutablePath();
+    FString ServerArgs;
+    int32 NumInstances = 0;
+    int32 CoresPerInstance = 2;
+    int32 FirstCore = 0;
+    int32 BasePort = 7777;
+    int32 QueryPortBase = 27015;
+    int32 QosPortBase = 17777;//clear of the game ports, unlike the QoS port of a single host
+
+    FParse::Value(*Params, TEXT("Map="), Map);
+    FParse::Value(*Params, TEXT("Executable="), Executable);
+    FParse::Value(*Params, TEXT("ServerArgs="), ServerArgs, false);//keeps the quoted arguments together
+    FParse::Value(*Params, TEXT("Instances="), NumInstances);
+    FParse::Value(*Params, TEXT("CoresPerInstance="), CoresPerInstance);
+    FParse::Value(*Params, TEXT("FirstCore="), FirstCore);
+    FParse::Value(*Params, TEXT("BasePort="), BasePort);
+    FParse::Value(*Params, TEXT("QueryPortBase="), QueryPortBase);
+    FParse::Value(*Params, TEXT("QosPortBase="), QosPortBase);
+
+    if(Map.IsEmpty())
+    {
+        SESSION_LOG(Error, TEXT("No map to host, pass -Map=<map package>"));
+
+        return 1;
+    }
+
+    const int32 NumCores = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+
+    CoresPerInstance = FMath::Clamp(CoresPerInstance, 1, NumCores);
+    FirstCore = FMath::Clamp(FirstCore, 0, NumCores - 1);
+
+    if(NumInstances <= 0)
+    {
+        NumInstances = FMath::Max(1, (NumCores - FirstCore) / CoresPerInstance);
+    }
+
+    const int32 LastPort = FMath::Max3(BasePort, QueryPortBase, QosPortBase) + NumInstances - 1;
+
+    if(LastPort > MAX_uint16)
+    {
+        SESSION_LOG(Error, TEXT("%d instances do not fit below port %d"), NumInstances, (int32)MAX_uint16);
+
+        return 1;
+    }
+
+    const auto Overlaps = [NumInstances](int32 FirstA, int32 FirstB) { return FMath::Abs(FirstA - FirstB) < NumInstances; };
+
+    if(Overlaps(BasePort, QueryPortBase) || Overlaps(BasePort, QosPortBase) || Overlaps(QueryPortBase, QosPortBase))
+    {
+        SESSION_LOG(Error, TEXT("The game, query and QoS port ranges of %d instances overlap"), NumInstances);
+
+        return 1;
+    }
+
+    const bool bPinCores = PLATFORM_LINUX && FPaths::FileExists(TasksetPath);
+
+    if(!bPinCores)
+    {
+        SESSION_LOG(Warning, TEXT("Instances are not pinned to cores, %s is not available"), TasksetPath);
+    }
+    else if(FirstCore + NumInstances * CoresPerInstance > NumCores)
+    {
+        SESSION_LOG(Warning, TEXT("%d instances with %d cores each oversubscribe the %d cores of this machine"), NumInstances, CoresPerInstance, NumCores);
+    }
+
+    // a development launcher runs the editor binary, which needs the project and -server to run headless as a dedicated server
+    FString CommonArgs = WITH_EDITOR ? FString::Printf(TEXT("\"%s\" %s -server"), *FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()), *Map) : Map;
+
+    CommonArgs += TEXT(" -unattended -NoCrashDialog");
+
+    if(!ServerArgs.IsEmpty())
+    {
+        CommonArgs += TEXT(" ") + ServerArgs;
+    }
+
+    TArray<FInstance> Instances;
+    Instances.SetNum(NumInstances);
+
+    for(int32 Index = 0; Index < NumInstances; ++Index)
+    {
+        FInstance & Instance = Instances[Index];
+
+        Instance.Index = Index;
+        Instance.Port = BasePort + Index;
+        Instance.QueryPort = QueryPortBase + Index;
+        Instance.QosPort = QosPortBase + Index;
+        Instance.Cores = bPinCores ? MakeCoreList(FirstCore + Index * CoresPerInstance, CoresPerInstance, NumCores) : FString();
+    }
+
+    SESSION_LOG(Display, TEXT("Running %d instances of %s on %s"), NumInstances, *Map, *Executable);
+
+    while(!IsEngineExitRequested())
+    {
+        const double Now = FPlatformTime::Seconds();
+
+        for(FInstance & Instance : Instances)
+        {
+            if(Instance.Process.IsValid())
+            {
+                if(FPlatformProcess::IsProcRunning(Instance.Process)) continue;
+
+                int32 ReturnCode = -1;
+                FPlatformProcess::GetProcReturnCode(Instance.Process, &ReturnCode);
+                FPlatformProcess::CloseProc(Instance.Process);
+                Instance.Process = FProcHandle();
+
+                ScheduleRestart(Instance, ReturnCode, Now);
+            }
+
+            if(Now >= Instance.RestartTime && !Launch(Instance, Executable, CommonArgs))
+            {
+                ScheduleRestart(Instance, -1, Now);
+            }
+        }
+
+        FPlatformProcess::Sleep(PollInterval);
+    }
+
+    SESSION_LOG(Display, TEXT("Stopping the fleet"));
+
+    for(FInstance & Instance : Instances)
+    {
+        if(Instance.Process.IsValid())
+        {
+            FPlatformProcess::TerminateProc(Instance.Process, true);
+            FPlatformProcess::CloseProc(Instance.Process);
+        }
+    }
+
+    return 0;
+}
@@ -1,10 +1,20 @@
 #include "MultiplayerSessionsSubsystem.h"
 #include "OnlineSubsystem.h"
+#include "Engine/LocalPlayer.h"
 #include "OnlineSessionSettings.h"
 #include "Interfaces/OnlineIdentityInterface.h"
 #include "Interfaces/OnlinePresenceInterface.h"
 #include "Online/OnlineSessionNames.h"
-#include "DebugHelper.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include "SessionSettingsSchema.h"
+#include "SessionStats.h"
+#include "SessionLog.h"
+#include "SyntheticOnlineSession.h"
+#include "MapPreloader.h"
+#include "Async/Async.h"
+#include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
 
 /**
  * Constructor for the UMultiplayerSessionsSubsystem class.
@@ -26,172 +36,1781 @@ UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem():
     }
 }
 
+/**
+ * Switches to the synthetic session backend when it is enabled,
+ * binds the async task bookkeeping to the subsystem's own delegates and starts the timeout watchdog.
+ */
+void UMultiplayerSessionsSubsystem::Initialize(FSubsystemCollectionBase & Collection)
+{
+    Super::Initialize(Collection);
+
+    if(USyntheticSessionBackendSettings::IsEnabled())//load tests run against the in-process backend instead of the online subsystem
+    {
+        SessionInterface = MakeShared<FSyntheticOnlineSession, ESPMode::ThreadSafe>(*GetDefault<USyntheticSessionBackendSettings>());
+    }
+
+    if(SessionInterface.IsValid())//bound once, completions are routed by session name
+    {
+        CreateSessionCompleteDelegateHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegate);
+        JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegate);
+        DestroySessionCompleteDelegateHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegate);
+        StartSessionCompleteDelegateHandle = SessionInterface->AddOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegate);
+    }
+
+    // tasks are resolved by the same broadcasts the menu listens to
+    MultiplayerOnCreateSessionComplete.AddDynamic(this, &ThisClass::OnCreateSessionTaskComplete);
+    MultiplayerOnStartSessionComplete.AddDynamic(this, &ThisClass::OnStartSessionTaskComplete);
+    MultiplayerOnDestroySessionComplete.AddDynamic(this, &ThisClass::OnDestroySessionTaskComplete);
+    MultiplayerOnFindSessionsComplete.AddUObject(this, &ThisClass::OnFindSessionsTaskComplete);
+    MultiplayerOnJoinSessionComplete.AddUObject(this, &ThisClass::OnJoinSessionTaskComplete);
+
+    TimeoutTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::TickSessionTimeouts), 0.25f);
+}
+
+/**
+ * Called when the owning game instance shuts down.
+ * Makes sure the tickers and QoS threads do not outlive the subsystem and nobody keeps waiting on a task.
+ */
+void UMultiplayerSessionsSubsystem::Deinitialize()
+{
+    StopSearchStream();
+    StopAutoRefresh();
+
+    FTSTicker::GetCoreTicker().RemoveTicker(TimeoutTickerHandle);
+    TimeoutTickerHandle.Reset();
+
+    TArray<FPendingSessionTask> Tasks = MoveTemp(PendingSessionTasks);
+
+    for(FPendingSessionTask & Task : Tasks)
+    {
+        FSessionTaskResult Result;
+        Result.Status = ESessionTaskStatus::Cancelled;
+
+        Task.Promise.SetValue(Result);
+    }
+
+    FTSTicker::GetCoreTicker().RemoveTicker(QuickMatchTickerHandle);
+    QuickMatchTickerHandle.Reset();
+
+    SessionSlots.Reset();
+
+    if(SessionInterface.IsValid())
+    {
+        SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+        SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
+        SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+        SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegateHandle);
+    }
+
+    QosProber.Reset();
+    QosResponder.Reset();
+
+    if(PendingSnapshotWrite.IsValid())
+    {
+        PendingSnapshotWrite.Wait();//a half written snapshot would only be a .tmp file, but the write should not outlive the module
+    }
+
+    ReleaseLastSeenSessions();
+
+    if(USyntheticSessionBackendSettings::IsEnabled())
+    {
+        SessionInterface.Reset();//drops the synthetic backend's pending calls with it
+    }
+
+    Super::Deinitialize();
+}
+
 /**
  * Creates a new session with the specified number of public connections and match type.
+ * A session we are still in is destroyed first, exactly once, and the new session is started as soon as it is created.
+ * Calling it again before the queued create was sent only updates the settings of that create.
+ *
+ * @param NumPublicConnections The number of public connections for the session.
+ * @param MatchType The match type for the session.
+ */
+void UMultiplayerSessionsSubsystem::CreateSession(int32 NumPublicConnections, FString MatchType)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_CreateSession);
+
+    DesiredNumberOfPublicConnections = NumPublicConnections;
+    DesiredMatchType = MatchType;//we never check if the match type is even valid -> big lols
+
+    if(!SessionInterface.IsValid()) return;
+
+    FNamedSessionSlot & Slot = SessionSlots.FindOrAdd(NAME_GameSession);
+
+    for(FSessionOperation & Queued : Slot.PendingOperations)
+    {
+        if(Queued.Type == FSessionOperation::EType::Create && !Queued.Settings.IsValid())//not sent yet, the latest settings win
+        {
+            Queued.NumPublicConnections = NumPublicConnections;
+            Queued.MatchType = MatchType;
+
+            return;
+        }
+    }
+
+    if(WillSessionExist(NAME_GameSession))
+    {
+        EnqueueSessionOperation(FSessionOperation::Make(FSessionOperation::EType::Destroy));
+    }
+
+    EnqueueSessionOperation(FSessionOperation::MakeCreate(NumPublicConnections, MatchType));
+}
+
+/**
+ * Creates a named session with the given settings, e.g. a party session next to the game session.
+ * Like the game session, a session of that name we are still in is destroyed first. It is not started automatically.
+ *
+ * @param SessionName The name of the session, NAME_PartySession or any other than NAME_GameSession.
+ * @param Settings The settings the session is created with, as they are.
+ */
+void UMultiplayerSessionsSubsystem::CreateSession(FName SessionName, const FOnlineSessionSettings & Settings)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_CreateSession);
+
+    if(!SessionInterface.IsValid())
+    {
+        BroadcastSessionComplete(SessionName, FSessionOperation::EType::Create, false);
+
+        return;
+    }
+
+    if(WillSessionExist(SessionName))
+    {
+        EnqueueSessionOperation(FSessionOperation::Make(FSessionOperation::EType::Destroy, SessionName));
+    }
+
+    EnqueueSessionOperation(FSessionOperation::MakeCreate(SessionName, Settings));
+}
+
+/**
+ * Sends a queued create to the session interface.
+ *
+ * @param Operation The create operation with the session settings.
+ */
+void UMultiplayerSessionsSubsystem::RunCreateSession(const FSessionOperation & Operation)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_RunCreateSession);
+
+    const FName SessionName = Operation.SessionName;
+
+    SetSessionState(SessionName, ESessionState::Creating);
+
+    TSharedPtr<FOnlineSessionSettings> Settings = Operation.Settings;
+
+    if(!Settings.IsValid())//the game session we advertise
+    {
+        const int32 NumPublicConnections = Operation.NumPublicConnections;
+        const FString & MatchType = Operation.MatchType;
+
+        if(bProbeSessionLatency)//answer the latency probes of searching clients
+        {
+            if(!QosResponder.IsValid())
+            {
+                QosResponder = MakeUnique<FSessionQosResponder>();
+            }
+
+            if(QosResponder->GetPort() == 0 && !QosResponder->Start(QosPort))
+            {
+                SESSION_LOG(Warning, TEXT("Failed to start the QoS responder on port %d"), QosPort);
+            }
+        }
+
+        //////////////////////////////////////////////////////////////////////////
+        // SESSION SETUP
+        //////////////////////////////////////////////////////////////////////////
+
+        Settings = MakeShareable(new FOnlineSessionSettings());//create a new session settings object
+
+        Settings->bIsLANMatch = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL" ? true : false; // if we are using the steam subsystem it is not a lan match, but if we are using the null subsystem it is a lan match
+        Settings->NumPublicConnections = NumPublicConnections; // set the number of public connections to the value passed in as a parameter
+        Settings->bAllowJoinInProgress = true; // allow players to join the session even if it is already in progress
+        Settings->bAllowJoinViaPresence = true; // allow players to join the session via presence
+        Settings->bShouldAdvertise = true; // allow the session to be advertised
+        Settings->bUsesPresence = true; // use presence to advertise the session
+        Settings->bUseLobbiesIfAvailable = true; // use lobbies if available
+
+        if(IsRunningDedicatedServer())//nobody hosts in person, there is no presence to join through and lobbies need a user
+        {
+            Settings->bIsDedicated = true;
+            Settings->bUsesPresence = false;
+            Settings->bAllowJoinViaPresence = false;
+            Settings->bUseLobbiesIfAvailable = false;
+        }
+        SessionSchema::Set<SessionSchema::FMatchType>(*Settings, MatchType);//set the map name
+        SessionSchema::Set<SessionSchema::FGameType>(*Settings, FString(SessionGameType));//set the game name
+        SessionSchema::Set<SessionSchema::FBuildId>(*Settings, SessionBuildId);//BuildUniqueId itself cannot be queried, so it is advertised as a searchable setting too
+        Settings->BuildUniqueId = SessionBuildId;//session system will use the id to get the list of games related to this version of the game
+
+        if(QosResponder.IsValid() && QosResponder->GetPort() != 0)
+        {
+            SessionSchema::Set<SessionSchema::FQosPort>(*Settings, QosResponder->GetPort());//where searching clients send their probes
+        }
+    }
+
+    SessionSlots.FindChecked(SessionName).Settings = Settings;
+
+    //////////////////////////////////////////////////////////////////////////
+    // CREATE SESSION
+    //////////////////////////////////////////////////////////////////////////
+
+    const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+
+    const bool bSent = LocalUserId.IsValid() ? SessionInterface->CreateSession(*LocalUserId, SessionName, *Settings) : SessionInterface->CreateSession(0, SessionName, *Settings);//a dedicated server hosts as user 0
+
+    if(!bSent)//create the session using the session settings object
+    {
+        FinishSessionOperation(SessionName, ESessionState::Idle);
+
+        BroadcastSessionComplete(SessionName, FSessionOperation::EType::Create, false);//broadcast that the session was not created successfully
+
+        RunNextSessionOperation(SessionName);
+    }
+}
+
+/**
+ * Finds online sessions of this game and build.
+ *
+ * @param MaxSearchResults The maximum number of search results to return.
+ */
+void UMultiplayerSessionsSubsystem::FindSessions(int32 MaxSearchResults)
+{
+    FindSessions(FSessionQuery::Default().WithMaxResults(MaxSearchResults));
+}
+
+/**
+ * Finds online sessions, the query's constraints are passed to the backend as query settings.
+ * A running search of the same query is left to finish, one of a different query is aborted first.
+ *
+ * @param Query What to search for.
+ */
+void UMultiplayerSessionsSubsystem::FindSessions(const FSessionQuery & Query)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_FindSessions);
+    SESSION_LLM_SCOPE(SearchResults);
+
+	if(!SessionInterface.IsValid())//if the session interface is not valid
+	{
+        SESSION_LOG(Error, TEXT("Online Session Interface is not valid!"));
+
+		return;
+	}
+
+    if(IsSearchInProgress())//the backend runs one search at a time and its completion delegate must only be bound once
+    {
+        if(LastSessionQuery == Query) return;//the running search answers this call too
+
+        AbortSearch();//reported as failed, the new query replaces it
+    }
+
+    FindSessionsCompleteDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegate);//add the find sessions complete delegate
+
+	LastSessionSearch = MakeShareable(new FOnlineSessionSearch());//create a new session search object wrapped in a shared pointer
+
+	LastSessionSearch->bIsLanQuery = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL" ? true : false; // check if the subsystem is null, if it is set the query to lan, if it is not set the query to not lan
+    Query.ApplyTo(*LastSessionSearch);//max results and every constraint go to the backend
+    LastSessionQuery = Query;
+    bInjectedSearch = false;
+
+    StopSearchStream();//a new search replaces whatever was still streaming
+    NumStreamedResults = 0;
+
+    LoadLastSeenSessions(Query);//the first search of a launch revalidates the sessions of the last one
+
+    bRevalidatingSessionTable = TableSessionSearch.IsValid() && SessionTable.Num() > 0 && TableSessionQuery == Query;//keep serving the last good rows until this search completes
+
+    if(!bRevalidatingSessionTable)
+    {
+        TableSessionSearch = LastSessionSearch;
+        TableSessionQuery = Query;
+        SessionTable.Reset(++SearchGeneration, Query.MaxResults);//frees the descriptors of the previous search
+        SessionFilter.Sync(SessionTable);
+        ReleaseLastSeenSessions();
+    }
+
+    const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+
+    const bool bSent = LocalUserId.IsValid() ? SessionInterface->FindSessions(*LocalUserId, LastSessionSearch.ToSharedRef()) : SessionInterface->FindSessions(0, LastSessionSearch.ToSharedRef());
+
+	if(!bSent)//add the find sessions complete delegate
+    {
+        SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);//clear the delegate
+
+        bRevalidatingSessionTable = false;
+
+        PublishSessionCounters();
+
+        MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);//broadcast that the session was not found successfully
+
+        return;
+    }
+
+    SearchStartTime = FPlatformTime::Seconds();
+
+    PublishSessionCounters();
+
+    if(bStreamSearchResults && !bRevalidatingSessionTable && LastSessionSearch->SearchState == EOnlineAsyncTaskState::InProgress)//the backend may have completed synchronously
+    {
+        SearchStreamTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::TickSearchStream), SearchStreamInterval);
+    }
+}
+
+/**
+ * Completes a search with the given results without asking the backend, the results go through the same path as backend results.
+ * Meant for benchmarks and tests of the server browser, running searches and streams are dropped.
+ * The injected sessions are not written to the last seen snapshot and their hosts are not probed.
+ *
+ * @param Results The sessions the search found.
+ * @param Query The query the results answer.
+ */
+void UMultiplayerSessionsSubsystem::InjectSearchResults(TArray<FOnlineSessionSearchResult> && Results, const FSessionQuery & Query)
+{
+    if(!SessionInterface.IsValid()) return;
+
+    if(IsSearchInProgress())
+    {
+        SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+        SessionInterface->CancelFindSessions();
+    }
+
+    LastSessionSearch = MakeShareable(new FOnlineSessionSearch());
+    Query.ApplyTo(*LastSessionSearch);
+    LastSessionSearch->SearchResults = MoveTemp(Results);
+    LastSessionSearch->SearchState = EOnlineAsyncTaskState::Done;
+    LastSessionQuery = Query;
+    bInjectedSearch = true;
+
+    StopSearchStream();
+    NumStreamedResults = 0;
+
+    bRevalidatingSessionTable = false;
+    TableSessionSearch = LastSessionSearch;
+    TableSessionQuery = Query;
+    SessionTable.Reset(++SearchGeneration, LastSessionSearch->SearchResults.Num());
+    SessionFilter.Sync(SessionTable);
+    ReleaseLastSeenSessions();
+
+    OnFindSessionsComplete(true);
+}
+
+/**
+ * Serves the last good result set right away and only searches when the cache is older than SessionCacheTTL.
+ * The stale result set is kept (and joinable) until the revalidating search completes.
+ *
+ * @param Query What to search for, only a cache of the same query is served.
+ */
+void UMultiplayerSessionsSubsystem::FindSessionsCached(const FSessionQuery & Query)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_FindSessionsCached);
+
+    if(HasCachedSessions(Query))
+    {
+        MultiplayerOnFindSessionsComplete.Broadcast(TableSessionSearch->SearchResults, true);
+
+        if(IsSessionCacheFresh()) return;
+    }
+
+    if(!IsSearchInProgress())//a speculative search that is already running will deliver its results to the same delegates
+    {
+        FindSessions(Query);
+    }
+}
+
+/**
+ * Starts a search in the background unless the cache is fresh or a search is already running.
+ * Meant to be called before the player asks for the server list, so it is warm when the browser opens.
+ *
+ * @param Query What to search for.
+ */
+void UMultiplayerSessionsSubsystem::PrefetchSessions(const FSessionQuery & Query)
+{
+    if(IsSearchInProgress() || (HasCachedSessions(Query) && IsSessionCacheFresh())) return;
+
+    FindSessions(Query);
+}
+
+/**
+ * Re-queries the sessions every Interval seconds until StopAutoRefresh is called.
+ * Each refresh revalidates the session table and broadcasts MultiplayerOnSessionListUpdated with only what changed.
+ *
+ * @param Query What every refresh searches for.
+ * @param Interval Seconds between two refreshes.
+ */
+void UMultiplayerSessionsSubsystem::StartAutoRefresh(const FSessionQuery & Query, float Interval)
+{
+    StopAutoRefresh();
+
+    AutoRefreshQuery = Query;
+    AutoRefreshTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::TickAutoRefresh), FMath::Max(Interval, 1.f));
+}
+
+void UMultiplayerSessionsSubsystem::StopAutoRefresh()
+{
+    if(AutoRefreshTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(AutoRefreshTickerHandle);
+        AutoRefreshTickerHandle.Reset();
+    }
+}
+
+/**
+ * Starts the next refresh unless the previous one (or any other search) is still running.
+ *
+ * @param DeltaTime Time since the last refresh.
+ * @return Always true, the ticker is removed by StopAutoRefresh.
+ */
+bool UMultiplayerSessionsSubsystem::TickAutoRefresh(float DeltaTime)
+{
+    if(!IsSearchInProgress())
+    {
+        FindSessions(AutoRefreshQuery);
+    }
+
+    return true;
+}
+
+bool UMultiplayerSessionsSubsystem::IsSearchInProgress() const
+{
+    return LastSessionSearch.IsValid() && LastSessionSearch->SearchState == EOnlineAsyncTaskState::InProgress;
+}
+
+bool UMultiplayerSessionsSubsystem::HasCachedSessions(const FSessionQuery & Query) const
+{
+    return LastGoodSearchTime > 0.0 && TableSessionSearch.IsValid() && SessionTable.Num() > 0 && TableSessionQuery == Query;
+}
+
+bool UMultiplayerSessionsSubsystem::IsSessionCacheFresh() const
+{
+    return FPlatformTime::Seconds() - LastGoodSearchTime < SessionCacheTTL;
+}
+
+/**
+ * Polls the running search and broadcasts the results that were added since the last poll.
+ * Backends like the NULL LAN search append to SearchResults as each host answers, so the menu can show them before the query finishes.
+ *
+ * @param DeltaTime Time since the last tick.
+ * @return True to keep ticking, false once the search is no longer running.
+ */
+bool UMultiplayerSessionsSubsystem::TickSearchStream(float DeltaTime)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_TickSearchStream);
+    SESSION_LLM_SCOPE(SearchResults);
+
+    if(!LastSessionSearch.IsValid() || LastSessionSearch->SearchState != EOnlineAsyncTaskState::InProgress)
+    {
+        SearchStreamTickerHandle.Reset();
+
+        return false;//OnFindSessionsComplete flushes whatever is left
+    }
+
+    FlushSearchStream();
+
+    return true;
+}
+
+/**
+ * Broadcasts every search result that has not been streamed yet as a single batch.
+ */
+void UMultiplayerSessionsSubsystem::FlushSearchStream()
+{
+    if(!LastSessionSearch.IsValid() || bRevalidatingSessionTable) return;
+
+    const TArray<FOnlineSessionSearchResult> & SearchResults = LastSessionSearch->SearchResults;
+
+    SyncSessionTable();
+
+    if(SearchResults.Num() <= NumStreamedResults) return;
+
+    const int32 FirstResultIndex = NumStreamedResults;
+    NumStreamedResults = SearchResults.Num();
+
+    MultiplayerOnFindSessionsBatch.Broadcast(MakeArrayView(SearchResults).Slice(FirstResultIndex, NumStreamedResults - FirstResultIndex), FirstResultIndex);
+}
+
+/**
+ * Adds descriptors for the search results that are not in the session table yet.
+ */
+void UMultiplayerSessionsSubsystem::SyncSessionTable()
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_SyncSessionTable);
+    SESSION_LLM_SCOPE(SearchResults);
+
+    if(!TableSessionSearch.IsValid() || bRevalidatingSessionTable) return;
+
+    const TArray<FOnlineSessionSearchResult> & SearchResults = TableSessionSearch->SearchResults;
+
+    for(int32 Index = SessionTable.Num(); Index < SearchResults.Num(); ++Index)
+    {
+        SessionTable.Append(SearchResults[Index]);
+    }
+
+    SessionFilter.Sync(SessionTable);//only the appended rows are indexed
+}
+
+/**
+ * Resolves a handle of the current search generation to its search result.
+ *
+ * @param Handle The handle taken from the session table.
+ * @return The search result, or nullptr if the handle belongs to an older search.
+ */
+const FOnlineSessionSearchResult * UMultiplayerSessionsSubsystem::FindSearchResult(FSessionHandle Handle) const
+{
+    if(!SessionTable.IsValid(Handle) || !TableSessionSearch.IsValid() || !TableSessionSearch->SearchResults.IsValidIndex(Handle.Index)) return nullptr;//disappeared rows sit past the end of the results
+
+    return &TableSessionSearch->SearchResults[Handle.Index];
+}
+
+/**
+ * Replaces the session table with the results of the revalidating search.
+ * Rows of the previous table that are no longer listed are kept at the end, flagged as disappeared.
+ * The keyed difference to the previous table is broadcast through MultiplayerOnSessionListUpdated.
+ */
+void UMultiplayerSessionsSubsystem::CommitRevalidatedSearch()
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_CommitRevalidatedSearch);
+    SESSION_LLM_SCOPE(SearchResults);
+
+    const TArray<FOnlineSessionSearchResult> & SearchResults = LastSessionSearch->SearchResults;
+
+    FSessionDescriptorTable NewTable;
+    NewTable.Reset(++SearchGeneration, SearchResults.Num() + SessionTable.Num());
+
+    FSessionTableDiff Diff;
+    Diff.PreviousGeneration = SessionTable.GetGeneration();
+    Diff.Generation = NewTable.GetGeneration();
+
+    TMultiMap<uint32, int32> PreviousRowsByIdHash;//a multimap so the rare hash collision still resolves through the string compare
+    PreviousRowsByIdHash.Reserve(SessionTable.Num());
+
+    for(int32 Index = 0; Index < SessionTable.Num(); ++Index)
+    {
+        PreviousRowsByIdHash.Add(SessionTable.GetSessionIdHash(Index), Index);
+    }
+
+    auto FindPreviousRow = [this, &PreviousRowsByIdHash](FStringView SessionId, uint32 SessionIdHash)
+    {
+        for(auto It = PreviousRowsByIdHash.CreateConstKeyIterator(SessionIdHash); It; ++It)
+        {
+            if(SessionTable.GetSessionId(It.Value()).Equals(SessionId)) return It.Value();
+        }
+
+        return (int32)INDEX_NONE;
+    };
+
+    TBitArray<> PreviousRowMatched(false, SessionTable.Num());
+
+    for(const FOnlineSessionSearchResult & Result : SearchResults)
+    {
+        const int32 Index = NewTable.Append(Result);
+        const int32 PreviousIndex = FindPreviousRow(NewTable.GetSessionId(Index), NewTable.GetSessionIdHash(Index));
+
+        Diff.PreviousRows.Add(PreviousIndex);
+
+        if(PreviousIndex == INDEX_NONE)
+        {
+            Diff.Added.Add(Index);
+
+            continue;
+        }
+
+        PreviousRowMatched[PreviousIndex] = true;
+
+        if(SessionTable.GetRowFlags(PreviousIndex) & ESessionRowFlags::Probed)//keep the measurement until the next probes replace it
+        {
+            NewTable.SetQos(Index, SessionTable.GetPingInMs(PreviousIndex), SessionTable.GetPacketLoss(PreviousIndex));
+        }
+
+        if(NewTable.GetPingInMs(Index) != SessionTable.GetPingInMs(PreviousIndex)
+            || NewTable.GetOpenSlots(Index) != SessionTable.GetOpenSlots(PreviousIndex)
+            || (SessionTable.GetRowFlags(PreviousIndex) & ESessionRowFlags::Disappeared))
+        {
+            Diff.Changed.Add(Index);
+        }
+    }
+
+    for(int32 PreviousIndex = 0; PreviousIndex < SessionTable.Num(); ++PreviousIndex)
+    {
+        if(PreviousRowMatched[PreviousIndex]) continue;
+
+        if(SessionTable.GetRowFlags(PreviousIndex) & ESessionRowFlags::Disappeared)//only mark rows that disappeared in this refresh
+        {
+            Diff.Dropped.Add(PreviousIndex);
+
+            continue;
+        }
+
+        Diff.Removed.Add(NewTable.AppendFrom(SessionTable, PreviousIndex, ESessionRowFlags::Disappeared));
+        Diff.PreviousRows.Add(PreviousIndex);
+    }
+
+    SessionTable = MoveTemp(NewTable);//the previous arena is released here
+    TableSessionSearch = LastSessionSearch;
+    ReleaseLastSeenSessions();//last seen rows were either listed again, with their live values, or dropped
+
+    SessionFilter.Sync(SessionTable);
+
+    MultiplayerOnSessionListUpdated.Broadcast(Diff);
+}
+
+/**
+ * Shows the sessions the last launch found, before the first search of this launch completes.
+ * The rows point straight into the mapped snapshot; they are flagged as disappeared, greyed out and not joinable,
+ * and the search then revalidates them like any other table: sessions that are still listed come back with live values, the others are dropped.
+ *
+ * @param Query The query of the first search, the snapshot is only used if it was written for the same query.
+ */
+void UMultiplayerSessionsSubsystem::LoadLastSeenSessions(const FSessionQuery & Query)
+{
+    if(bTriedLastSeenSnapshot || TableSessionSearch.IsValid() || SessionTable.Num() > 0) return;
+
+    bTriedLastSeenSnapshot = true;
+
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_LoadLastSeenSessions);
+
+    TUniquePtr<FSessionListSnapshot> Snapshot = FSessionListSnapshot::Open(FSessionListSnapshot::GetDefaultPath());
+
+    if(!Snapshot || Snapshot->Num() <= 0 || Snapshot->GetQueryHash() != FSessionListSnapshot::HashQuery(Query)) return;
+
+    FSessionTableDiff Diff;
+    Diff.PreviousGeneration = SessionTable.GetGeneration();
+
+    SessionTable.Reset(++SearchGeneration, Snapshot->Num());
+
+    Diff.Generation = SessionTable.GetGeneration();
+    Diff.PreviousRows.Init(INDEX_NONE, Snapshot->Num());
+    Diff.Added.Reserve(Snapshot->Num());
+
+    for(int32 Index = 0; Index < Snapshot->Num(); ++Index)
+    {
+        const FSessionListSnapshot::FRecord & Record = Snapshot->GetRecord(Index);
+
+        Diff.Added.Add(SessionTable.AppendExternal(
+            Snapshot->GetString(Record.SessionIdOffset, Record.SessionIdLength), Record.SessionIdHash,
+            Snapshot->GetString(Record.OwnerNameOffset, Record.OwnerNameLength),
+            Snapshot->GetString(Record.MapNameOffset, Record.MapNameLength),
+            Snapshot->GetString(Record.GameTypeOffset, Record.GameTypeLength),
+            Record.PingInMs, Record.OpenSlots, Record.PublicSlots, ESessionRowFlags::LastSeen | ESessionRowFlags::Disappeared));
+    }
+
+    SESSION_LOG(Log, TEXT("Showing %d sessions last seen %s"), Snapshot->Num(), *Snapshot->GetSavedTime().ToString());
+
+    LastSeenSnapshot = MoveTemp(Snapshot);
+    TableSessionSearch = MakeShared<FOnlineSessionSearch>();//no results behind the rows, nothing can be joined until the search completes
+    TableSessionQuery = Query;
+
+    SessionFilter.Sync(SessionTable);
+
+    MultiplayerOnSessionListUpdated.Broadcast(Diff);
+}
+
+/**
+ * Writes the rows of the current table to the snapshot on a worker thread, through a temporary file so a crash never leaves half a snapshot.
+ */
+void UMultiplayerSessionsSubsystem::SaveLastSeenSessions()
+{
+    if(LastSeenSnapshot.IsValid()) return;//still mapped, the file cannot be replaced
+
+    if(PendingSnapshotWrite.IsValid() && !PendingSnapshotWrite.IsReady()) return;//the next search writes a newer one anyway
+
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_SaveLastSeenSessions);
+
+    TArray<uint8> Buffer;
+    FSessionListSnapshot::Write(SessionTable, FSessionListSnapshot::HashQuery(TableSessionQuery), Buffer);
+
+    PendingSnapshotWrite = Async(EAsyncExecution::ThreadPool, [Buffer = MoveTemp(Buffer), Path = FSessionListSnapshot::GetDefaultPath()]()
+    {
+        const FString TempPath = Path + TEXT(".tmp");
+
+        if(!FFileHelper::SaveArrayToFile(Buffer, *TempPath) || !IFileManager::Get().Move(*Path, *TempPath, true))
+        {
+            SESSION_LOG(Warning, TEXT("Could not write the session list snapshot %s"), *Path);
+        }
+    });
+}
+
+/**
+ * Unmaps the snapshot, call once no row of SessionTable points into it anymore.
+ */
+void UMultiplayerSessionsSubsystem::ReleaseLastSeenSessions()
+{
+    LastSeenSnapshot.Reset();
+}
+
+/**
+ * Probes every host of the session table that advertises a QoS port.
+ * Hosts reached through a relay (e.g. steam.<id> connect strings) have no address to probe and keep their reported ping.
+ */
+void UMultiplayerSessionsSubsystem::StartQosProbes()
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_StartQosProbes);
+
+    QosProber.Reset();//cancels the probes of the previous table
+
+    ISocketSubsystem * SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+    if(!bProbeSessionLatency || !SessionInterface.IsValid() || !TableSessionSearch.IsValid() || !SocketSubsystem) return;
+
+    const TArray<FOnlineSessionSearchResult> & SearchResults = TableSessionSearch->SearchResults;
+
+    TArray<FSessionQosTarget> Targets;
+
+    for(int32 Row = 0; Row < SearchResults.Num(); ++Row)
+    {
+        int32 HostQosPort = 0;
+        FString ConnectString;
+
+        if(!SessionSchema::Get<SessionSchema::FQosPort>(SearchResults[Row].Session.SessionSettings, HostQosPort) || HostQosPort <= 0) continue;//the host does not answer probes
+
+        if(!SessionInterface->GetResolvedConnectString(SearchResults[Row], NAME_GamePort, ConnectString)) continue;
+
+        FString Host;
+
+        if(!ConnectString.Split(TEXT(":"), &Host, nullptr, ESearchCase::CaseSensitive, ESearchDir::FromEnd))
+        {
+            Host = ConnectString;
+        }
+
+        bool bIsValid = false;
+        TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr();
+        Address->SetIp(*Host, bIsValid);
+
+        if(!bIsValid) continue;
+
+        Address->SetPort(HostQosPort);
+
+        FSessionQosTarget & Target = Targets.AddDefaulted_GetRef();
+        Target.Row = Row;
+        Target.Address = Address;
+    }
+
+    if(Targets.Num() == 0) return;
+
+    FSessionQosProber::FSettings ProberSettings;
+    ProberSettings.MaxOutstandingTargets = MaxOutstandingQosProbes;
+
+    QosProber = MakeUnique<FSessionQosProber>(ProberSettings);
+    QosProber->Start(MoveTemp(Targets), FOnSessionQosProbesComplete::CreateUObject(this, &ThisClass::OnQosProbesComplete, SessionTable.GetGeneration()));
+}
+
+/**
+ * Merges the measured round trip times and packet loss into the session table and the search results.
+ *
+ * @param Results One result per probed host.
+ * @param Generation The session table generation the probes were started for.
+ */
+void UMultiplayerSessionsSubsystem::OnQosProbesComplete(const TArray<FSessionQosResult> & Results, uint32 Generation)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_OnQosProbesComplete);
+    SESSION_LLM_SCOPE(SearchResults);
+
+    if(Generation != SessionTable.GetGeneration() || !TableSessionSearch.IsValid()) return;//the table was replaced while probing
+
+    TArray<FOnlineSessionSearchResult> & SearchResults = TableSessionSearch->SearchResults;
+
+    for(const FSessionQosResult & Result : Results)
+    {
+        if(!SearchResults.IsValidIndex(Result.Row)) continue;
+
+        SessionTable.SetQos(Result.Row, Result.RttMs, Result.LossPercent);
+
+        if(Result.RttMs != INDEX_NONE)
+        {
+            SearchResults[Result.Row].PingInMs = Result.RttMs;
+        }
+    }
+
+    SessionFilter.RefreshLatency(SessionTable);
+
+    MultiplayerOnSessionQosUpdated.Broadcast();
+}
+
+/**
+ * Removes the search stream ticker if one is registered.
+ */
+void UMultiplayerSessionsSubsystem::StopSearchStream()
+{
+    if(SearchStreamTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(SearchStreamTickerHandle);
+        SearchStreamTickerHandle.Reset();
+    }
+}
+
+/**
+ * Joins the specified online session, a session of that name we are still in is destroyed first.
+ *
+ * @param SearchResult The search result of the session to join.
+ * @param SessionName The name the joined session goes by, the game session unless e.g. a party is joined.
+ */
+void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult & SearchResult, FName SessionName)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_JoinSession);
+
+    if(!SessionInterface.IsValid()) {
+        BroadcastJoinSessionComplete(SessionName, EOnJoinSessionCompleteResult::UnknownError);//broadcast that the session was not joined successfully
+
+        SESSION_LOG(Error, TEXT("Online Session Interface is not valid!"));
+
+        return;
+    }
+
+    if(WillSessionExist(SessionName))
+    {
+        EnqueueSessionOperation(FSessionOperation::Make(FSessionOperation::EType::Destroy, SessionName));
+    }
+
+    EnqueueSessionOperation(FSessionOperation::MakeJoin(SearchResult, SessionName));
+
+    if(SessionName != NAME_GameSession) return;//joining a party does not travel
+
+    SESSION_SPAN_BEGIN(Join);//the menu ends it when it travels; list clicks, quick match and the async nodes all join through here
+
+    StopAutoRefresh();//the list must not change under a join
+
+    UMapPreloader * MapPreloader = GetGameInstance()->GetSubsystem<UMapPreloader>();
+
+    if(MapPreloader)
+    {
+        FString MatchType;
+        SessionSchema::Get<SessionSchema::FMatchType>(SearchResult.Session.SessionSettings, MatchType);
+
+        MapPreloader->PreloadForJoin(MatchType);//loads while the backend joins, the travel after it finds the maps in memory
+    }
+}
+
+/**
+ * Sends a queued join to the session interface.
+ *
+ * @param Operation The join operation with the search result to join.
+ */
+void UMultiplayerSessionsSubsystem::RunJoinSession(const FSessionOperation & Operation)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_RunJoinSession);
+
+    const FName SessionName = Operation.SessionName;
+
+    SetSessionState(SessionName, ESessionState::Joining);
+
+    const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+
+    const bool bSent = LocalUserId.IsValid() ? SessionInterface->JoinSession(*LocalUserId, SessionName, Operation.SearchResult) : SessionInterface->JoinSession(0, SessionName, Operation.SearchResult);
+
+    if(!bSent)//join the session
+    {
+        SESSION_LOG(Error, TEXT("Failed to join session %s!"), *SessionName.ToString());
+
+        //ovdje samo javljamo da je doslo do greske
+        FinishSessionOperation(SessionName, ESessionState::Idle);
+
+        BroadcastJoinSessionComplete(SessionName, EOnJoinSessionCompleteResult::UnknownError);//broadcast that the session was not joined successfully
+
+        RunNextSessionOperation(SessionName);
+    }
+}
+
+/**
+ * Joins the session a handle of the current session table points to.
+ *
+ * @param Handle The handle of the session to join.
+ */
+void UMultiplayerSessionsSubsystem::JoinSession(FSessionHandle Handle)
+{
+    const FOnlineSessionSearchResult * SearchResult = FindSearchResult(Handle);
+
+    if(!SearchResult)
+    {
+        SESSION_LOG(Warning, TEXT("Session handle is stale, search again!"));
+
+        BroadcastJoinSessionComplete(NAME_GameSession, EOnJoinSessionCompleteResult::SessionDoesNotExist);
+
+        return;
+    }
+
+    SESSION_LOG(Log, TEXT("Joining session %s - %s | Map: %s"),
+        *FString(SessionTable.GetSessionId(Handle.Index)), *FString(SessionTable.GetOwnerName(Handle.Index)), *FString(SessionTable.GetMapName(Handle.Index)));
+
+    JoinSession(*SearchResult);
+}
+
+/**
+ * Destroys a named session, the game session by default.
+ * Creates and joins of that session that were not sent yet are dropped instead, and without a session to destroy no round trip is made at all.
+ *
+ * @param SessionName The session to destroy, the other sessions are not affected.
+ */
+void UMultiplayerSessionsSubsystem::DestroySession(FName SessionName)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_DestroySession);
+
+    if(!SessionInterface.IsValid())
+    {
+        BroadcastSessionComplete(SessionName, FSessionOperation::EType::Destroy, false);//broadcast that the session was not destroyed successfully
+
+        return;
+    }
+
+    TArray<FSessionOperation> Dropped;
+
+    if(FNamedSessionSlot * Slot = SessionSlots.Find(SessionName))
+    {
+        while(Slot->PendingOperations.Num() > 0 && Slot->PendingOperations.Last().Type != FSessionOperation::EType::Destroy)
+        {
+            Dropped.Add(Slot->PendingOperations.Pop());
+        }
+    }
+
+    const bool bDestroyNeeded = WillSessionExist(SessionName);
+
+    if(bDestroyNeeded)
+    {
+        EnqueueSessionOperation(FSessionOperation::Make(FSessionOperation::EType::Destroy, SessionName));
+    }
+
+    for(const FSessionOperation & Operation : Dropped)//every request still gets an answer
+    {
+        if(Operation.Type == FSessionOperation::EType::Join)
+        {
+            BroadcastJoinSessionComplete(SessionName, EOnJoinSessionCompleteResult::UnknownError);
+        }
+        else if(Operation.Type != FSessionOperation::EType::Destroy)
+        {
+            BroadcastSessionComplete(SessionName, Operation.Type, false);
+        }
+    }
+
+    if(!bDestroyNeeded && !IsDestroyPending(SessionName))
+    {
+        BroadcastSessionComplete(SessionName, FSessionOperation::EType::Destroy, true);//there is no session, nothing to wait for
+    }
+}
+
+/**
+ * Sends a queued destroy to the session interface, skipped if the session is already gone.
+ */
+void UMultiplayerSessionsSubsystem::RunDestroySession(FName SessionName)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_RunDestroySession);
+
+    if(!SessionInterface->GetNamedSession(SessionName))//e.g. the create queued before this destroy failed
+    {
+        FinishSessionOperation(SessionName, ESessionState::Idle);
+
+        BroadcastSessionComplete(SessionName, FSessionOperation::EType::Destroy, true);
+
+        RunNextSessionOperation(SessionName);
+
+        return;
+    }
+
+    SetSessionState(SessionName, ESessionState::Destroying);
+
+    if(!SessionInterface->DestroySession(SessionName))
+    {
+        SESSION_LOG(Error, TEXT("Failed to destroy session %s!"), *SessionName.ToString());
+
+        FinishSessionOperation(SessionName, ESessionState::InSession);
+
+        BroadcastSessionComplete(SessionName, FSessionOperation::EType::Destroy, false);//broadcast that the session was not destroyed successfully
+
+        RunNextSessionOperation(SessionName);
+    }
+}
+
+/**
+ * Starts a named online session, the game session by default.
+ * Skipped while a create is pending that starts the game session by itself, or if the session already runs.
+ */
+void UMultiplayerSessionsSubsystem::StartSession(FName SessionName)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_StartSession);
+
+    if(!SessionInterface.IsValid())
+    {        
+        SESSION_LOG(Error, TEXT("Online Session Interface is not valid!"));
+
+        return;
+    };
+
+    const bool bStartsOnCreate = bStartSessionOnCreate && SessionName == NAME_GameSession;
+    const FNamedSessionSlot & Slot = SessionSlots.FindOrAdd(SessionName);
+
+    if(Slot.State == ESessionState::Starting || (bStartsOnCreate && Slot.State == ESessionState::Creating)) return;
+
+    for(const FSessionOperation & Queued : Slot.PendingOperations)
+    {
+        if(Queued.Type == FSessionOperation::EType::Start || (bStartsOnCreate && Queued.Type == FSessionOperation::EType::Create)) return;
+    }
+
+    const FNamedOnlineSession * Session = SessionInterface->GetNamedSession(SessionName);
+
+    if(Slot.PendingOperations.Num() == 0 && Session && Session->SessionState == EOnlineSessionState::InProgress)
+    {
+        BroadcastSessionComplete(SessionName, FSessionOperation::EType::Start, true);//already running
+
+        return;
+    }
+
+    EnqueueSessionOperation(FSessionOperation::Make(FSessionOperation::EType::Start, SessionName));
+}
+
+/**
+ * Sends a queued start to the session interface.
+ */
+void UMultiplayerSessionsSubsystem::RunStartSession(FName SessionName)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_RunStartSession);
+
+    SetSessionState(SessionName, ESessionState::Starting);
+
+    if(!SessionInterface->StartSession(SessionName))//start the session
+    {
+        SESSION_LOG(Error, TEXT("Failed to start session %s!"), *SessionName.ToString());
+
+        FinishSessionOperation(SessionName, SessionInterface->GetNamedSession(SessionName) ? ESessionState::InSession : ESessionState::Idle);
+
+        BroadcastSessionComplete(SessionName, FSessionOperation::EType::Start, false);//broadcast that the session was not started successfully
+
+        RunNextSessionOperation(SessionName);
+    }
+}
+
+/**
+ * Queues a session operation and runs it right away if nothing else is running on its session.
+ *
+ * @param Operation The operation to queue.
+ */
+void UMultiplayerSessionsSubsystem::EnqueueSessionOperation(FSessionOperation && Operation)
+{
+    const FName SessionName = Operation.SessionName;
+
+    SessionSlots.FindOrAdd(SessionName).PendingOperations.Add(MoveTemp(Operation));
+
+    RunNextSessionOperation(SessionName);
+}
+
+/**
+ * Sends the oldest queued operation of a session unless one of it is still waiting for its completion delegate.
+ * Operations on other sessions do not wait for it.
+ *
+ * @param SessionName The session whose queue moves on.
+ */
+void UMultiplayerSessionsSubsystem::RunNextSessionOperation(FName SessionName)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_RunNextSessionOperation);
+
+    for(;;)
+    {
+        FNamedSessionSlot * Slot = SessionSlots.Find(SessionName);//looked up again, running an operation may add another session
+
+        if(!Slot || Slot->bOperationRunning || Slot->PendingOperations.Num() == 0) break;
+
+        const FSessionOperation Operation = MoveTemp(Slot->PendingOperations[0]);
+        Slot->PendingOperations.RemoveAt(0, 1, false);
+
+        SESSION_LOG(Verbose, TEXT("Running session operation %d on %s, %d queued"), (int32)Operation.Type, *SessionName.ToString(), Slot->PendingOperations.Num());
+
+        Slot->bOperationRunning = true;
+        Slot->RunningOperation = Operation.Type;
+        Slot->OperationStartTime = FPlatformTime::Seconds();
+
+        switch(Operation.Type)
+        {
+        case FSessionOperation::EType::Create:
+            RunCreateSession(Operation);
+            break;
+        case FSessionOperation::EType::Start:
+            RunStartSession(SessionName);
+            break;
+        case FSessionOperation::EType::Destroy:
+            RunDestroySession(SessionName);
+            break;
+        case FSessionOperation::EType::Join:
+            RunJoinSession(Operation);
+            break;
+        }
+    }
+
+    PublishSessionCounters();
+}
+
+/**
+ * The user the backend calls are made for: the first local player, or null on a dedicated server and before a player is logged in,
+ * in which case the calls go out for local user 0 and the online subsystem uses its own identity.
+ */
+FUniqueNetIdPtr UMultiplayerSessionsSubsystem::GetLocalUserId() const
+{
+    const UWorld * World = GetWorld();
+    const ULocalPlayer * LocalPlayer = World ? World->GetFirstLocalPlayerFromController() : nullptr;
+
+    return LocalPlayer ? LocalPlayer->GetPreferredUniqueNetId().GetUniqueNetId() : nullptr;
+}
+
+/**
+ * Marks the running operation of a session as done, the caller broadcasts its result and runs the next operation.
+ *
+ * @param SessionName The session the operation ran on.
+ * @param NewState The state the operation left the session in.
+ */
+void UMultiplayerSessionsSubsystem::FinishSessionOperation(FName SessionName, ESessionState::Type NewState)
+{
+    SessionSlots.FindOrAdd(SessionName).bOperationRunning = false;
+
+    SetSessionState(SessionName, NewState);
+}
+
+void UMultiplayerSessionsSubsystem::SetSessionState(FName SessionName, ESessionState::Type NewState)
+{
+    SessionSlots.FindOrAdd(SessionName).State = NewState;
+
+    PublishSessionCounters();
+}
+
+/**
+ * The state of a named session, a running search shows as Searching while the game session is idle.
+ */
+ESessionState::Type UMultiplayerSessionsSubsystem::GetSessionState(FName SessionName) const
+{
+    const FNamedSessionSlot * Slot = SessionSlots.Find(SessionName);
+    const ESessionState::Type State = Slot ? Slot->State : ESessionState::Idle;
+
+    return State == ESessionState::Idle && SessionName == NAME_GameSession && IsSearchInProgress() ? ESessionState::Searching : State;
+}
+
+TSharedPtr<const FOnlineSessionSettings> UMultiplayerSessionsSubsystem::GetSessionSettings(FName SessionName) const
+{
+    const FNamedSessionSlot * Slot = SessionSlots.Find(SessionName);
+
+    return Slot ? Slot->Settings : nullptr;
+}
+
+/**
+ * Sets the in-flight counters of 'stat MultiplayerSessions' and Unreal Insights, compiled out in shipping.
+ */
+void UMultiplayerSessionsSubsystem::PublishSessionCounters() const
+{
+#if MULTIPLAYERSESSIONS_INSTRUMENTATION
+    int32 NumOperations = 0;
+
+    for(const TPair<FName, FNamedSessionSlot> & Slot : SessionSlots)
+    {
+        NumOperations += Slot.Value.PendingOperations.Num() + (Slot.Value.bOperationRunning ? 1 : 0);
+    }
+
+    SESSION_SET_COUNTER(SessionOperationsInFlight, NumOperations);
+    SESSION_SET_COUNTER(SessionSearchesInFlight, IsSearchInProgress() ? 1 : 0);
+    SESSION_SET_COUNTER(SessionTasksInFlight, PendingSessionTasks.Num());
+#endif
+}
+
+/**
+ * Whether a named session exists once its running and queued operations are done.
+ */
+bool UMultiplayerSessionsSubsystem::WillSessionExist(FName SessionName) const
+{
+    const FNamedSessionSlot * Slot = SessionSlots.Find(SessionName);
+
+    bool bExists = (!Slot || Slot->State != ESessionState::Destroying) && SessionInterface.IsValid() && SessionInterface->GetNamedSession(SessionName) != nullptr;//create and join add the named session as soon as they are sent
+
+    if(!Slot) return bExists;
+
+    for(const FSessionOperation & Queued : Slot->PendingOperations)
+    {
+        if(Queued.Type == FSessionOperation::EType::Create || Queued.Type == FSessionOperation::EType::Join)
+        {
+            bExists = true;
+        }
+        else if(Queued.Type == FSessionOperation::EType::Destroy)
+        {
+            bExists = false;
+        }
+    }
+
+    return bExists;
+}
+
+bool UMultiplayerSessionsSubsystem::IsDestroyPending(FName SessionName) const
+{
+    const FNamedSessionSlot * Slot = SessionSlots.Find(SessionName);
+
+    return Slot && (Slot->State == ESessionState::Destroying || Slot->PendingOperations.ContainsByPredicate([](const FSessionOperation & Queued) { return Queued.Type == FSessionOperation::EType::Destroy; }));
+}
+
+/**
+ * @param SessionName The session a completion delegate reported.
+ * @param Type The operation the delegate completes.
+ */
+UMultiplayerSessionsSubsystem::FNamedSessionSlot * UMultiplayerSessionsSubsystem::FindRunningOperation(FName SessionName, FSessionOperation::EType Type)
+{
+    FNamedSessionSlot * Slot = SessionSlots.Find(SessionName);
+
+    return Slot && Slot->bOperationRunning && Slot->RunningOperation == Type ? Slot : nullptr;
+}
+
+/**
+ * Reports a create, start or destroy: to MultiplayerOnNamedSessionComplete always, to the game session's delegates for the game session.
+ */
+void UMultiplayerSessionsSubsystem::BroadcastSessionComplete(FName SessionName, FSessionOperation::EType Type, bool bWasSuccessful)
+{
+    MultiplayerOnNamedSessionComplete.Broadcast(SessionName, Type, bWasSuccessful);
+
+    if(SessionName != NAME_GameSession) return;//the menu and the async tasks only follow the game session
+
+    switch(Type)
+    {
+    case FSessionOperation::EType::Create:
+        MultiplayerOnCreateSessionComplete.Broadcast(bWasSuccessful);
+        break;
+    case FSessionOperation::EType::Start:
+        MultiplayerOnStartSessionComplete.Broadcast(bWasSuccessful);
+        break;
+    case FSessionOperation::EType::Destroy:
+        MultiplayerOnDestroySessionComplete.Broadcast(bWasSuccessful);
+        break;
+    default:
+        break;//joins are reported with their result by BroadcastJoinSessionComplete
+    }
+}
+
+/**
+ * Finds and joins the best session with a single call.
+ * Fresh cached results are ranked right away, otherwise a search runs first. When a join fails the next best candidate is joined
+ * without searching again, only once every candidate failed is the search repeated, every RetryInterval seconds.
+ * If no session was joined when the deadline passes a session is hosted instead.
+ * MultiplayerOnQuickMatchComplete reports the outcome, the join and create delegates are broadcast as usual.
+ *
+ * @param Params What to look for, how to score it and what to host when nothing fits.
+ */
+void UMultiplayerSessionsSubsystem::QuickMatch(const FQuickMatchParams & Params)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_QuickMatch);
+
+    if(IsQuickMatchInProgress())
+    {
+        CancelQuickMatch();
+    }
+
+    if(!SessionInterface.IsValid())
+    {
+        SESSION_LOG(Error, TEXT("Online Session Interface is not valid!"));
+
+        MultiplayerOnQuickMatchComplete.Broadcast(EQuickMatchResult::Failed);
+
+        return;
+    }
+
+    QuickMatchParams = Params;
+    QuickMatchCandidates.Reset();
+    QuickMatchTriedSessions.Reset();
+    NextQuickMatchCandidate = 0;
+    QuickMatchDeadline = FPlatformTime::Seconds() + Params.Deadline;
+    QuickMatchPhase = EQuickMatchPhase::Searching;
+
+    QuickMatchSearchHandle = MultiplayerOnFindSessionsComplete.AddUObject(this, &ThisClass::OnQuickMatchSearchComplete);
+    QuickMatchTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::TickQuickMatch), 0.1f);
+
+    if(HasCachedSessions(Params.Query) && IsSessionCacheFresh())
+    {
+        OnQuickMatchSearchComplete(TableSessionSearch->SearchResults, true);//no round trip for results that are fresh enough
+
+        return;
+    }
+
+    if(!IsSearchInProgress())//a running search of the same sessions is just as good
+    {
+        FindSessions(Params.Query);
+    }
+}
+
+/**
+ * Stops the running quick match. A join that is already in flight cannot be taken back, its result is broadcast as a normal join.
+ */
+void UMultiplayerSessionsSubsystem::CancelQuickMatch()
+{
+    if(!IsQuickMatchInProgress()) return;
+
+    FinishQuickMatch(EQuickMatchResult::Cancelled);
+}
+
+/**
+ * Ranks the session table once a search completed and joins the best candidate.
+ *
+ * @param SessionResults Unused, the ranking reads the session table.
+ * @param bWasSuccessful A failed search leaves the last good table in place, which is ranked all the same.
+ */
+void UMultiplayerSessionsSubsystem::OnQuickMatchSearchComplete(const TArray<FOnlineSessionSearchResult> & SessionResults, bool bWasSuccessful)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_OnQuickMatchSearchComplete);
+
+    if(QuickMatchPhase != EQuickMatchPhase::Searching) return;//a search someone else started while we are joining
+
+    TArray<int32> Rows;
+    SessionQuickMatch::RankCandidates(SessionTable, QuickMatchParams, QuickMatchTriedSessions, Rows);
+
+    QuickMatchCandidates.Reset(Rows.Num());
+
+    for(int32 Row : Rows)
+    {
+        QuickMatchCandidates.Add(SessionTable.MakeHandle(Row));
+    }
+
+    NextQuickMatchCandidate = 0;
+
+    TryNextQuickMatchCandidate();
+}
+
+/**
+ * Joins the next ranked candidate, or waits for the next search if every candidate was tried.
+ */
+void UMultiplayerSessionsSubsystem::TryNextQuickMatchCandidate()
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_TryNextQuickMatchCandidate);
+
+    while(NextQuickMatchCandidate < QuickMatchCandidates.Num())
+    {
+        const FSessionHandle Handle = QuickMatchCandidates[NextQuickMatchCandidate++];
+        const FOnlineSessionSearchResult * SearchResult = FindSearchResult(Handle);
+
+        if(!SearchResult) continue;//a refresh replaced the table since the ranking
+
+        QuickMatchTriedSessions.Add(SessionTable.GetSessionIdHash(Handle.Index));
+        QuickMatchPhase = EQuickMatchPhase::Joining;
+
+        JoinSession(*SearchResult);
+
+        return;
+    }
+
+    QuickMatchPhase = EQuickMatchPhase::Waiting;
+    QuickMatchRetryTime = FPlatformTime::Seconds() + QuickMatchParams.RetryInterval;
+}
+
+/**
+ * Watches the deadline and starts the retry searches.
+ */
+bool UMultiplayerSessionsSubsystem::TickQuickMatch(float DeltaTime)
+{
+    if(QuickMatchPhase == EQuickMatchPhase::Joining) return true;//a join in flight always gets its answer first
+
+    const double Now = FPlatformTime::Seconds();
+
+    if(Now >= QuickMatchDeadline)
+    {
+        HostQuickMatchFallback();
+
+        return false;
+    }
+
+    if(QuickMatchPhase == EQuickMatchPhase::Waiting && Now >= QuickMatchRetryTime)
+    {
+        QuickMatchPhase = EQuickMatchPhase::Searching;
+
+        if(!IsSearchInProgress())
+        {
+            FindSessions(QuickMatchParams.Query);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Nothing suitable was joined in time, host a session instead.
+ */
+void UMultiplayerSessionsSubsystem::HostQuickMatchFallback()
+{
+    const int32 NumPublicConnections = QuickMatchParams.FallbackNumPublicConnections;
+    const FString MatchType = QuickMatchParams.FallbackMatchType.IsEmpty() ? QuickMatchParams.PreferredMatchType : QuickMatchParams.FallbackMatchType;
+
+    FinishQuickMatch(EQuickMatchResult::Hosting);
+
+    CreateSession(NumPublicConnections, MatchType);
+}
+
+void UMultiplayerSessionsSubsystem::FinishQuickMatch(EQuickMatchResult::Type Result)
+{
+    QuickMatchPhase = EQuickMatchPhase::Idle;
+    QuickMatchCandidates.Reset();
+
+    FTSTicker::GetCoreTicker().RemoveTicker(QuickMatchTickerHandle);
+    QuickMatchTickerHandle.Reset();
+
+    MultiplayerOnFindSessionsComplete.Remove(QuickMatchSearchHandle);
+    QuickMatchSearchHandle.Reset();
+
+    MultiplayerOnQuickMatchComplete.Broadcast(Result);
+}
+
+
+/**
+ * Async CreateSession.
  *
  * @param NumPublicConnections The number of public connections for the session.
  * @param MatchType The match type for the session.
+ * @param Timeout Seconds until the task fails with TimedOut, 0 waits forever.
+ * @return The task, fulfilled when the create completes.
  */
-void UMultiplayerSessionsSubsystem::CreateSession(int32 NumPublicConnections, FString MatchType)
+FSessionTask UMultiplayerSessionsSubsystem::CreateSessionAsync(int32 NumPublicConnections, const FString & MatchType, float Timeout)
 {
-    DesiredNumberOfPublicConnections = NumPublicConnections;
-    DesiredMatchType = MatchType;//we never check if the match type is even valid -> big lols
+    FSessionTask Task = AddSessionTask(ESessionTaskType::Create, Timeout);
 
-    if(!SessionInterface.IsValid()) return;
+    if(!SessionInterface.IsValid())
+    {
+        EndSessionTask(Task.Id, ESessionTaskStatus::Failed);
+
+        return Task;
+    }
 
-    auto ExistingSession = SessionInterface->GetNamedSession(NAME_GameSession);
+    CreateSession(NumPublicConnections, MatchType);
 
-    if(ExistingSession)
+    return Task;
+}
+
+FSessionTask UMultiplayerSessionsSubsystem::StartSessionAsync(float Timeout)
+{
+    FSessionTask Task = AddSessionTask(ESessionTaskType::Start, Timeout);
+
+    if(!SessionInterface.IsValid())
     {
-        bCreateSessionOnDestroy = true;
-        LastNumPublicConnections = NumPublicConnections;
-        LastMatchType = MatchType;
-        DestroySession();
+        EndSessionTask(Task.Id, ESessionTaskStatus::Failed);
+
+        return Task;
     }
 
-    //////////////////////////////////////////////////////////////////////////
-    // SESSION SETUP
-    //////////////////////////////////////////////////////////////////////////
+    StartSession();
 
-    LastSessionSettings = MakeShareable(new FOnlineSessionSettings());//create a new session settings object
+    return Task;
+}
 
-	LastSessionSettings->bIsLANMatch = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL" ? true : false; // if we are using the steam subsystem it is not a lan match, but if we are using the null subsystem it is a lan match
-	LastSessionSettings->NumPublicConnections = NumPublicConnections; // set the number of public connections to the value passed in as a parameter
-	LastSessionSettings->bAllowJoinInProgress = true; // allow players to join the session even if it is already in progress
-	LastSessionSettings->bAllowJoinViaPresence = true; // allow players to join the session via presence
-	LastSessionSettings->bShouldAdvertise = true; // allow the session to be advertised
-	LastSessionSettings->bUsesPresence = true; // use presence to advertise the session
-	LastSessionSettings->bUseLobbiesIfAvailable = true; // use lobbies if available
-	LastSessionSettings->Set(FName("MatchType"), MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);//set the map name
-	LastSessionSettings->Set(FName("GameType"), FString("DeathEcho"), EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);//set the map name
-    LastSessionSettings->BuildUniqueId = 385104;//session system will use the id to get the list of games related to this version of the game
+FSessionTask UMultiplayerSessionsSubsystem::DestroySessionAsync(float Timeout)
+{
+    FSessionTask Task = AddSessionTask(ESessionTaskType::Destroy, Timeout);
 
-    //////////////////////////////////////////////////////////////////////////
-    // CREATE SESSION
-    //////////////////////////////////////////////////////////////////////////
+    DestroySession();
 
-    CreateSessionCompleteDelegateHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegate);//store the delegate in an FDelegateHandle so we can later remove it from the delegate list
+    return Task;
+}
 
-    const ULocalPlayer * LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();//get the first local player
+/**
+ * Async FindSessions, the results are in the session table once the task succeeded.
+ *
+ * @param Query What to search for.
+ * @param Timeout Seconds until the search is cancelled and the task fails with TimedOut, 0 waits forever.
+ * @return The task, NumSearchResults tells how many sessions were found.
+ */
+FSessionTask UMultiplayerSessionsSubsystem::FindSessionsAsync(const FSessionQuery & Query, float Timeout)
+{
+    FSessionTask Task = AddSessionTask(ESessionTaskType::Find, Timeout);
 
-	if(!SessionInterface->CreateSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, *LastSessionSettings))//create the session using the session settings object
+    if(!SessionInterface.IsValid())
     {
-        SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);//clear the delegate
+        EndSessionTask(Task.Id, ESessionTaskStatus::Failed);
+
+        return Task;
+    }
 
-        MultiplayerOnCreateSessionComplete.Broadcast(false);//broadcast that the session was not created successfully
+    if(!IsSearchInProgress())//a running search answers this task too
+    {
+        FindSessions(Query);
     }
+
+    return Task;
+}
+
+FSessionTask UMultiplayerSessionsSubsystem::JoinSessionAsync(FSessionHandle Handle, float Timeout)
+{
+    FSessionTask Task = AddSessionTask(ESessionTaskType::Join, Timeout);
+
+    JoinSession(Handle);
+
+    return Task;
 }
 
 /**
- * Finds online sessions.
+ * Gives up on a task: it resolves as Cancelled immediately and its operation is abandoned if no other task waits for it.
  *
- * @param MaxSearchResults The maximum number of search results to return.
+ * @param TaskId The id of the task.
  */
-void UMultiplayerSessionsSubsystem::FindSessions(int32 MaxSearchResults)
+void UMultiplayerSessionsSubsystem::CancelSessionTask(uint32 TaskId)
 {
-	if(!SessionInterface.IsValid())//if the session interface is not valid
-	{
-        DebugHelper::PrintToLog("Online Session Interface is not valid!", FColor::Red);
+    EndSessionTask(TaskId, ESessionTaskStatus::Cancelled);
+}
 
-		return;
-	}
+FSessionTask UMultiplayerSessionsSubsystem::AddSessionTask(ESessionTaskType::Type Type, float Timeout)
+{
+    if(++LastSessionTaskId == 0)
+    {
+        ++LastSessionTaskId;//0 is the invalid task
+    }
 
-    FindSessionsCompleteDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegate);//add the find sessions complete delegate
+    FPendingSessionTask & Pending = PendingSessionTasks.AddDefaulted_GetRef();
+    Pending.Id = LastSessionTaskId;
+    Pending.Type = Type;
+    Pending.Deadline = Timeout > 0.f ? FPlatformTime::Seconds() + Timeout : 0.0;
 
-	LastSessionSearch = MakeShareable(new FOnlineSessionSearch());//create a new session search object wrapped in a shared pointer
+    FSessionTask Task;
+    Task.Id = Pending.Id;
+    Task.Result = Pending.Promise.GetFuture();
 
-	LastSessionSearch->MaxSearchResults = MaxSearchResults; // set the maximum search results
-	LastSessionSearch->bIsLanQuery = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL" ? true : false; // check if the subsystem is null, if it is set the query to lan, if it is not set the query to not lan
-	LastSessionSearch->QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);//set the query settings
+    PublishSessionCounters();
+
+    return Task;
+}
 
-	const ULocalPlayer * LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();//get the first local player
+/**
+ * Fulfills every pending task of a type, the promises are taken out first because continuations may start new tasks.
+ *
+ * @param Type The operation that completed.
+ * @param Result What it completed with.
+ */
+void UMultiplayerSessionsSubsystem::ResolveSessionTasks(ESessionTaskType::Type Type, const FSessionTaskResult & Result)
+{
+    TArray<TPromise<FSessionTaskResult>, TInlineAllocator<2>> Promises;
 
-	if(!SessionInterface->FindSessions(*LocalPlayer->GetPreferredUniqueNetId(), LastSessionSearch.ToSharedRef()))//add the find sessions complete delegate
+    for(int32 Index = PendingSessionTasks.Num() - 1; Index >= 0; --Index)
     {
-        SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);//clear the delegate
+        if(PendingSessionTasks[Index].Type != Type) continue;
 
-        MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);//broadcast that the session was not found successfully
+        Promises.Add(MoveTemp(PendingSessionTasks[Index].Promise));
+        PendingSessionTasks.RemoveAt(Index);
+    }
+
+    PublishSessionCounters();
+
+    for(int32 Index = Promises.Num() - 1; Index >= 0; --Index)//oldest task first
+    {
+        Promises[Index].SetValue(Result);
     }
 }
 
 /**
- * Joins the specified online session.
+ * Ends one task early and abandons its operation unless another task still waits for it.
+ * Abandoned operations release their backend delegate and broadcast a failure, so the UI is freed right away.
  *
- * @param SearchResult The search result of the session to join.
+ * @param TaskId The id of the task.
+ * @param Status TimedOut or Cancelled.
  */
-void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult & SearchResult)
+void UMultiplayerSessionsSubsystem::EndSessionTask(uint32 TaskId, ESessionTaskStatus Status)
 {
-    if(!SessionInterface.IsValid()) {
-        MultiplayerOnJoinSessionComplete.Broadcast(EOnJoinSessionCompleteResult::UnknownError);//broadcast that the session was not joined successfully
+    const int32 Index = PendingSessionTasks.IndexOfByPredicate([TaskId](const FPendingSessionTask & Task) { return Task.Id == TaskId; });
 
-        DebugHelper::PrintToLog("Online Session Interface is not valid!", FColor::Red);
+    if(Index == INDEX_NONE) return;//already resolved
 
-        return;
-    }
+    TPromise<FSessionTaskResult> Promise = MoveTemp(PendingSessionTasks[Index].Promise);
+    const ESessionTaskType::Type Type = PendingSessionTasks[Index].Type;
 
-    JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegate);//add the join session complete delegate
+    PendingSessionTasks.RemoveAt(Index);
 
-    const ULocalPlayer * LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();//get the first local player
+    PublishSessionCounters();
 
-    if(!SessionInterface->JoinSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, SearchResult))//join the session
-    {
-        DebugHelper::PrintToLog("Failed to join session!", FColor::Red);
+    FSessionTaskResult Result;
+    Result.Status = Status;
 
-        //ovdje samo javljamo da je doslo do greske
-        SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);//clear the delegate
+    Promise.SetValue(Result);
+
+    if(PendingSessionTasks.ContainsByPredicate([Type](const FPendingSessionTask & Task) { return Task.Type == Type; })) return;
 
-        MultiplayerOnJoinSessionComplete.Broadcast(EOnJoinSessionCompleteResult::UnknownError);//broadcast that the session was not joined successfully
-    }   
+    switch(Type)
+    {
+    case ESessionTaskType::Find:
+        AbortSearch();
+        break;
+    case ESessionTaskType::Create:
+        CancelSessionOperation(FSessionOperation::EType::Create);
+        break;
+    case ESessionTaskType::Start:
+        CancelSessionOperation(FSessionOperation::EType::Start);
+        break;
+    case ESessionTaskType::Destroy:
+        CancelSessionOperation(FSessionOperation::EType::Destroy);
+        break;
+    case ESessionTaskType::Join:
+        CancelSessionOperation(FSessionOperation::EType::Join);
+        break;
+    }
 }
 
-void UMultiplayerSessionsSubsystem::DestroySession()
+/**
+ * Watchdog for backend calls whose completion delegate never fires, and for task deadlines.
+ */
+bool UMultiplayerSessionsSubsystem::TickSessionTimeouts(float DeltaTime)
 {
-    if(!SessionInterface.IsValid())
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_TickSessionTimeouts);
+
+    const double Now = FPlatformTime::Seconds();
+
+    TArray<uint32, TInlineAllocator<4>> ExpiredTasks;
+
+    for(const FPendingSessionTask & Task : PendingSessionTasks)
     {
-        MultiplayerOnDestroySessionComplete.Broadcast(false);//broadcast that the session was not destroyed successfully
+        if(Task.Deadline > 0.0 && Now >= Task.Deadline)
+        {
+            ExpiredTasks.Add(Task.Id);
+        }
+    }
 
-        return;
+    for(uint32 TaskId : ExpiredTasks)
+    {
+        EndSessionTask(TaskId, ESessionTaskStatus::TimedOut);
     }
 
-    DestroySessionCompleteDelegateHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegate);
+    if(SearchTimeout > 0.f && IsSearchInProgress() && Now - SearchStartTime >= SearchTimeout)
+    {
+        SESSION_LOG(Warning, TEXT("Session search timed out after %.1f s"), SearchTimeout);
+
+        AbortSearch();
+    }
 
-    if(!SessionInterface->DestroySession(NAME_GameSession))
+    if(SessionOperationTimeout > 0.f)
     {
-        DebugHelper::PrintToLog("Failed to destroy session!", FColor::Red);
+        TArray<FName, TInlineAllocator<2>> ExpiredSessions;
 
-        SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+        for(const TPair<FName, FNamedSessionSlot> & Slot : SessionSlots)
+        {
+            if(Slot.Value.bOperationRunning && Now - Slot.Value.OperationStartTime >= SessionOperationTimeout)
+            {
+                SESSION_LOG(Warning, TEXT("Session operation %d on %s timed out after %.1f s"), (int32)Slot.Value.RunningOperation, *Slot.Key.ToString(), SessionOperationTimeout);
+
+                ExpiredSessions.Add(Slot.Key);
+            }
+        }
 
-        MultiplayerOnDestroySessionComplete.Broadcast(false);//broadcast that the session was not destroyed successfully
+        for(FName SessionName : ExpiredSessions)//aborting broadcasts, which may add sessions to the map
+        {
+            AbortSessionOperation(SessionName);
+        }
     }
+
+    return true;
 }
 
 /**
- * Starts an online session.
- * If the session interface is not valid, an error message is printed and the function returns.
- * Adds a delegate for the start session complete event.
- * If starting the session fails, an error message is printed, the delegate is cleared, and a broadcast is sent indicating that the session was not started successfully.
+ * Cancels the running search, releases its delegate and reports it as failed.
+ * The last good session table stays in place.
  */
-void UMultiplayerSessionsSubsystem::StartSession()
+void UMultiplayerSessionsSubsystem::AbortSearch()
 {
-    if(!SessionInterface.IsValid())
-    {        
-        DebugHelper::PrintToLog("Online Session Interface is not valid!", FColor::Red);
+    if(!IsSearchInProgress() || !SessionInterface.IsValid()) return;
 
-        return;
-    };
+    SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+    SessionInterface->CancelFindSessions();
 
-    StartSessionCompleteDelegateHandle = SessionInterface->AddOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegate);//add the start session complete delegate
-    
-    if(!SessionInterface->StartSession(NAME_GameSession))//start the session
+    LastSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;//IsSearchInProgress is false from here on
+
+    StopSearchStream();
+    bRevalidatingSessionTable = false;
+
+    PublishSessionCounters();
+
+    MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
+}
+
+/**
+ * Gives up on the running operation of a session: its failure is broadcast and the session's queue moves on.
+ * If the backend still finishes the operation later, its completion is ignored
+ * and the named session it leaves behind is destroyed before the next create or join of that session.
+ *
+ * @param SessionName The session whose operation is abandoned.
+ */
+void UMultiplayerSessionsSubsystem::AbortSessionOperation(FName SessionName)
+{
+    FNamedSessionSlot * Slot = SessionSlots.Find(SessionName);
+
+    if(!Slot || !Slot->bOperationRunning || !SessionInterface.IsValid()) return;
+
+    const FSessionOperation::EType Type = Slot->RunningOperation;
+
+    FinishSessionOperation(SessionName, SessionInterface->GetNamedSession(SessionName) ? ESessionState::InSession : ESessionState::Idle);
+
+    if(Type == FSessionOperation::EType::Join)
+    {
+        BroadcastJoinSessionComplete(SessionName, EOnJoinSessionCompleteResult::UnknownError);
+    }
+    else
+    {
+        BroadcastSessionComplete(SessionName, Type, false);
+    }
+
+    RunNextSessionOperation(SessionName);
+}
+
+/**
+ * Abandons the running game session operation of a type, or drops the oldest queued one if it was not sent yet.
+ * Either way its failure is broadcast.
+ *
+ * @param Type The kind of operation.
+ */
+void UMultiplayerSessionsSubsystem::CancelSessionOperation(FSessionOperation::EType Type)
+{
+    if(FindRunningOperation(NAME_GameSession, Type))
     {
-        DebugHelper::PrintToLog("Failed to start session!", FColor::Red);
+        AbortSessionOperation(NAME_GameSession);
+
+        return;
+    }
+
+    FNamedSessionSlot * Slot = SessionSlots.Find(NAME_GameSession);
+
+    const int32 Index = Slot ? Slot->PendingOperations.IndexOfByPredicate([Type](const FSessionOperation & Queued) { return Queued.Type == Type; }) : INDEX_NONE;
+
+    if(Index == INDEX_NONE) return;
 
-        SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegateHandle);//clear the delegate
+    Slot->PendingOperations.RemoveAt(Index);
 
-        MultiplayerOnStartSessionComplete.Broadcast(false);//broadcast that the session was not started successfully
+    PublishSessionCounters();
+
+    // reported like an abandoned operation, so whoever waits on it (the menu's buttons) is released right away
+    if(Type == FSessionOperation::EType::Join)
+    {
+        BroadcastJoinSessionComplete(NAME_GameSession, EOnJoinSessionCompleteResult::UnknownError);
+    }
+    else
+    {
+        BroadcastSessionComplete(NAME_GameSession, Type, false);
     }
 }
 
+void UMultiplayerSessionsSubsystem::OnCreateSessionTaskComplete(bool bWasSuccessful)
+{
+    FSessionTaskResult Result;
+    Result.Status = bWasSuccessful ? ESessionTaskStatus::Succeeded : ESessionTaskStatus::Failed;
+
+    ResolveSessionTasks(ESessionTaskType::Create, Result);
+}
+
+void UMultiplayerSessionsSubsystem::OnStartSessionTaskComplete(bool bWasSuccessful)
+{
+    FSessionTaskResult Result;
+    Result.Status = bWasSuccessful ? ESessionTaskStatus::Succeeded : ESessionTaskStatus::Failed;
+
+    ResolveSessionTasks(ESessionTaskType::Start, Result);
+}
+
+void UMultiplayerSessionsSubsystem::OnDestroySessionTaskComplete(bool bWasSuccessful)
+{
+    FSessionTaskResult Result;
+    Result.Status = bWasSuccessful ? ESessionTaskStatus::Succeeded : ESessionTaskStatus::Failed;
+
+    ResolveSessionTasks(ESessionTaskType::Destroy, Result);
+}
+
+void UMultiplayerSessionsSubsystem::OnFindSessionsTaskComplete(const TArray<FOnlineSessionSearchResult> & SessionResults, bool bWasSuccessful)
+{
+    FSessionTaskResult Result;
+    Result.Status = bWasSuccessful ? ESessionTaskStatus::Succeeded : ESessionTaskStatus::Failed;
+    Result.NumSearchResults = SessionResults.Num();
+
+    ResolveSessionTasks(ESessionTaskType::Find, Result);
+}
+
+void UMultiplayerSessionsSubsystem::OnJoinSessionTaskComplete(EOnJoinSessionCompleteResult::Type JoinResult)
+{
+    FSessionTaskResult Result;
+    Result.Status = JoinResult == EOnJoinSessionCompleteResult::Success ? ESessionTaskStatus::Succeeded : ESessionTaskStatus::Failed;
+    Result.JoinResult = JoinResult;
+
+    ResolveSessionTasks(ESessionTaskType::Join, Result);
+}
 
 /**
  * Callback function called when the session creation is complete.
@@ -201,23 +1820,35 @@ void UMultiplayerSessionsSubsystem::StartSession()
  */
 void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
 {
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_OnCreateSessionComplete);
+
+    FNamedSessionSlot * Slot = FindRunningOperation(SessionName, FSessionOperation::EType::Create);
+
+    if(!Slot) return;//not ours, or abandoned after a timeout
+
 	if(bWasSuccessful)//if the session was created successfully
 	{
-        DebugHelper::PrintToLog(FString::Printf(TEXT("Created session %s!"), *SessionName.ToString()), FColor::Green);
+        SESSION_LOG(Display, TEXT("Created session %s"), *SessionName.ToString());
 
-        if(SessionInterface)
+        if(bStartSessionOnCreate && SessionName == NAME_GameSession && !IsDestroyPending(SessionName))
         {
-            SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);//clear the delegate
+            Slot->PendingOperations.Insert(FSessionOperation::Make(FSessionOperation::EType::Start, SessionName), 0);//pipelined, the start goes out before anything queued meanwhile
         }
 
-        MultiplayerOnCreateSessionComplete.Broadcast(true);//broadcast that the session was created successfully
+        FinishSessionOperation(SessionName, ESessionState::InSession);
+
+        BroadcastSessionComplete(SessionName, FSessionOperation::EType::Create, true);//broadcast that the session was created successfully
 	}
 	else//if the session was not created successfully
 	{
-        DebugHelper::PrintToLog("Session Creation Failed!", FColor::Red);
+        SESSION_LOG(Error, TEXT("Creating session %s failed!"), *SessionName.ToString());
+
+        FinishSessionOperation(SessionName, ESessionState::Idle);
 
-        MultiplayerOnCreateSessionComplete.Broadcast(false);//broadcast that the session was not created successfully
+        BroadcastSessionComplete(SessionName, FSessionOperation::EType::Create, false);//broadcast that the session was not created successfully
 	}
+
+    RunNextSessionOperation(SessionName);
 }
 
 /**
@@ -227,25 +1858,57 @@ void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, b
  */
 void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(bool bWasSuccessful)
 {
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_OnFindSessionsComplete);
+    SESSION_LLM_SCOPE(SearchResults);
+
     if(SessionInterface)
     {
         SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);//clear the delegate
 
+        StopSearchStream();
+
+        PublishSessionCounters();
+
+        SESSION_LOG(Log, TEXT("Search completed: %d, %d results"), (int32)bWasSuccessful, LastSessionSearch.IsValid() ? LastSessionSearch->SearchResults.Num() : 0);
+
         if(bWasSuccessful)
         {
-            if(LastSessionSearch->SearchResults.Num() <= 0)
+            if(bRevalidatingSessionTable)
+            {
+                bRevalidatingSessionTable = false;
+                CommitRevalidatedSearch();
+            }
+            else
+            {
+                if(bStreamSearchResults)
+                {
+                    FlushSearchStream();//send the tail that arrived after the last poll so batch listeners see every result
+                }
+
+                SyncSessionTable();
+            }
+
+            LastGoodSearchTime = FPlatformTime::Seconds();
+
+            if(!bInjectedSearch)//synthetic rows must not replace the player's snapshot or be probed
+            {
+                SaveLastSeenSessions();
+                StartQosProbes();
+            }
+
+            if(TableSessionSearch->SearchResults.Num() <= 0)
             {
                 MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);//broadcast that the session was not found successfully
 
                 return;
             }
 
-            TArray<FOnlineSessionSearchResult> SessionResults = LastSessionSearch->SearchResults;//get the search results -> SearchResults is a TArray of FOnlineSessionSearchResult
-
-            MultiplayerOnFindSessionsComplete.Broadcast(SessionResults, true);//broadcast that the session was found successfully
+            MultiplayerOnFindSessionsComplete.Broadcast(TableSessionSearch->SearchResults, true);//broadcast the results owned by the search, no copy
         }
         else
         {
+            bRevalidatingSessionTable = false;//the last good result set stays in place
+
             MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);//broadcast that the session was not found successfully
         }
     }
@@ -259,29 +1922,80 @@ void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(bool bWasSuccessful)
  */
 void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
 {
-    if(SessionInterface)
-    {
-        SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);//clear the delegate since we are done with it
-    }
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_OnJoinSessionComplete);
+
+    if(!FindRunningOperation(SessionName, FSessionOperation::EType::Join)) return;//not ours, or abandoned after a timeout
+
+    SESSION_LOG(Log, TEXT("Join of %s completed: %d"), *SessionName.ToString(), (int32)Result);
+
+    FinishSessionOperation(SessionName, Result == EOnJoinSessionCompleteResult::Success ? ESessionState::InSession : ESessionState::Idle);
     
-    MultiplayerOnJoinSessionComplete.Broadcast(Result);//broadcast that the session was joined successfully
+    BroadcastJoinSessionComplete(SessionName, Result);//broadcast that the session was joined successfully
+
+    RunNextSessionOperation(SessionName);
 }
 
-void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(FName SessionName, bool bWasSuccessful)
+/**
+ * Reports the result of a join to the listeners, unless a quick match handles the failure by trying its next candidate.
+ *
+ * @param SessionName The joined session, only joins of the game session reach MultiplayerOnJoinSessionComplete.
+ * @param Result The result of the join session operation.
+ */
+void UMultiplayerSessionsSubsystem::BroadcastJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
 {
-    if(SessionInterface)
+    MultiplayerOnNamedSessionComplete.Broadcast(SessionName, FSessionOperation::EType::Join, Result == EOnJoinSessionCompleteResult::Success);
+
+    if(SessionName != NAME_GameSession) return;
+
+    if(QuickMatchPhase == EQuickMatchPhase::Joining)
+    {
+        if(Result != EOnJoinSessionCompleteResult::Success)
+        {
+            SESSION_LOG(Warning, TEXT("Quick match join failed (%d), trying the next session"), (int32)Result);
+
+            if(FPlatformTime::Seconds() >= QuickMatchDeadline)
+            {
+                HostQuickMatchFallback();
+            }
+            else
+            {
+                TryNextQuickMatchCandidate();
+            }
+
+            return;//listeners only hear about the join that ends the quick match
+        }
+
+        FinishQuickMatch(EQuickMatchResult::Joined);
+    }
+
+    UMapPreloader * MapPreloader = GetGameInstance()->GetSubsystem<UMapPreloader>();
+
+    if(MapPreloader && Result != EOnJoinSessionCompleteResult::Success)
     {
-        SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);//clear the delegate
+        MapPreloader->ReleaseAll();//no travel follows
     }
 
-    if(bWasSuccessful && bCreateSessionOnDestroy)
+    MultiplayerOnJoinSessionComplete.Broadcast(Result);
+}
+
+void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(FName SessionName, bool bWasSuccessful)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_OnDestroySessionComplete);
+
+    if(!FindRunningOperation(SessionName, FSessionOperation::EType::Destroy)) return;//not ours, or abandoned after a timeout
+
+    SESSION_LOG(Log, TEXT("Destroy of %s completed: %d"), *SessionName.ToString(), (int32)bWasSuccessful);
+
+    if(bWasSuccessful && SessionName == NAME_GameSession && QosResponder.IsValid())
     {
-        bCreateSessionOnDestroy = false;
-        CreateSession(LastNumPublicConnections, LastMatchType);
+        QosResponder->Shutdown();//nothing is advertised anymore
     }
 
-    MultiplayerOnDestroySessionComplete.Broadcast(bWasSuccessful);//broadcast that the session was destroyed successfully
+    FinishSessionOperation(SessionName, bWasSuccessful ? ESessionState::Idle : ESessionState::InSession);
 
+    BroadcastSessionComplete(SessionName, FSessionOperation::EType::Destroy, bWasSuccessful);//broadcast that the session was destroyed successfully
+
+    RunNextSessionOperation(SessionName);//e.g. the create that waited for this destroy
 }
 
 /**
@@ -292,10 +2006,15 @@ void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(FName SessionName,
  */
 void UMultiplayerSessionsSubsystem::OnStartSessionComplete(FName SessionName, bool bWasSuccessful)
 {
-    if(SessionInterface)
-    {
-        SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegateHandle);//clear the delegate
-    }
+    SESSION_SCOPE_CYCLE_COUNTER(Subsystem_OnStartSessionComplete);
+
+    if(!FindRunningOperation(SessionName, FSessionOperation::EType::Start)) return;//not ours, or abandoned after a timeout
+
+    SESSION_LOG(Log, TEXT("Start of %s completed: %d"), *SessionName.ToString(), (int32)bWasSuccessful);
+
+    FinishSessionOperation(SessionName, ESessionState::InSession);//a session that failed to start still exists
+
+    BroadcastSessionComplete(SessionName, FSessionOperation::EType::Start, bWasSuccessful);//broadcast that the session was started successfully
 
-    MultiplayerOnStartSessionComplete.Broadcast(bWasSuccessful);//broadcast that the session was started successfully
+    RunNextSessionOperation(SessionName);
 }
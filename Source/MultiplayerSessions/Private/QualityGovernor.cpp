@@ -0,0 +1,367 @@
+#include "QualityGovernor.h"
+#include "Engine/Engine.h"
+#include "GameFramework/GameUserSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "RHI.h"
+#include "SessionLog.h"
+#include "SessionStats.h"
+
+namespace QualityGovernor
+{
+    static TAutoConsoleVariable<int32> CVarEnabled(
+        TEXT("MultiplayerSessions.QualityGovernor"),
+        1,
+        TEXT("0 pauses the adaptive quality governor, 1 lets it step the scalability settings to hold the target frame rate."));
+
+    static constexpr float SmoothingSeconds = 0.5f;//time constant of the frame and GPU time averages
+    static constexpr float MaxSampleSeconds = 0.25f;//longer frames are hitches or loads, not a sign of too high settings
+    static constexpr float GpuBoundRatio = 0.8f;//the GPU is the bottleneck when it is busy for this much of the frame
+    static constexpr float MaxUpshiftHoldScale = 8.f;
+}
+
+const TCHAR * EQualityKnob::ToString(Type Knob)
+{
+    switch(Knob)
+    {
+    case ScreenPercentage: return TEXT("ScreenPercentage");
+    case Shadow: return TEXT("Shadow");
+    case PostProcess: return TEXT("PostProcess");
+    case Effects: return TEXT("Effects");
+    case Foliage: return TEXT("Foliage");
+    case Reflection: return TEXT("Reflection");
+    case GlobalIllumination: return TEXT("GlobalIllumination");
+    case Shading: return TEXT("Shading");
+    case ViewDistance: return TEXT("ViewDistance");
+    case AntiAliasing: return TEXT("AntiAliasing");
+    default: return TEXT("Unknown");
+    }
+}
+
+/**
+ * Only where frames are rendered.
+ */
+bool UQualityGovernor::ShouldCreateSubsystem(UObject * Outer) const
+{
+    return !IsRunningDedicatedServer() && FApp::CanEverRender() && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UQualityGovernor::Initialize(FSubsystemCollectionBase & Collection)
+{
+    Super::Initialize(Collection);
+
+    TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::Tick));
+}
+
+void UQualityGovernor::Deinitialize()
+{
+    FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+    TickerHandle.Reset();
+
+    Super::Deinitialize();
+}
+
+/**
+ * The governor steps down from, and back up to, the settings that are active when this is called.
+ */
+void UQualityGovernor::ResetCeiling()
+{
+    Ceiling = Scalability::GetQualityLevels();
+    bHasCeiling = true;
+
+    OverBudgetSeconds = 0.0;
+    UnderBudgetSeconds = 0.0;
+    CooldownRemaining = CooldownSeconds;
+    UpshiftHoldScale = 1.f;
+    bLastStepWasUpshift = false;
+}
+
+/**
+ * The governed levels are swapped out only for the save, the cvars they set are read on the next frame.
+ */
+void UQualityGovernor::SaveSettingsAtCeiling(UGameUserSettings & Settings) const
+{
+    const Scalability::FQualityLevels Governed = Scalability::GetQualityLevels();
+
+    if(!bHasCeiling || Governed == Ceiling)
+    {
+        Settings.SaveSettings();
+
+        return;
+    }
+
+    Scalability::SetQualityLevels(Ceiling);
+    Settings.SaveSettings();
+    Scalability::SetQualityLevels(Governed);
+}
+
+void UQualityGovernor::SetActive(bool bInActive)
+{
+    if(bInActive && !bActive)
+    {
+        ResetCeiling();
+    }
+
+    bActive = bInActive;
+}
+
+/**
+ * @return True if the benchmark ran.
+ */
+bool UQualityGovernor::RunInitialBenchmarkIfNeeded()
+{
+    UGameUserSettings * Settings = GEngine ? GEngine->GetGameUserSettings() : nullptr;
+
+    if(!Settings || Settings->GetLastCPUBenchmarkResult() > 0.f) return false;//ran in an earlier launch
+
+    SESSION_SCOPE_CYCLE_COUNTER(QualityGovernor_Benchmark);
+
+    Settings->RunHardwareBenchmark();
+    Settings->ApplyHardwareBenchmarkResults();//applies and saves the levels it picked
+
+    SESSION_LOG(Log, TEXT("Hardware benchmark: CPU %.1f, GPU %.1f, overall scalability level %d"),
+        Settings->GetLastCPUBenchmarkResult(), Settings->GetLastGPUBenchmarkResult(), Settings->GetOverallScalabilityLevel());
+
+    return true;
+}
+
+float UQualityGovernor::GetTargetMs() const
+{
+    if(TargetFrameRate > 0.f) return 1000.f / TargetFrameRate;
+
+    const UGameUserSettings * Settings = GEngine ? GEngine->GetGameUserSettings() : nullptr;
+    const float FrameRateLimit = Settings ? Settings->GetFrameRateLimit() : 0.f;
+
+    return 1000.f / (FrameRateLimit > 0.f ? FrameRateLimit : 60.f);
+}
+
+/**
+ * Samples the frame and decides on a step. The first tick runs the first launch benchmark, when the renderer is up.
+ */
+bool UQualityGovernor::Tick(float DeltaTime)
+{
+    if(!bActive)
+    {
+        if(!bEnabled) return true;
+
+        if(bRunBenchmarkOnFirstLaunch)
+        {
+            RunInitialBenchmarkIfNeeded();
+        }
+
+        SetActive(true);
+        return true;
+    }
+
+    if(QualityGovernor::CVarEnabled.GetValueOnGameThread() == 0 || DeltaTime > QualityGovernor::MaxSampleSeconds) return true;
+
+    const float FrameMs = DeltaTime * 1000.f;
+    const float GpuMs = FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles(0));//0 where the RHI does not time the GPU
+    const float Alpha = 1.f - FMath::Exp(-DeltaTime / QualityGovernor::SmoothingSeconds);
+
+    SmoothedFrameMs += Alpha * (FrameMs - SmoothedFrameMs);
+    SmoothedGpuMs += Alpha * (GpuMs - SmoothedGpuMs);
+
+    CooldownRemaining -= DeltaTime;
+
+    if(CooldownRemaining > 0.0) return true;
+
+    const float TargetMs = GetTargetMs();
+    const float BusyMs = SmoothedGpuMs > 0.f ? SmoothedGpuMs : SmoothedFrameMs;//a frame rate limit keeps the frame time at the target, the GPU time shows the headroom
+    const bool bGpuBound = SmoothedGpuMs <= 0.f || SmoothedGpuMs >= SmoothedFrameMs * QualityGovernor::GpuBoundRatio;
+
+    if(SmoothedFrameMs > TargetMs * (1.f + DownshiftMargin))
+    {
+        OverBudgetSeconds += DeltaTime;
+        UnderBudgetSeconds = 0.0;
+    }
+    else if(BusyMs < TargetMs * (1.f - UpshiftMargin))
+    {
+        UnderBudgetSeconds += DeltaTime;
+        OverBudgetSeconds = 0.0;
+    }
+    else
+    {
+        OverBudgetSeconds = 0.0;
+        UnderBudgetSeconds = 0.0;
+    }
+
+    if(OverBudgetSeconds >= DownshiftHoldSeconds && bGpuBound)
+    {
+        OverBudgetSeconds = 0.0;
+
+        if(bLastStepWasUpshift)
+        {
+            UpshiftHoldScale = FMath::Min(UpshiftHoldScale * 2.f, QualityGovernor::MaxUpshiftHoldScale);//the upshift did not hold
+        }
+
+        if(StepDown())
+        {
+            bLastStepWasUpshift = false;
+            CooldownRemaining = CooldownSeconds;
+        }
+    }
+    else if(UnderBudgetSeconds >= UpshiftHoldSeconds * UpshiftHoldScale)
+    {
+        UnderBudgetSeconds = 0.0;
+
+        if(StepUp())
+        {
+            bLastStepWasUpshift = true;
+            CooldownRemaining = CooldownSeconds;
+        }
+        else
+        {
+            UpshiftHoldScale = 1.f;//back at the ceiling
+        }
+    }
+
+    return true;
+}
+
+int32 UQualityGovernor::GetKnobValue(const Scalability::FQualityLevels & Levels, EQualityKnob::Type Knob) const
+{
+    switch(Knob)
+    {
+    case EQualityKnob::ScreenPercentage: return FMath::RoundToInt(Levels.ResolutionQuality);
+    case EQualityKnob::Shadow: return Levels.ShadowQuality;
+    case EQualityKnob::PostProcess: return Levels.PostProcessQuality;
+    case EQualityKnob::Effects: return Levels.EffectsQuality;
+    case EQualityKnob::Foliage: return Levels.FoliageQuality;
+    case EQualityKnob::Reflection: return Levels.ReflectionQuality;
+    case EQualityKnob::GlobalIllumination: return Levels.GlobalIlluminationQuality;
+    case EQualityKnob::Shading: return Levels.ShadingQuality;
+    case EQualityKnob::ViewDistance: return Levels.ViewDistanceQuality;
+    case EQualityKnob::AntiAliasing: return Levels.AntiAliasingQuality;
+    default: return 0;
+    }
+}
+
+void UQualityGovernor::SetKnobValue(Scalability::FQualityLevels & Levels, EQualityKnob::Type Knob, int32 Value) const
+{
+    switch(Knob)
+    {
+    case EQualityKnob::ScreenPercentage: Levels.ResolutionQuality = (float)Value; break;
+    case EQualityKnob::Shadow: Levels.ShadowQuality = Value; break;
+    case EQualityKnob::PostProcess: Levels.PostProcessQuality = Value; break;
+    case EQualityKnob::Effects: Levels.EffectsQuality = Value; break;
+    case EQualityKnob::Foliage: Levels.FoliageQuality = Value; break;
+    case EQualityKnob::Reflection: Levels.ReflectionQuality = Value; break;
+    case EQualityKnob::GlobalIllumination: Levels.GlobalIlluminationQuality = Value; break;
+    case EQualityKnob::Shading: Levels.ShadingQuality = Value; break;
+    case EQualityKnob::ViewDistance: Levels.ViewDistanceQuality = Value; break;
+    case EQualityKnob::AntiAliasing: Levels.AntiAliasingQuality = Value; break;
+    default: break;
+    }
+}
+
+int32 UQualityGovernor::GetKnobStep(const Scalability::FQualityLevels & Levels, EQualityKnob::Type Knob) const
+{
+    const int32 Value = GetKnobValue(Levels, Knob);
+
+    if(Knob != EQualityKnob::ScreenPercentage) return Value;
+
+    return FMath::Max(0, Value - MinScreenPercentage) / FMath::Max(1, ScreenPercentageStep);
+}
+
+/**
+ * Lowers the knob that is furthest above its minimum by one step, ties go to the knob that costs the least to look at (enum order).
+ *
+ * @return False if everything is at its minimum.
+ */
+bool UQualityGovernor::StepDown()
+{
+    Scalability::FQualityLevels Levels = Scalability::GetQualityLevels();
+
+    int32 BestKnob = INDEX_NONE;
+    int32 BestStep = 0;
+
+    for(int32 Knob = 0; Knob < EQualityKnob::Num; ++Knob)
+    {
+        const int32 Step = GetKnobStep(Levels, (EQualityKnob::Type)Knob);
+
+        if(Step > BestStep)
+        {
+            BestKnob = Knob;
+            BestStep = Step;
+        }
+    }
+
+    if(BestKnob == INDEX_NONE) return false;
+
+    const EQualityKnob::Type Knob = (EQualityKnob::Type)BestKnob;
+    const int32 OldValue = GetKnobValue(Levels, Knob);
+
+    SetKnobValue(Levels, Knob, Knob == EQualityKnob::ScreenPercentage ? FMath::Max(MinScreenPercentage, OldValue - ScreenPercentageStep) : OldValue - 1);
+
+    Apply(Knob, Levels, OldValue);
+
+    return true;
+}
+
+/**
+ * Raises the knob that is furthest below the ceiling by one step, in reverse order of StepDown so the last lowered knob comes back first.
+ *
+ * @return False if everything is at the ceiling.
+ */
+bool UQualityGovernor::StepUp()
+{
+    Scalability::FQualityLevels Levels = Scalability::GetQualityLevels();
+
+    int32 BestKnob = INDEX_NONE;
+    int32 BestStep = MAX_int32;
+
+    for(int32 Knob = EQualityKnob::Num - 1; Knob >= 0; --Knob)
+    {
+        const int32 Step = GetKnobStep(Levels, (EQualityKnob::Type)Knob);
+
+        if(Step < GetKnobStep(Ceiling, (EQualityKnob::Type)Knob) && Step < BestStep)
+        {
+            BestKnob = Knob;
+            BestStep = Step;
+        }
+    }
+
+    if(BestKnob == INDEX_NONE) return false;
+
+    const EQualityKnob::Type Knob = (EQualityKnob::Type)BestKnob;
+    const int32 OldValue = GetKnobValue(Levels, Knob);
+    const int32 CeilingValue = GetKnobValue(Ceiling, Knob);
+
+    SetKnobValue(Levels, Knob, Knob == EQualityKnob::ScreenPercentage ? FMath::Min(CeilingValue, OldValue + ScreenPercentageStep) : FMath::Min(CeilingValue, OldValue + 1));
+
+    Apply(Knob, Levels, OldValue);
+
+    return true;
+}
+
+/**
+ * Applies the levels and records the decision. They are live levels, saves go through SaveSettingsAtCeiling to keep them out of the saved settings.
+ */
+void UQualityGovernor::Apply(EQualityKnob::Type Knob, const Scalability::FQualityLevels & Levels, int32 OldValue)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(QualityGovernor_Apply);
+
+    Scalability::SetQualityLevels(Levels);
+
+    FQualityGovernorDecision Decision;
+    Decision.Time = FPlatformTime::Seconds();
+    Decision.Knob = Knob;
+    Decision.OldValue = OldValue;
+    Decision.NewValue = GetKnobValue(Levels, Knob);
+    Decision.FrameMs = SmoothedFrameMs;
+    Decision.GpuMs = SmoothedGpuMs;
+    Decision.TargetMs = GetTargetMs();
+
+    if(RecentDecisions.Num() >= MaxRecentDecisions)
+    {
+        RecentDecisions.RemoveAt(0, 1, false);
+    }
+
+    RecentDecisions.Add(Decision);
+
+    SESSION_LOG(Log, TEXT("Quality governor: %s %d -> %d (frame %.1f ms, GPU %.1f ms, target %.1f ms)"),
+        EQualityKnob::ToString(Knob), Decision.OldValue, Decision.NewValue, Decision.FrameMs, Decision.GpuMs, Decision.TargetMs);
+
+    OnDecision.Broadcast(Decision);
+}
@@ -0,0 +1,161 @@
+#include "SessionAsyncActions.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+/**
+ * Resolves the subsystem of the context's game instance and keeps the node alive until it finished.
+ *
+ * @param WorldContextObject Any object of the world the node runs in.
+ * @param InTimeout Seconds until the task fails with TimedOut.
+ */
+void USessionAsyncAction::Setup(const UObject * WorldContextObject, float InTimeout)
+{
+    Timeout = InTimeout;
+
+    UWorld * World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull) : nullptr;
+    UGameInstance * GameInstance = World ? World->GetGameInstance() : nullptr;
+
+    if(GameInstance)
+    {
+        Subsystem = GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>();
+
+        RegisterWithGameInstance(GameInstance);
+    }
+}
+
+/**
+ * Finishes the node when the task's future is fulfilled, which happens on the game thread.
+ *
+ * @param Task The task started by Activate.
+ */
+void USessionAsyncAction::WaitFor(FSessionTask && Task)
+{
+    TaskId = Task.Id;
+
+    Task.Result.Then([WeakThis = TWeakObjectPtr<USessionAsyncAction>(this)](TFuture<FSessionTaskResult> Future)
+    {
+        if(USessionAsyncAction * This = WeakThis.Get())
+        {
+            This->Finish(Future.Get());
+        }
+    });
+}
+
+void USessionAsyncAction::Cancel()
+{
+    if(bFinished) return;
+
+    if(Subsystem.IsValid() && TaskId != 0)
+    {
+        Subsystem->CancelSessionTask(TaskId);//fulfills the future, which finishes the node
+    }
+
+    if(!bFinished)
+    {
+        FSessionTaskResult Result;
+        Result.Status = ESessionTaskStatus::Cancelled;
+
+        Finish(Result);
+    }
+}
+
+void USessionAsyncAction::Finish(const FSessionTaskResult & Result)
+{
+    if(bFinished) return;
+
+    bFinished = true;
+
+    SetReadyToDestroy();
+
+    (Result.IsSuccess() ? OnSuccess : OnFailure).Broadcast(Result.Status, Result.NumSearchResults);
+}
+
+UCreateSessionAsyncAction * UCreateSessionAsyncAction::CreateSessionAsync(UObject * WorldContextObject, int32 NumPublicConnections, FString MatchType, float Timeout)
+{
+    UCreateSessionAsyncAction * Action = NewObject<UCreateSessionAsyncAction>();
+
+    Action->NumPublicConnections = NumPublicConnections;
+    Action->MatchType = MatchType;
+    Action->Setup(WorldContextObject, Timeout);
+
+    return Action;
+}
+
+void UCreateSessionAsyncAction::Activate()
+{
+    if(!Subsystem.IsValid())
+    {
+        Finish(FSessionTaskResult());
+
+        return;
+    }
+
+    WaitFor(Subsystem->CreateSessionAsync(NumPublicConnections, MatchType, Timeout));
+}
+
+UFindSessionsAsyncAction * UFindSessionsAsyncAction::FindSessionsAsync(UObject * WorldContextObject, int32 MaxSearchResults, float Timeout)
+{
+    UFindSessionsAsyncAction * Action = NewObject<UFindSessionsAsyncAction>();
+
+    Action->MaxSearchResults = MaxSearchResults;
+    Action->Setup(WorldContextObject, Timeout);
+
+    return Action;
+}
+
+void UFindSessionsAsyncAction::Activate()
+{
+    if(!Subsystem.IsValid())
+    {
+        Finish(FSessionTaskResult());
+
+        return;
+    }
+
+    WaitFor(Subsystem->FindSessionsAsync(FSessionQuery::Default().WithMaxResults(MaxSearchResults), Timeout));
+}
+
+UJoinSessionAsyncAction * UJoinSessionAsyncAction::JoinSessionAsync(UObject * WorldContextObject, int32 ResultIndex, float Timeout)
+{
+    UJoinSessionAsyncAction * Action = NewObject<UJoinSessionAsyncAction>();
+
+    Action->ResultIndex = ResultIndex;
+    Action->Setup(WorldContextObject, Timeout);
+
+    return Action;
+}
+
+void UJoinSessionAsyncAction::Activate()
+{
+    if(!Subsystem.IsValid())
+    {
+        Finish(FSessionTaskResult());
+
+        return;
+    }
+
+    WaitFor(Subsystem->JoinSessionAsync(Subsystem->GetSessionTable().MakeHandle(ResultIndex), Timeout));//an out of range index fails with SessionDoesNotExist
+}
+
+UDestroySessionAsyncAction * UDestroySessionAsyncAction::DestroySessionAsync(UObject * WorldContextObject, float Timeout)
+{
+    UDestroySessionAsyncAction * Action = NewObject<UDestroySessionAsyncAction>();
+
+    Action->Setup(WorldContextObject, Timeout);
+
+    return Action;
+}
+
+void UDestroySessionAsyncAction::Activate()
+{
+    if(!Subsystem.IsValid())
+    {
+        Finish(FSessionTaskResult());
+
+        return;
+    }
+
+    WaitFor(Subsystem->DestroySessionAsync(Timeout));
+}
@@ -0,0 +1,301 @@
+#include "SessionDescriptorTable.h"
+#include "Misc/MemStack.h"
+#include "OnlineSessionSettings.h"
+#include "SessionSettingsSchema.h"
+#include "Algo/StableSort.h"
+
+FSessionDescriptorTable::FSessionDescriptorTable() = default;
+
+FSessionDescriptorTable::~FSessionDescriptorTable() = default;//out of line so FMemStackBase can stay forward declared in the header
+
+FSessionDescriptorTable::FSessionDescriptorTable(FSessionDescriptorTable && Other)
+{
+    *this = MoveTemp(Other);
+}
+
+/**
+ * Takes over the arena of another table, the columns keep pointing into it.
+ */
+FSessionDescriptorTable & FSessionDescriptorTable::operator=(FSessionDescriptorTable && Other)
+{
+    if(this == &Other) return *this;
+
+    Arena = MoveTemp(Other.Arena);
+
+    SessionIds = Other.SessionIds;
+    OwnerNames = Other.OwnerNames;
+    MapNames = Other.MapNames;
+    GameTypes = Other.GameTypes;
+    PingsInMs = Other.PingsInMs;
+    OpenSlots = Other.OpenSlots;
+    PublicSlots = Other.PublicSlots;
+    PacketLoss = Other.PacketLoss;
+    SessionIdHashes = Other.SessionIdHashes;
+    RowFlags = Other.RowFlags;
+    NumRows = Other.NumRows;
+    Capacity = Other.Capacity;
+    Generation = Other.Generation;
+
+    Other.ResetColumns();
+
+    return *this;
+}
+
+/**
+ * Hashes a session id the same way for every table.
+ *
+ * @param SessionId The session id string.
+ * @return The hash stored in the SessionIdHashes column.
+ */
+uint32 FSessionDescriptorTable::HashSessionId(FStringView SessionId)
+{
+    return FCrc::MemCrc32(SessionId.GetData(), SessionId.Len() * sizeof(TCHAR));
+}
+
+/**
+ * Forgets every column without touching the arena.
+ */
+void FSessionDescriptorTable::ResetColumns()
+{
+    SessionIds = OwnerNames = MapNames = GameTypes = nullptr;
+    PingsInMs = OpenSlots = PublicSlots = nullptr;
+    PacketLoss = nullptr;
+    SessionIdHashes = nullptr;
+    RowFlags = nullptr;
+    NumRows = 0;
+    Capacity = 0;
+}
+
+/**
+ * Releases the previous generation and prepares the columns for a new search.
+ *
+ * @param InGeneration The search generation the new rows belong to.
+ * @param ExpectedNum How many rows to reserve, usually the MaxSearchResults of the search.
+ */
+void FSessionDescriptorTable::Reset(uint32 InGeneration, int32 ExpectedNum)
+{
+    Arena = MakeUnique<FMemStackBase>();//destroying the old arena frees every column and string of the previous generation at once
+
+    ResetColumns();
+    Generation = InGeneration;
+
+    Grow(FMath::Max(ExpectedNum, 1));
+}
+
+/**
+ * Appends the descriptor of a search result.
+ *
+ * @param Result The search result to describe.
+ * @return The index of the new row.
+ */
+int32 FSessionDescriptorTable::Append(const FOnlineSessionSearchResult & Result)
+{
+    const int32 Index = AddRow();
+    const FOnlineSessionSettings & Settings = Result.Session.SessionSettings;
+
+    SessionIds[Index] = CopyString(Result.GetSessionIdStr());
+    OwnerNames[Index] = CopyString(Result.Session.OwningUserName);
+
+    ScratchString.Reset();//keeps its allocation, so reading the string attributes of every row does not allocate
+    SessionSchema::Get<SessionSchema::FMatchType>(Settings, ScratchString);
+    MapNames[Index] = CopyString(ScratchString);
+
+    ScratchString.Reset();
+    SessionSchema::Get<SessionSchema::FGameType>(Settings, ScratchString);
+    GameTypes[Index] = CopyString(ScratchString);
+    PingsInMs[Index] = Result.PingInMs;
+    OpenSlots[Index] = Result.Session.NumOpenPublicConnections;
+    PublicSlots[Index] = Result.Session.SessionSettings.NumPublicConnections;
+    PacketLoss[Index] = 0;
+    SessionIdHashes[Index] = HashSessionId(SessionIds[Index]);
+    RowFlags[Index] = ESessionRowFlags::None;
+
+    return Index;
+}
+
+/**
+ * Appends a copy of a row of another table.
+ *
+ * @param Other The table to copy from, usually the previous generation.
+ * @param OtherIndex The row to copy.
+ * @param Flags The flags of the new row.
+ * @return The index of the new row.
+ */
+int32 FSessionDescriptorTable::AppendFrom(const FSessionDescriptorTable & Other, int32 OtherIndex, uint8 Flags)
+{
+    const int32 Index = AddRow();
+
+    SessionIds[Index] = CopyString(Other.SessionIds[OtherIndex]);
+    OwnerNames[Index] = CopyString(Other.OwnerNames[OtherIndex]);
+    MapNames[Index] = CopyString(Other.MapNames[OtherIndex]);
+    GameTypes[Index] = CopyString(Other.GameTypes[OtherIndex]);
+    PingsInMs[Index] = Other.PingsInMs[OtherIndex];
+    OpenSlots[Index] = Other.OpenSlots[OtherIndex];
+    PublicSlots[Index] = Other.PublicSlots[OtherIndex];
+    PacketLoss[Index] = Other.PacketLoss[OtherIndex];
+    SessionIdHashes[Index] = Other.SessionIdHashes[OtherIndex];
+    RowFlags[Index] = Flags;
+
+    return Index;
+}
+
+/**
+ * Appends a row that points at strings owned by someone else, e.g. a mapped snapshot, without touching the arena.
+ *
+ * @param SessionIdHash HashSessionId() of SessionId.
+ * @param Flags The flags of the new row.
+ * @return The index of the new row.
+ */
+int32 FSessionDescriptorTable::AppendExternal(FStringView SessionId, uint32 SessionIdHash, FStringView OwnerName, FStringView MapName, FStringView GameType, int32 PingInMs, int32 InOpenSlots, int32 InPublicSlots, uint8 Flags)
+{
+    const int32 Index = AddRow();
+
+    SessionIds[Index] = SessionId;
+    OwnerNames[Index] = OwnerName;
+    MapNames[Index] = MapName;
+    GameTypes[Index] = GameType;
+    PingsInMs[Index] = PingInMs;
+    OpenSlots[Index] = InOpenSlots;
+    PublicSlots[Index] = InPublicSlots;
+    PacketLoss[Index] = 0;
+    SessionIdHashes[Index] = SessionIdHash;
+    RowFlags[Index] = Flags;
+
+    return Index;
+}
+
+/**
+ * Stores the result of a QoS probe of a row.
+ *
+ * @param Index The row.
+ * @param RttMs The measured round trip time, INDEX_NONE if no probe was answered.
+ * @param LossPercent The percentage of probes that were not answered.
+ */
+void FSessionDescriptorTable::SetQos(int32 Index, int32 RttMs, uint8 LossPercent)
+{
+    if(RttMs != INDEX_NONE)
+    {
+        PingsInMs[Index] = RttMs;
+    }
+
+    PacketLoss[Index] = LossPercent;
+    RowFlags[Index] |= ESessionRowFlags::Probed;
+}
+
+/**
+ * Orders the rows by their effective latency, best first.
+ *
+ * @param OutRows Receives every row index, best first.
+ */
+void FSessionDescriptorTable::SortRowsByLatency(TArray<int32> & OutRows) const
+{
+    TArray<int64> Keys;//sort keys are extracted once instead of in every comparison
+    Keys.SetNumUninitialized(NumRows);
+
+    OutRows.SetNumUninitialized(NumRows);
+
+    for(int32 Index = 0; Index < NumRows; ++Index)
+    {
+        Keys[Index] = GetLatencySortKey(Index);
+        OutRows[Index] = Index;
+    }
+
+    Algo::StableSortBy(OutRows, [&Keys](int32 Index) { return Keys[Index]; });
+}
+
+/**
+ * The effective latency of a row is its ping plus a penalty for every lost percent of probes,
+ * a 20 ms host losing 10% of its packets ranks behind a clean 60 ms one. Disappeared rows always rank last.
+ *
+ * @param Index The row.
+ * @return The sort key of the row.
+ */
+int64 FSessionDescriptorTable::GetLatencySortKey(int32 Index) const
+{
+    constexpr int32 LossPenaltyMs = 5;//per lost percent
+
+    const bool bDisappeared = (RowFlags[Index] & ESessionRowFlags::Disappeared) != 0;
+    const int32 Ping = PingsInMs[Index] >= 0 ? PingsInMs[Index] : MAX_int16;//backends report unknown pings as negative values
+
+    return ((int64)bDisappeared << 32) | (int64)(Ping + PacketLoss[Index] * LossPenaltyMs);
+}
+
+/**
+ * Reserves the next row, growing the columns when needed.
+ *
+ * @return The index of the new, uninitialized row.
+ */
+int32 FSessionDescriptorTable::AddRow()
+{
+    if(!Arena.IsValid())
+    {
+        Reset(Generation, 1);
+    }
+
+    if(NumRows == Capacity)//backends are not strict about MaxSearchResults
+    {
+        Grow(Capacity * 2);
+    }
+
+    return NumRows++;
+}
+
+/**
+ * Moves the columns into larger arrays. The old arrays stay in the arena until the next reset.
+ *
+ * @param NewCapacity The number of rows the columns should fit.
+ */
+void FSessionDescriptorTable::Grow(int32 NewCapacity)
+{
+    GrowColumn(SessionIds, NewCapacity);
+    GrowColumn(OwnerNames, NewCapacity);
+    GrowColumn(MapNames, NewCapacity);
+    GrowColumn(GameTypes, NewCapacity);
+    GrowColumn(PingsInMs, NewCapacity);
+    GrowColumn(OpenSlots, NewCapacity);
+    GrowColumn(PublicSlots, NewCapacity);
+    GrowColumn(PacketLoss, NewCapacity);
+    GrowColumn(SessionIdHashes, NewCapacity);
+    GrowColumn(RowFlags, NewCapacity);
+
+    Capacity = NewCapacity;
+}
+
+template<typename T>
+void FSessionDescriptorTable::GrowColumn(T *& Column, int32 NewCapacity)
+{
+    T * NewColumn = AllocColumn<T>(NewCapacity);
+
+    if(Column && NumRows > 0)
+    {
+        FMemory::Memcpy(NewColumn, Column, NumRows * sizeof(T));
+    }
+
+    Column = NewColumn;
+}
+
+template<typename T>
+T * FSessionDescriptorTable::AllocColumn(int32 Count)
+{
+    static_assert(TIsTriviallyDestructible<T>::Value, "Arena columns are never destructed");
+
+    return reinterpret_cast<T *>(Arena->PushBytes(Count * sizeof(T), alignof(T)));
+}
+
+/**
+ * Copies a string into the arena.
+ *
+ * @param Source The string to copy.
+ * @return A view of the arena copy, valid until the next reset.
+ */
+FStringView FSessionDescriptorTable::CopyString(FStringView Source)
+{
+    const int32 Len = Source.Len();
+
+    if(Len == 0) return FStringView();
+
+    TCHAR * Dest = AllocColumn<TCHAR>(Len);
+    FMemory::Memcpy(Dest, Source.GetData(), Len * sizeof(TCHAR));
+
+    return FStringView(Dest, Len);
+}
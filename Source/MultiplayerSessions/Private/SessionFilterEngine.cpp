@@ -0,0 +1,353 @@
+#include "SessionFilterEngine.h"
+#include "SessionDescriptorTable.h"
+#include "Algo/StableSort.h"
+
+/**
+ * Brings the index up to date with the table, only rows that were not indexed yet are extracted and evaluated.
+ *
+ * @param Table The session table the server list is showing.
+ */
+void FSessionFilterEngine::Sync(const FSessionDescriptorTable & Table)
+{
+    if(Table.GetGeneration() != Generation || Table.Num() < NumRows)
+    {
+        Reset(Table.GetGeneration());
+    }
+
+    const int32 FirstRow = NumRows;
+
+    if(FirstRow == Table.Num()) return;
+
+    NumRows = Table.Num();
+
+    MapIds.Reserve(NumRows);
+    OpenSlots.Reserve(NumRows);
+    LatencyKeys.Reserve(NumRows);
+    HostNames.Reserve(NumRows);
+
+    const int32 FirstNewMap = MapNames.Num();
+
+    for(int32 Row = FirstRow; Row < NumRows; ++Row)
+    {
+        FString MapName = FString(Table.GetMapName(Row)).ToLower();
+
+        int32 MapId;
+
+        if(const int32 * ExistingId = MapIdsByName.Find(MapName))
+        {
+            MapId = *ExistingId;
+        }
+        else
+        {
+            MapId = MapNames.Num();
+
+            if(MapName == MapFilter) MapFilterId = MapId;//the filtered map was not listed before
+
+            MapIdsByName.Add(MapName, MapId);
+            MapNames.Add(MoveTemp(MapName));
+            RowsByMap.AddDefaulted();
+        }
+
+        MapIds.Add(MapId);
+        OpenSlots.Add(Table.GetOpenSlots(Row));
+        LatencyKeys.Add(Table.GetLatencySortKey(Row));
+        HostNames.Add(FString(Table.GetOwnerName(Row)).ToLower());
+    }
+
+    for(TBitArray<> & MapRows : RowsByMap)
+    {
+        MapRows.SetNum(NumRows, false);
+    }
+
+    for(int32 Row = FirstRow; Row < NumRows; ++Row)
+    {
+        RowsByMap[MapIds[Row]][Row] = true;
+    }
+
+    if(MapNames.Num() != FirstNewMap)
+    {
+        TArray<int32> Order;
+        Order.SetNumUninitialized(MapNames.Num());
+
+        for(int32 MapId = 0; MapId < MapNames.Num(); ++MapId) Order[MapId] = MapId;
+
+        Order.Sort([this](int32 A, int32 B) { return MapNames[A] < MapNames[B]; });
+
+        MapRanks.SetNumUninitialized(MapNames.Num());
+
+        for(int32 Rank = 0; Rank < Order.Num(); ++Rank) MapRanks[Order[Rank]] = Rank;
+    }
+
+    MapPass.SetNum(NumRows, false);
+    OpenSlotsPass.SetNum(NumRows, false);
+    HostNamePass.SetNum(NumRows, false);
+
+    EvaluateMap(FirstRow);
+    EvaluateOpenSlots(FirstRow);
+    EvaluateHostName(FirstRow, ERecheck::All);
+    CombineFilters();
+
+    bSortDirty = true;
+}
+
+/**
+ * Picks up the latency measured by the QoS probes without re-indexing the rows.
+ *
+ * @param Table The session table the probes were written to.
+ */
+void FSessionFilterEngine::RefreshLatency(const FSessionDescriptorTable & Table)
+{
+    if(Table.GetGeneration() != Generation)
+    {
+        Sync(Table);
+        return;
+    }
+
+    const int32 Count = FMath::Min(NumRows, Table.Num());
+
+    for(int32 Row = 0; Row < Count; ++Row)
+    {
+        LatencyKeys[Row] = Table.GetLatencySortKey(Row);
+    }
+
+    if(SortKey == ESessionSortKey::Latency) bSortDirty = true;
+}
+
+/**
+ * Shows only the sessions hosted on a map, resolved through the per-map row bitmaps.
+ *
+ * @param MapName The map to show, compared case insensitively. Empty shows every map.
+ * @return True if the filter changed.
+ */
+bool FSessionFilterEngine::SetMapFilter(FStringView MapName)
+{
+    FString NewFilter = FString(MapName).ToLower();
+
+    if(NewFilter == MapFilter) return false;
+
+    MapFilter = MoveTemp(NewFilter);
+
+    const int32 * MapId = MapIdsByName.Find(MapFilter);
+    MapFilterId = MapId ? *MapId : INDEX_NONE;
+
+    EvaluateMap(0);
+    CombineFilters();
+
+    return true;
+}
+
+/**
+ * Hides the sessions with fewer free slots.
+ *
+ * @param InMinOpenSlots The free slots a session needs to be shown, 0 shows full sessions too.
+ * @return True if the filter changed.
+ */
+bool FSessionFilterEngine::SetMinOpenSlots(int32 InMinOpenSlots)
+{
+    InMinOpenSlots = FMath::Max(InMinOpenSlots, 0);
+
+    if(InMinOpenSlots == MinOpenSlots) return false;
+
+    MinOpenSlots = InMinOpenSlots;
+
+    EvaluateOpenSlots(0);
+    CombineFilters();
+
+    return true;
+}
+
+/**
+ * Shows only the sessions whose host name contains the text.
+ * While the player keeps typing only the rows that still pass are tested again, deleting characters only tests the rows that failed.
+ *
+ * @param HostName The text to look for, compared case insensitively. Empty shows every host.
+ * @return True if the filter changed.
+ */
+bool FSessionFilterEngine::SetHostNameFilter(FStringView HostName)
+{
+    FString NewFilter = FString(HostName).ToLower();
+
+    if(NewFilter == HostNameFilter) return false;
+
+    ERecheck Recheck = ERecheck::All;
+
+    if(NewFilter.Contains(HostNameFilter, ESearchCase::CaseSensitive))
+    {
+        Recheck = ERecheck::Passing;
+    }
+    else if(HostNameFilter.Contains(NewFilter, ESearchCase::CaseSensitive))
+    {
+        Recheck = ERecheck::Failing;
+    }
+
+    HostNameFilter = MoveTemp(NewFilter);
+
+    EvaluateHostName(0, Recheck);
+    CombineFilters();
+
+    return true;
+}
+
+/**
+ * Changes the column the visible rows are ordered by, the order is computed the next time it is needed.
+ *
+ * @param InSortKey The column.
+ * @param bInDescending Reverses the order of the column.
+ * @return True if the order changed.
+ */
+bool FSessionFilterEngine::SetSortKey(ESessionSortKey::Type InSortKey, bool bInDescending)
+{
+    if(InSortKey == SortKey && bInDescending == bDescending) return false;
+
+    SortKey = InSortKey;
+    bDescending = bInDescending;
+    bSortDirty = true;
+
+    return true;
+}
+
+/**
+ * @param OutRows Receives the row indices that pass every filter, in sort order.
+ */
+void FSessionFilterEngine::GetVisibleRows(TArray<int32> & OutRows) const
+{
+    OutRows.Reset(NumRows);
+
+    for(int32 Row : GetSortedRows())
+    {
+        if(Passing[Row]) OutRows.Add(Row);
+    }
+}
+
+void FSessionFilterEngine::Reset(uint32 InGeneration)
+{
+    Generation = InGeneration;
+    NumRows = 0;
+
+    MapIds.Reset();
+    OpenSlots.Reset();
+    LatencyKeys.Reset();
+    HostNames.Reset();
+
+    MapIdsByName.Reset();
+    MapNames.Reset();
+    RowsByMap.Reset();
+    MapRanks.Reset();
+    MapFilterId = INDEX_NONE;//the predicates themselves survive, they are the player's choice
+
+    MapPass.Reset();
+    OpenSlotsPass.Reset();
+    HostNamePass.Reset();
+    Passing.Reset();
+
+    SortedRows.Reset();
+    bSortDirty = true;
+}
+
+/**
+ * @param FirstRow The first row to evaluate, earlier rows keep their result.
+ */
+void FSessionFilterEngine::EvaluateMap(int32 FirstRow)
+{
+    if(MapFilter.IsEmpty())
+    {
+        MapPass.SetRange(FirstRow, NumRows - FirstRow, true);
+    }
+    else if(MapFilterId == INDEX_NONE)
+    {
+        MapPass.SetRange(FirstRow, NumRows - FirstRow, false);//no listed session is hosted on that map
+    }
+    else if(FirstRow == 0)
+    {
+        MapPass = RowsByMap[MapFilterId];
+    }
+    else
+    {
+        for(int32 Row = FirstRow; Row < NumRows; ++Row)
+        {
+            MapPass[Row] = MapIds[Row] == MapFilterId;
+        }
+    }
+}
+
+/**
+ * @param FirstRow The first row to evaluate, earlier rows keep their result.
+ */
+void FSessionFilterEngine::EvaluateOpenSlots(int32 FirstRow)
+{
+    for(int32 Row = FirstRow; Row < NumRows; ++Row)
+    {
+        OpenSlotsPass[Row] = OpenSlots[Row] >= MinOpenSlots;
+    }
+}
+
+/**
+ * @param FirstRow The first row to evaluate, earlier rows keep their result.
+ * @param Recheck Which of the rows from FirstRow on can change their result.
+ */
+void FSessionFilterEngine::EvaluateHostName(int32 FirstRow, ERecheck Recheck)
+{
+    if(HostNameFilter.IsEmpty())
+    {
+        HostNamePass.SetRange(FirstRow, NumRows - FirstRow, true);
+        return;
+    }
+
+    for(int32 Row = FirstRow; Row < NumRows; ++Row)
+    {
+        const bool bPassed = HostNamePass[Row];
+
+        if((Recheck == ERecheck::Passing && !bPassed) || (Recheck == ERecheck::Failing && bPassed)) continue;
+
+        HostNamePass[Row] = HostNames[Row].Contains(HostNameFilter, ESearchCase::CaseSensitive);//both sides are lower case already
+    }
+}
+
+void FSessionFilterEngine::CombineFilters()
+{
+    Passing = MapPass;
+    Passing.CombineWithBitwiseAND(OpenSlotsPass, EBitwiseOperatorFlags::MaintainSize);
+    Passing.CombineWithBitwiseAND(HostNamePass, EBitwiseOperatorFlags::MaintainSize);
+}
+
+/**
+ * Every row in the order of the sort key, only sorted again after rows were added, keys changed or another key was picked.
+ */
+const TArray<int32> & FSessionFilterEngine::GetSortedRows() const
+{
+    if(!bSortDirty) return SortedRows;
+
+    SortedRows.SetNumUninitialized(NumRows);
+
+    for(int32 Row = 0; Row < NumRows; ++Row) SortedRows[Row] = Row;
+
+    const bool bReverse = bDescending;
+
+    switch(SortKey)
+    {
+    case ESessionSortKey::Latency:
+        Algo::StableSort(SortedRows, [this, bReverse](int32 A, int32 B) { return bReverse ? LatencyKeys[B] < LatencyKeys[A] : LatencyKeys[A] < LatencyKeys[B]; });
+        break;
+    case ESessionSortKey::OpenSlots:
+        Algo::StableSort(SortedRows, [this, bReverse](int32 A, int32 B) { return bReverse ? OpenSlots[B] < OpenSlots[A] : OpenSlots[A] < OpenSlots[B]; });
+        break;
+    case ESessionSortKey::HostName:
+        Algo::StableSort(SortedRows, [this, bReverse](int32 A, int32 B) { return bReverse ? HostNames[B] < HostNames[A] : HostNames[A] < HostNames[B]; });
+        break;
+    case ESessionSortKey::MapName:
+        Algo::StableSort(SortedRows, [this, bReverse](int32 A, int32 B)
+        {
+            const int32 RankA = MapRanks[MapIds[A]];
+            const int32 RankB = MapRanks[MapIds[B]];
+
+            return bReverse ? RankB < RankA : RankA < RankB;
+        });
+        break;
+    default:
+        break;
+    }
+
+    bSortDirty = false;
+
+    return SortedRows;
+}
@@ -0,0 +1,194 @@
+#include "SessionListSnapshot.h"
+#include "SessionDescriptorTable.h"
+#include "SessionQuery.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "SessionStats.h"
+
+static_assert(sizeof(FSessionListSnapshot::FHeader) == 32, "The snapshot header is part of the file layout, bump Version when it changes");
+static_assert(sizeof(FSessionListSnapshot::FRecord) == 36, "The snapshot record is part of the file layout, bump Version when it changes");
+
+namespace SessionListSnapshot
+{
+    static uint16 ClampLength(FStringView String)
+    {
+        return (uint16)FMath::Min(String.Len(), (int32)MAX_uint16);//longer strings are cut, no session attribute comes close
+    }
+
+    static uint32 HashOptional(const TOptional<FString> & Value)
+    {
+        return Value.IsSet() ? GetTypeHash(Value.GetValue()) : MAX_uint32;
+    }
+}
+
+FSessionListSnapshot::~FSessionListSnapshot()
+{
+    MappedRegion.Reset();//the region has to go before the file it maps
+    MappedFile.Reset();
+}
+
+FString FSessionListSnapshot::GetDefaultPath()
+{
+    return FPaths::ProjectSavedDir() / TEXT("MultiplayerSessions") / TEXT("LastSeenSessions.bin");
+}
+
+/**
+ * Hashes every constraint of a query, so a snapshot is only shown to a search that would have found the same sessions.
+ *
+ * @param Query The query of the search.
+ * @return A hash that is stable across launches.
+ */
+uint32 FSessionListSnapshot::HashQuery(const FSessionQuery & Query)
+{
+    uint32 Hash = SessionListSnapshot::HashOptional(Query.GameType);
+
+    Hash = HashCombine(Hash, SessionListSnapshot::HashOptional(Query.MatchType));
+    Hash = HashCombine(Hash, Query.BuildId.IsSet() ? GetTypeHash(Query.BuildId.GetValue()) : MAX_uint32);
+    Hash = HashCombine(Hash, GetTypeHash(Query.MinOpenSlots));
+    Hash = HashCombine(Hash, GetTypeHash(Query.MaxResults));
+    Hash = HashCombine(Hash, GetTypeHash(Query.bPresence));
+
+    return Hash;
+}
+
+/**
+ * Lays the rows out in a single buffer that is written to disk as is. Rows flagged as Disappeared are left out.
+ *
+ * @param Table The table of the last successful search.
+ * @param QueryHash HashQuery() of the search.
+ * @param OutBuffer Receives the snapshot.
+ */
+void FSessionListSnapshot::Write(const FSessionDescriptorTable & Table, uint32 QueryHash, TArray<uint8> & OutBuffer)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Snapshot_Write);
+
+    using namespace SessionListSnapshot;
+
+    int32 NumRecords = 0;
+    int32 NumChars = 0;
+
+    for(int32 Row = 0; Row < Table.Num(); ++Row)
+    {
+        if(Table.GetRowFlags(Row) & ESessionRowFlags::Disappeared) continue;
+
+        ++NumRecords;
+        NumChars += ClampLength(Table.GetSessionId(Row)) + ClampLength(Table.GetOwnerName(Row)) + ClampLength(Table.GetMapName(Row)) + ClampLength(Table.GetGameType(Row));
+    }
+
+    OutBuffer.SetNumUninitialized(sizeof(FHeader) + NumRecords * sizeof(FRecord) + NumChars * sizeof(TCHAR));
+
+    FHeader * OutHeader = reinterpret_cast<FHeader *>(OutBuffer.GetData());
+    FRecord * OutRecords = reinterpret_cast<FRecord *>(OutHeader + 1);
+    TCHAR * OutStrings = reinterpret_cast<TCHAR *>(OutRecords + NumRecords);
+
+    OutHeader->Magic = Magic;
+    OutHeader->Version = Version;
+    OutHeader->CharSize = sizeof(TCHAR);
+    OutHeader->QueryHash = QueryHash;
+    OutHeader->SavedTime = FDateTime::UtcNow().ToUnixTimestamp();
+    OutHeader->NumRecords = NumRecords;
+    OutHeader->NumChars = NumChars;
+
+    uint32 NextChar = 0;
+
+    auto AddString = [OutStrings, &NextChar](FStringView String, uint32 & OutOffset, uint16 & OutLength)
+    {
+        OutOffset = NextChar;
+        OutLength = ClampLength(String);
+
+        FMemory::Memcpy(OutStrings + NextChar, String.GetData(), OutLength * sizeof(TCHAR));
+        NextChar += OutLength;
+    };
+
+    FRecord * Record = OutRecords;
+
+    for(int32 Row = 0; Row < Table.Num(); ++Row)
+    {
+        if(Table.GetRowFlags(Row) & ESessionRowFlags::Disappeared) continue;
+
+        Record->SessionIdHash = Table.GetSessionIdHash(Row);
+        AddString(Table.GetSessionId(Row), Record->SessionIdOffset, Record->SessionIdLength);
+        AddString(Table.GetOwnerName(Row), Record->OwnerNameOffset, Record->OwnerNameLength);
+        AddString(Table.GetMapName(Row), Record->MapNameOffset, Record->MapNameLength);
+        AddString(Table.GetGameType(Row), Record->GameTypeOffset, Record->GameTypeLength);
+        Record->PingInMs = Table.GetPingInMs(Row);
+        Record->OpenSlots = (int16)FMath::Clamp(Table.GetOpenSlots(Row), (int32)MIN_int16, (int32)MAX_int16);
+        Record->PublicSlots = (int16)FMath::Clamp(Table.GetPublicSlots(Row), (int32)MIN_int16, (int32)MAX_int16);
+
+        ++Record;
+    }
+}
+
+/**
+ * Maps the snapshot into memory, or reads it in one go where files cannot be mapped. Only the header is checked.
+ *
+ * @param Path The snapshot file.
+ * @return The snapshot, null if there is none or its header does not match this build.
+ */
+TUniquePtr<FSessionListSnapshot> FSessionListSnapshot::Open(const FString & Path)
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Snapshot_Open);
+
+    if(!FPaths::FileExists(Path)) return nullptr;
+
+    TUniquePtr<FSessionListSnapshot> Snapshot(new FSessionListSnapshot());
+
+    Snapshot->MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+
+    if(Snapshot->MappedFile)
+    {
+        Snapshot->MappedRegion.Reset(Snapshot->MappedFile->MapRegion());
+    }
+
+    bool bValid = false;
+
+    if(Snapshot->MappedRegion)
+    {
+        bValid = Snapshot->Bind(Snapshot->MappedRegion->GetMappedPtr(), Snapshot->MappedRegion->GetMappedSize());
+    }
+    else if(FFileHelper::LoadFileToArray(Snapshot->LoadedFile, *Path))
+    {
+        bValid = Snapshot->Bind(Snapshot->LoadedFile.GetData(), Snapshot->LoadedFile.Num());
+    }
+
+    return bValid ? MoveTemp(Snapshot) : nullptr;
+}
+
+/**
+ * @param Data The start of the file, mapped regions and array allocations are aligned enough for the records.
+ * @param Size The size of the file.
+ * @return False if the header does not describe a file of exactly this size.
+ */
+bool FSessionListSnapshot::Bind(const uint8 * Data, int64 Size)
+{
+    if(!Data || Size < (int64)sizeof(FHeader)) return false;
+
+    const FHeader * FileHeader = reinterpret_cast<const FHeader *>(Data);
+
+    if(FileHeader->Magic != Magic || FileHeader->Version != Version || FileHeader->CharSize != sizeof(TCHAR)) return false;
+    if(FileHeader->NumRecords < 0 || FileHeader->NumChars < 0) return false;
+    if(Size != (int64)sizeof(FHeader) + (int64)FileHeader->NumRecords * sizeof(FRecord) + (int64)FileHeader->NumChars * sizeof(TCHAR)) return false;
+
+    Header = FileHeader;
+    Records = reinterpret_cast<const FRecord *>(Header + 1);
+    Strings = reinterpret_cast<const TCHAR *>(Records + Header->NumRecords);
+
+    return true;
+}
+
+FDateTime FSessionListSnapshot::GetSavedTime() const
+{
+    return FDateTime::FromUnixTimestamp(Header->SavedTime);
+}
+
+/**
+ * The offsets are only checked here, when a string is used, so opening the snapshot does not walk the records.
+ */
+FStringView FSessionListSnapshot::GetString(uint32 Offset, uint16 Length) const
+{
+    if((uint64)Offset + Length > (uint64)Header->NumChars) return FStringView();
+
+    return FStringView(Strings + Offset, Length);
+}
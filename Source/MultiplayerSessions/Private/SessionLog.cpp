@@ -0,0 +1,94 @@
+#include "SessionLog.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/OutputDeviceRedirector.h"
+
+DEFINE_LOG_CATEGORY(LogMultiplayerSessions);
+
+#if MULTIPLAYERSESSIONS_LOGGING
+
+FSessionEventRing & FSessionEventRing::Get()
+{
+    static FSessionEventRing Ring;
+
+    return Ring;
+}
+
+/**
+ * Claims the next slot and copies the message into it. The sequence is cleared while the slot is written,
+ * so a concurrent Dump skips it instead of reading a torn message.
+ *
+ * @param Verbosity The verbosity the message was logged with.
+ * @param Message The formatted message.
+ */
+void FSessionEventRing::Record(ELogVerbosity::Type Verbosity, const TCHAR * Message)
+{
+    const uint64 Index = NextIndex.IncrementExchange();
+    FSlot & Slot = Slots[Index % Capacity];
+
+    Slot.Sequence.Store(0);
+
+    Slot.Time = FPlatformTime::Seconds();
+    Slot.Verbosity = Verbosity;
+    FCString::Strncpy(Slot.Message, Message, MaxMessageLength);
+
+    Slot.Sequence.Store(Index + 1);
+}
+
+void FSessionEventRing::Dump(FOutputDevice & Ar) const
+{
+    const uint64 End = NextIndex.Load();
+    const uint64 Begin = End > Capacity ? End - Capacity : 0;
+
+    Ar.Logf(TEXT("=== MultiplayerSessions: last %d session events ==="), (int32)(End - Begin));
+
+    TCHAR Message[MaxMessageLength];
+
+    for(uint64 Index = Begin; Index < End; ++Index)
+    {
+        const FSlot & Slot = Slots[Index % Capacity];
+
+        if(Slot.Sequence.Load() != Index + 1) continue;//overwritten or still being written
+
+        const double Time = Slot.Time;
+        const ELogVerbosity::Type Verbosity = Slot.Verbosity;
+        FMemory::Memcpy(Message, Slot.Message, sizeof(Message));
+
+        if(Slot.Sequence.Load() != Index + 1) continue;//overwritten while copying
+
+        Message[MaxMessageLength - 1] = TEXT('\0');
+
+        Ar.Logf(TEXT("[%.3f] %s: %s"), Time, ToString(Verbosity), Message);
+    }
+}
+
+namespace SessionLog
+{
+    void DumpRecentEvents()
+    {
+        FSessionEventRing::Get().Dump(*GLog);
+
+        GLog->Flush();
+    }
+
+    static FAutoConsoleCommand DumpEventsCommand(
+        TEXT("MultiplayerSessions.DumpEvents"),
+        TEXT("Writes the most recent session events to the log."),
+        FConsoleCommandDelegate::CreateStatic(&DumpRecentEvents));
+
+    void Write(ELogVerbosity::Type Verbosity, const TCHAR * Message)
+    {
+        GLog->Serialize(Message, Verbosity, LogMultiplayerSessions.GetCategoryName());
+
+        FSessionEventRing::Get().Record(Verbosity, Message);
+
+        if(GEngine && Verbosity <= ELogVerbosity::Display && IsInGameThread())
+        {
+            const FColor Color = Verbosity <= ELogVerbosity::Error ? FColor::Red : Verbosity == ELogVerbosity::Warning ? FColor::Yellow : FColor::Green;
+
+            GEngine->AddOnScreenDebugMessage(-1, 5.f, Color, Message, true);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,29 @@
+#include "SessionOperation.h"
+
+FSessionOperation FSessionOperation::MakeCreate(int32 InNumPublicConnections, const FString & InMatchType)
+{
+    FSessionOperation Operation = Make(EType::Create);
+
+    Operation.NumPublicConnections = InNumPublicConnections;
+    Operation.MatchType = InMatchType;
+
+    return Operation;
+}
+
+FSessionOperation FSessionOperation::MakeCreate(FName InSessionName, const FOnlineSessionSettings & InSettings)
+{
+    FSessionOperation Operation = Make(EType::Create, InSessionName);
+
+    Operation.Settings = MakeShared<FOnlineSessionSettings>(InSettings);
+
+    return Operation;
+}
+
+FSessionOperation FSessionOperation::MakeJoin(const FOnlineSessionSearchResult & InSearchResult, FName InSessionName)
+{
+    FSessionOperation Operation = Make(EType::Join, InSessionName);
+
+    Operation.SearchResult = InSearchResult;
+
+    return Operation;
+}
@@ -0,0 +1,300 @@
+#include "SessionQos.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include "HAL/RunnableThread.h"
+#include "Async/Async.h"
+
+namespace SessionQos
+{
+    constexpr uint32 ProbeMagic = 0x5051534D;//"MSQP"
+
+    // Sent as raw bytes, prober and responder are the same build on little endian platforms
+    struct FProbePacket
+    {
+        uint32 Magic;
+        uint32 Nonce;
+        uint32 Target;
+        uint32 Sequence;
+    };
+
+    static void DestroySocket(FSocket *& Socket)
+    {
+        if(!Socket) return;
+
+        Socket->Close();
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+        Socket = nullptr;
+    }
+}
+
+FSessionQosProber::FSessionQosProber(const FSettings & InSettings):
+    Settings(InSettings)
+{
+    Settings.MaxOutstandingTargets = FMath::Max(Settings.MaxOutstandingTargets, 1);
+    Settings.ProbesPerTarget = FMath::Clamp(Settings.ProbesPerTarget, 1, 32);//replies are tracked in a 32 bit mask
+}
+
+FSessionQosProber::~FSessionQosProber()
+{
+    Cancel();
+}
+
+/**
+ * Starts probing the targets on a new thread.
+ *
+ * @param InTargets The hosts to probe.
+ * @param InOnComplete Called on the game thread with one result per target once every host answered or timed out.
+ * @return False if there is nothing to probe or the socket could not be created.
+ */
+bool FSessionQosProber::Start(TArray<FSessionQosTarget> && InTargets, FOnSessionQosProbesComplete InOnComplete)
+{
+    ISocketSubsystem * SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+    if(Thread || !SocketSubsystem || InTargets.Num() == 0) return false;
+
+    Targets = MoveTemp(InTargets);
+    OnComplete = MoveTemp(InOnComplete);
+    Results.Reset(Targets.Num());
+
+    Socket = SocketSubsystem->CreateSocket(NAME_DGram, TEXT("SessionQosProber"), Targets[0].Address->GetProtocolType());
+
+    if(!Socket) return false;
+
+    Socket->SetNonBlocking(true);
+
+    Nonce = (uint32)FMath::Rand() ^ FPlatformTime::Cycles();
+    bStopRequested = false;
+
+    Thread = FRunnableThread::Create(this, TEXT("SessionQosProber"), 0, TPri_AboveNormal);
+
+    return Thread != nullptr;
+}
+
+/**
+ * Stops the probing thread and closes the socket.
+ */
+void FSessionQosProber::Cancel()
+{
+    if(Thread)
+    {
+        Thread->Kill(true);//calls Stop and waits for Run to return
+        delete Thread;
+        Thread = nullptr;
+    }
+
+    SessionQos::DestroySocket(Socket);
+}
+
+/**
+ * Probing loop, keeps up to MaxOutstandingTargets hosts in flight until every target is finished.
+ */
+uint32 FSessionQosProber::Run()
+{
+    TSharedRef<FInternetAddr> FromAddress = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+
+    TArray<FTargetState> Active;
+    Active.Reserve(Settings.MaxOutstandingTargets);
+
+    int32 NextTarget = 0;
+
+    while(!bStopRequested)
+    {
+        const double Now = FPlatformTime::Seconds();
+
+        while(Active.Num() < Settings.MaxOutstandingTargets && NextTarget < Targets.Num())
+        {
+            FTargetState & State = Active.AddDefaulted_GetRef();
+            State.Target = NextTarget++;
+            State.NextProbeTime = Now;
+            State.SendTimes.SetNumZeroed(Settings.ProbesPerTarget);
+        }
+
+        if(Active.Num() == 0) break;//every target is finished
+
+        for(FTargetState & State : Active)
+        {
+            if(State.ProbesSent < Settings.ProbesPerTarget && Now >= State.NextProbeTime)
+            {
+                SendProbe(State, Now);
+            }
+        }
+
+        Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(2));
+
+        ReceiveReplies(Active, *FromAddress);
+
+        const double After = FPlatformTime::Seconds();
+
+        for(int32 Index = Active.Num() - 1; Index >= 0; --Index)
+        {
+            const FTargetState & State = Active[Index];
+
+            const bool bAllAnswered = State.Replies == Settings.ProbesPerTarget;
+            const bool bTimedOut = State.ProbesSent == Settings.ProbesPerTarget && After - State.LastProbeTime >= Settings.ProbeTimeout;
+
+            if(bAllAnswered || bTimedOut)
+            {
+                FinishTarget(State);
+                Active.RemoveAtSwap(Index);
+            }
+        }
+    }
+
+    if(!bStopRequested)
+    {
+        AsyncTask(ENamedThreads::GameThread, [Delegate = OnComplete, FinishedResults = MoveTemp(Results)]()
+        {
+            Delegate.ExecuteIfBound(FinishedResults);//bound with CreateUObject, so it is skipped if the owner is gone
+        });
+    }
+
+    return 0;
+}
+
+void FSessionQosProber::SendProbe(FTargetState & State, double Now)
+{
+    const SessionQos::FProbePacket Packet{ SessionQos::ProbeMagic, Nonce, (uint32)State.Target, (uint32)State.ProbesSent };
+
+    int32 BytesSent = 0;
+
+    State.SendTimes[State.ProbesSent] = Now;
+    Socket->SendTo(reinterpret_cast<const uint8 *>(&Packet), sizeof(Packet), BytesSent, *Targets[State.Target].Address);//a failed send just counts as a lost probe
+
+    ++State.ProbesSent;
+    State.LastProbeTime = Now;
+    State.NextProbeTime = Now + Settings.ProbeInterval;
+}
+
+/**
+ * Drains the socket and credits every valid reply to its target.
+ *
+ * @param Active The targets currently being probed.
+ * @param FromAddress Scratch address for RecvFrom.
+ */
+void FSessionQosProber::ReceiveReplies(TArray<FTargetState> & Active, FInternetAddr & FromAddress)
+{
+    uint32 PendingSize = 0;
+
+    while(Socket->HasPendingData(PendingSize))
+    {
+        SessionQos::FProbePacket Packet;
+        int32 BytesRead = 0;
+
+        if(!Socket->RecvFrom(reinterpret_cast<uint8 *>(&Packet), sizeof(Packet), BytesRead, FromAddress)) break;
+
+        const double Now = FPlatformTime::Seconds();
+
+        if(BytesRead != sizeof(Packet) || Packet.Magic != SessionQos::ProbeMagic || Packet.Nonce != Nonce) continue;
+
+        FTargetState * State = Active.FindByPredicate([&Packet](const FTargetState & Candidate) { return Candidate.Target == (int32)Packet.Target; });
+
+        if(!State || Packet.Sequence >= (uint32)State->ProbesSent) continue;//late reply of a finished target
+
+        const uint32 Bit = 1u << Packet.Sequence;
+
+        if(State->RepliedMask & Bit) continue;//duplicated datagram
+
+        State->RepliedMask |= Bit;
+        ++State->Replies;
+        State->RttSum += Now - State->SendTimes[Packet.Sequence];
+    }
+}
+
+void FSessionQosProber::FinishTarget(const FTargetState & State)
+{
+    FSessionQosResult & Result = Results.AddDefaulted_GetRef();
+
+    Result.Row = Targets[State.Target].Row;
+    Result.RttMs = State.Replies > 0 ? FMath::RoundToInt(State.RttSum / State.Replies * 1000.0) : INDEX_NONE;
+    Result.LossPercent = (uint8)((Settings.ProbesPerTarget - State.Replies) * 100 / Settings.ProbesPerTarget);
+}
+
+FSessionQosResponder::~FSessionQosResponder()
+{
+    Shutdown();
+}
+
+/**
+ * Binds the responder socket and starts the answering thread.
+ *
+ * @param Port The UDP port to listen on, if it is taken a free port is used instead.
+ * @return True if the responder is running, GetPort returns the port to advertise.
+ */
+bool FSessionQosResponder::Start(int32 Port)
+{
+    ISocketSubsystem * SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+    if(Thread || !SocketSubsystem) return false;
+
+    Socket = SocketSubsystem->CreateSocket(NAME_DGram, TEXT("SessionQosResponder"), FNetworkProtocolTypes::IPv4);
+
+    if(!Socket) return false;
+
+    TSharedRef<FInternetAddr> BindAddress = SocketSubsystem->CreateInternetAddr(FNetworkProtocolTypes::IPv4);
+    BindAddress->SetAnyAddress();
+    BindAddress->SetPort(Port);
+
+    if(!Socket->Bind(*BindAddress))
+    {
+        BindAddress->SetPort(0);//another instance on this machine already answers on the default port
+
+        if(!Socket->Bind(*BindAddress))
+        {
+            SessionQos::DestroySocket(Socket);
+
+            return false;
+        }
+    }
+
+    Socket->SetNonBlocking(true);
+    BoundPort = Socket->GetPortNo();
+    bStopRequested = false;
+
+    Thread = FRunnableThread::Create(this, TEXT("SessionQosResponder"), 0, TPri_AboveNormal);
+
+    return Thread != nullptr;
+}
+
+void FSessionQosResponder::Shutdown()
+{
+    if(Thread)
+    {
+        Thread->Kill(true);
+        delete Thread;
+        Thread = nullptr;
+    }
+
+    SessionQos::DestroySocket(Socket);
+    BoundPort = 0;
+}
+
+/**
+ * Echoes every valid probe back to its sender until stopped.
+ */
+uint32 FSessionQosResponder::Run()
+{
+    TSharedRef<FInternetAddr> FromAddress = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+
+    while(!bStopRequested)
+    {
+        if(!Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(100))) continue;
+
+        uint32 PendingSize = 0;
+
+        while(Socket->HasPendingData(PendingSize))
+        {
+            SessionQos::FProbePacket Packet;
+            int32 BytesRead = 0;
+
+            if(!Socket->RecvFrom(reinterpret_cast<uint8 *>(&Packet), sizeof(Packet), BytesRead, *FromAddress)) break;
+
+            if(BytesRead != sizeof(Packet) || Packet.Magic != SessionQos::ProbeMagic) continue;
+
+            int32 BytesSent = 0;
+            Socket->SendTo(reinterpret_cast<const uint8 *>(&Packet), sizeof(Packet), BytesSent, *FromAddress);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "SessionQuery.h"
+#include "SessionDescriptorTable.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "OnlineSessionSettings.h"
+#include "Online/OnlineSessionNames.h"
+#include "SessionSettingsSchema.h"
+#include "HAL/IConsoleManager.h"
+
+namespace SessionQuery
+{
+    static TAutoConsoleVariable<bool> CVarSearchDedicatedServers(
+        TEXT("MultiplayerSessions.SearchDedicatedServers"),
+        false,
+        TEXT("When true the default session query searches without presence, which finds the sessions of dedicated servers (UDedicatedServerHost) instead of player hosted ones.\n")
+        TEXT("On Steam a presence search only returns lobbies and a search without presence only game servers. Set it in the [ConsoleVariables] of DefaultEngine.ini."));
+}
+
+/**
+ * The query every plugin search starts from: our game type and our build.
+ * The menu, quick match, the async nodes and FindSessions(int32) all start from it, so MultiplayerSessions.SearchDedicatedServers
+ * switches every one of them to the sessions a fleet of dedicated servers registers.
+ *
+ * @return A query for sessions of this game and build.
+ */
+FSessionQuery FSessionQuery::Default()
+{
+    FSessionQuery Query;
+
+    Query.GameType = UMultiplayerSessionsSubsystem::SessionGameType;
+    Query.BuildId = UMultiplayerSessionsSubsystem::SessionBuildId;
+    Query.bPresence = !SessionQuery::CVarSearchDedicatedServers.GetValueOnAnyThread();//dedicated servers advertise without presence
+
+    return Query;
+}
+
+/**
+ * Writes the query into a search, the search's previous query settings are kept.
+ *
+ * @param Search The search to configure.
+ */
+void FSessionQuery::ApplyTo(FOnlineSessionSearch & Search) const
+{
+    Search.MaxSearchResults = MaxResults;
+
+    if(bPresence)
+    {
+        Search.QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);
+    }
+
+    if(GameType.IsSet())
+    {
+        SessionSchema::SetQuery<SessionSchema::FGameType>(Search, GameType.GetValue(), EOnlineComparisonOp::Equals);
+    }
+
+    if(MatchType.IsSet())
+    {
+        SessionSchema::SetQuery<SessionSchema::FMatchType>(Search, MatchType.GetValue(), EOnlineComparisonOp::Equals);
+    }
+
+    if(BuildId.IsSet())
+    {
+        SessionSchema::SetQuery<SessionSchema::FBuildId>(Search, BuildId.GetValue(), EOnlineComparisonOp::Equals);//advertised by CreateSession next to BuildUniqueId, which backends do not let us query
+    }
+
+    if(MinOpenSlots > 0)
+    {
+        Search.QuerySettings.Set(SEARCH_MINSLOTSAVAILABLE, MinOpenSlots, EOnlineComparisonOp::GreaterThanEquals);
+    }
+}
+
+/**
+ * Checks a row of the descriptor table against the query.
+ *
+ * @param Table The session table.
+ * @param Row The row to check.
+ * @return True if the row satisfies every constraint the table has a column for.
+ */
+bool FSessionQuery::Matches(const FSessionDescriptorTable & Table, int32 Row) const
+{
+    if(GameType.IsSet() && !Table.GetGameType(Row).Equals(GameType.GetValue())) return false;
+
+    if(MatchType.IsSet() && !Table.GetMapName(Row).Equals(MatchType.GetValue())) return false;
+
+    if(MinOpenSlots > 0 && Table.GetOpenSlots(Row) < MinOpenSlots) return false;
+
+    return true;
+}
+
+bool FSessionQuery::operator==(const FSessionQuery & Other) const
+{
+    return GameType == Other.GameType
+        && MatchType == Other.MatchType
+        && BuildId == Other.BuildId
+        && MinOpenSlots == Other.MinOpenSlots
+        && MaxResults == Other.MaxResults
+        && bPresence == Other.bPresence;
+}
@@ -0,0 +1,106 @@
+#include "SessionQuickMatch.h"
+#include "SessionDescriptorTable.h"
+#include "Math/VectorRegister.h"
+
+/**
+ * Gathers the joinable rows into aligned columns, scores them in one batch and orders them by score.
+ *
+ * @param Table The session table.
+ * @param Params The weights and limits of the quick match.
+ * @param Excluded Session id hashes that were already tried.
+ * @param OutRows Receives the candidate rows, best first.
+ */
+void SessionQuickMatch::RankCandidates(const FSessionDescriptorTable & Table, const FQuickMatchParams & Params, const TSet<uint32> & Excluded, TArray<int32> & OutRows)
+{
+    OutRows.Reset();
+
+    const int32 NumRows = Table.Num();
+
+    TArray<float, TAlignedHeapAllocator<16>> Latencies;
+    TArray<float, TAlignedHeapAllocator<16>> FillRatios;
+    TArray<float, TAlignedHeapAllocator<16>> MatchTypeHits;
+
+    Latencies.Reserve(Align(NumRows, 4));
+    FillRatios.Reserve(Align(NumRows, 4));
+    MatchTypeHits.Reserve(Align(NumRows, 4));
+
+    for(int32 Row = 0; Row < NumRows; ++Row)
+    {
+        if(Table.GetRowFlags(Row) & ESessionRowFlags::Disappeared) continue;
+        if(Table.GetOpenSlots(Row) <= 0 || !Params.Query.Matches(Table, Row)) continue;
+        if(Excluded.Contains(Table.GetSessionIdHash(Row))) continue;
+
+        const int32 ReportedPing = Table.GetPingInMs(Row);
+        const bool bPingUnknown = ReportedPing < 0 || ReportedPing >= 9999;//steam lobbies behind a relay report 9999 and cannot be probed
+
+        const int64 Latency = bPingUnknown ? Params.MaxPingMs : Table.GetLatencySortKey(Row);//ping plus the packet loss penalty
+
+        if(Latency > Params.MaxPingMs) continue;
+
+        const int32 PublicSlots = FMath::Max(Table.GetPublicSlots(Row), 1);
+
+        OutRows.Add(Row);
+        Latencies.Add((float)Latency);
+        FillRatios.Add(FMath::Clamp((float)(PublicSlots - Table.GetOpenSlots(Row)) / PublicSlots, 0.f, 1.f));
+        MatchTypeHits.Add(Params.PreferredMatchType.IsEmpty() || Table.GetMapName(Row).Equals(Params.PreferredMatchType, ESearchCase::IgnoreCase) ? 1.f : 0.f);
+    }
+
+    const int32 NumCandidates = OutRows.Num();
+
+    if(NumCandidates == 0) return;
+
+    const int32 NumPadded = Align(NumCandidates, 4);
+
+    Latencies.SetNumZeroed(NumPadded);
+    FillRatios.SetNumZeroed(NumPadded);
+    MatchTypeHits.SetNumZeroed(NumPadded);
+
+    TArray<float, TAlignedHeapAllocator<16>> Scores;
+    Scores.SetNumUninitialized(NumPadded);
+
+    ScoreBatch(Latencies.GetData(), FillRatios.GetData(), MatchTypeHits.GetData(), Scores.GetData(), NumPadded, Params);
+
+    TArray<int32> Order;//positions in the gathered columns
+    Order.SetNumUninitialized(NumCandidates);
+
+    for(int32 Index = 0; Index < NumCandidates; ++Index) Order[Index] = Index;
+
+    Order.StableSort([&Scores](int32 A, int32 B) { return Scores[A] > Scores[B]; });
+
+    TArray<int32> GatheredRows = MoveTemp(OutRows);
+    OutRows.SetNumUninitialized(NumCandidates);
+
+    for(int32 Index = 0; Index < NumCandidates; ++Index)
+    {
+        OutRows[Index] = GatheredRows[Order[Index]];
+    }
+}
+
+/**
+ * Score = PingWeight * (1 - Latency / MaxPingMs) + FillWeight * FillRatio + MatchTypeWeight * MatchTypeHit, four candidates per instruction.
+ *
+ * @param Latencies Effective latency of every candidate in ms, never above MaxPingMs.
+ * @param FillRatios Taken slots divided by public slots.
+ * @param MatchTypeHits 1 if the candidate plays the preferred match type.
+ * @param OutScores Receives the scores, higher is better.
+ * @param Num Number of candidates, a multiple of four.
+ * @param Params The weights.
+ */
+void SessionQuickMatch::ScoreBatch(const float * Latencies, const float * FillRatios, const float * MatchTypeHits, float * OutScores, int32 Num, const FQuickMatchParams & Params)
+{
+    check(Num % 4 == 0);
+
+    const VectorRegister4Float PingWeight = VectorSetFloat1(Params.PingWeight);
+    const VectorRegister4Float PingSlope = VectorSetFloat1(-Params.PingWeight / FMath::Max(Params.MaxPingMs, 1));
+    const VectorRegister4Float FillWeight = VectorSetFloat1(Params.FillWeight);
+    const VectorRegister4Float MatchTypeWeight = VectorSetFloat1(Params.MatchTypeWeight);
+
+    for(int32 Index = 0; Index < Num; Index += 4)
+    {
+        VectorRegister4Float Score = VectorMultiplyAdd(VectorLoadAligned(Latencies + Index), PingSlope, PingWeight);
+        Score = VectorMultiplyAdd(VectorLoadAligned(FillRatios + Index), FillWeight, Score);
+        Score = VectorMultiplyAdd(VectorLoadAligned(MatchTypeHits + Index), MatchTypeWeight, Score);
+
+        VectorStoreAligned(Score, OutScores + Index);
+    }
+}
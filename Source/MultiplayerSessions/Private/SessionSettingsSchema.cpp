@@ -0,0 +1,9 @@
+#include "SessionSettingsSchema.h"
+
+// The key names, interned once when the module loads
+#define SESSION_SCHEMA_DEFINE_ATTRIBUTE(Key, Type, AdvertisementType) \
+    const FName SessionSchema::F##Key::Name(TEXT(#Key));
+
+SESSION_SCHEMA_ATTRIBUTES(SESSION_SCHEMA_DEFINE_ATTRIBUTE)
+
+#undef SESSION_SCHEMA_DEFINE_ATTRIBUTE
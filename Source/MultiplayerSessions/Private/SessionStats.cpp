@@ -0,0 +1,56 @@
+#include "SessionStats.h"
+
+DEFINE_STAT(STAT_SessionOperationsInFlight);
+DEFINE_STAT(STAT_SessionSearchesInFlight);
+DEFINE_STAT(STAT_SessionTasksInFlight);
+
+DEFINE_STAT(STAT_HostToCreatedMs);
+DEFINE_STAT(STAT_HostToStartedMs);
+DEFINE_STAT(STAT_HostToTravelMs);
+DEFINE_STAT(STAT_SearchToFirstRowMs);
+DEFINE_STAT(STAT_JoinToTravelMs);
+
+LLM_DEFINE_TAG(MultiplayerSessions);
+LLM_DEFINE_TAG(MultiplayerSessions_SearchResults);
+LLM_DEFINE_TAG(MultiplayerSessions_Widgets);
+
+#if MULTIPLAYERSESSIONS_INSTRUMENTATION
+
+UE_TRACE_CHANNEL_DEFINE(MultiplayerSessionsChannel);
+
+TRACE_DECLARE_INT_COUNTER(SessionOperationsInFlight, TEXT("MultiplayerSessions/Session Operations In Flight"));
+TRACE_DECLARE_INT_COUNTER(SessionSearchesInFlight, TEXT("MultiplayerSessions/Searches In Flight"));
+TRACE_DECLARE_INT_COUNTER(SessionTasksInFlight, TEXT("MultiplayerSessions/Async Tasks In Flight"));
+
+namespace SessionStats
+{
+    static const TCHAR * SpanNames[ESessionSpan::Num] = { TEXT("MultiplayerSessions Host"), TEXT("MultiplayerSessions Search"), TEXT("MultiplayerSessions Join") };
+    static double SpanStartTimes[ESessionSpan::Num] = {};//0 while the span is not open, only touched on the game thread
+
+    void BeginSpan(ESessionSpan::Type Span)
+    {
+        check(IsInGameThread());
+
+        EndSpan(Span);
+
+        SpanStartTimes[Span] = FPlatformTime::Seconds();
+
+        TRACE_BEGIN_REGION(SpanNames[Span]);
+    }
+
+    double GetSpanMs(ESessionSpan::Type Span)
+    {
+        return SpanStartTimes[Span] > 0.0 ? (FPlatformTime::Seconds() - SpanStartTimes[Span]) * 1000.0 : -1.0;
+    }
+
+    void EndSpan(ESessionSpan::Type Span)
+    {
+        if(SpanStartTimes[Span] <= 0.0) return;
+
+        SpanStartTimes[Span] = 0.0;
+
+        TRACE_END_REGION(SpanNames[Span]);
+    }
+}
+
+#endif
@@ -0,0 +1,198 @@
+#include "SettingsTransaction.h"
+#include "DeathEcho/Settings/DESettings.h"
+#include "QualityGovernor.h"
+#include "SessionLog.h"
+#include "SessionStats.h"
+
+namespace SettingsTransaction
+{
+    static UDESettings * GetSettings()
+    {
+        return Cast<UDESettings>(UDESettings::GetGameUserSettings());
+    }
+
+    // None of the settings the transaction stages needs a restart, engine settings that do (RHI, ...) are not staged here
+    static constexpr uint8 RestartRequired = ESettingsChange::None;
+}
+
+/**
+ * A debounced commit that is still scheduled is dropped with the transaction, call Commit() first to keep it.
+ */
+FSettingsTransaction::~FSettingsTransaction()
+{
+    FTSTicker::GetCoreTicker().RemoveTicker(DebounceTickerHandle);
+}
+
+/**
+ * @param Level The overall scalability level, 0 (low) to 3 (epic).
+ */
+void FSettingsTransaction::SetScalabilityLevel(int32 Level)
+{
+    UDESettings * Settings = SettingsTransaction::GetSettings();
+
+    ScalabilityLevel = Level;
+
+    Stage(ESettingsChange::Scalability, !Settings || Settings->GetOverallScalabilityLevel() != Level);//-1 (custom) differs from every level
+}
+
+void FSettingsTransaction::SetResolution(FIntPoint InResolution)
+{
+    UDESettings * Settings = SettingsTransaction::GetSettings();
+
+    Resolution = InResolution;
+
+    Stage(ESettingsChange::Resolution, !Settings || Settings->GetScreenResolution() != InResolution);
+}
+
+void FSettingsTransaction::SetWindowMode(EWindowMode::Type InWindowMode)
+{
+    UDESettings * Settings = SettingsTransaction::GetSettings();
+
+    WindowMode = InWindowMode;
+
+    Stage(ESettingsChange::WindowMode, !Settings || Settings->GetFullscreenMode() != InWindowMode);
+}
+
+void FSettingsTransaction::SetMasterVolume(float Volume)
+{
+    UDESettings * Settings = SettingsTransaction::GetSettings();
+
+    MasterVolume = Volume;
+
+    Stage(ESettingsChange::Audio, !Settings || !FMath::IsNearlyEqual(Settings->GetMasterSoundVolume(), Volume));
+}
+
+void FSettingsTransaction::SetMouseSensitivity(float Sensitivity)
+{
+    UDESettings * Settings = SettingsTransaction::GetSettings();
+
+    MouseSensitivity = Sensitivity;
+
+    Stage(ESettingsChange::Input, !Settings || !FMath::IsNearlyEqual(Settings->GetMouseSensitivity(), Sensitivity));
+}
+
+void FSettingsTransaction::Stage(ESettingsChange::Type Change, bool bDiffers)
+{
+    if(bDiffers)
+    {
+        PendingChanges |= Change;
+    }
+    else
+    {
+        PendingChanges &= ~Change;//set back to the current value
+    }
+}
+
+/**
+ * Applies every staged change through the narrowest apply that covers it and saves the settings once.
+ *
+ * @return What was applied, switched the display mode or needs a restart.
+ */
+FSettingsCommitResult FSettingsTransaction::Commit()
+{
+    SESSION_SCOPE_CYCLE_COUNTER(Settings_Commit);
+
+    FTSTicker::GetCoreTicker().RemoveTicker(DebounceTickerHandle);
+    DebounceTickerHandle.Reset();
+
+    FSettingsCommitResult Result;
+
+    UDESettings * Settings = SettingsTransaction::GetSettings();
+
+    if(!Settings)
+    {
+        SESSION_LOG(Error, TEXT("Game User Settings is null"));
+        return Result;
+    }
+
+    const uint8 Changes = PendingChanges;
+    PendingChanges = ESettingsChange::None;
+
+    if(Changes == ESettingsChange::None) return Result;
+
+    if(Changes & ESettingsChange::Input)
+    {
+        Settings->SetMouseSensitivity(MouseSensitivity);
+    }
+
+    if(Changes & ESettingsChange::Audio)
+    {
+        Settings->SetMasterSoundVolume(MasterVolume);
+    }
+
+    if(Changes & ESettingsChange::Scalability)
+    {
+        Settings->SetOverallScalabilityLevel(ScalabilityLevel);
+        Settings->ApplyNonResolutionSettings();
+    }
+
+    if(Changes & (ESettingsChange::Resolution | ESettingsChange::WindowMode))
+    {
+        const bool bWindowModeChanged = (Changes & ESettingsChange::WindowMode) != 0;
+
+        if(Changes & ESettingsChange::Resolution)
+        {
+            Settings->SetScreenResolution(Resolution);
+        }
+
+        if(bWindowModeChanged)
+        {
+            Settings->SetFullscreenMode(WindowMode);
+        }
+
+        Settings->ApplyResolutionSettings(false);
+
+        // entering, leaving or resizing exclusive fullscreen switches the display mode
+        if(bWindowModeChanged || Settings->GetFullscreenMode() == EWindowMode::Fullscreen)
+        {
+            Result.ModeSwitches = Changes & (ESettingsChange::Resolution | ESettingsChange::WindowMode);
+        }
+    }
+
+    if(QualityGovernor.IsValid() && !(Changes & ESettingsChange::Scalability))
+    {
+        QualityGovernor->SaveSettingsAtCeiling(*Settings);//the live levels may be a downshift of the governor
+    }
+    else
+    {
+        Settings->SaveSettings();//a new quality pick is the new ceiling, the menu resets the governor to it
+    }
+
+    Result.Applied = Changes;
+    Result.RestartRequired = Changes & SettingsTransaction::RestartRequired;
+
+    SESSION_LOG(Log, TEXT("Applied settings changes 0x%02x (mode switches 0x%02x, restart required 0x%02x)"), Result.Applied, Result.ModeSwitches, Result.RestartRequired);
+
+    OnCommitted.ExecuteIfBound(Result);
+
+    return Result;
+}
+
+/**
+ * Restarts the debounce delay, so a burst of clicks is applied once, Delay seconds after the last one.
+ *
+ * @param Delay Seconds without further commits before the changes are applied.
+ */
+void FSettingsTransaction::CommitDebounced(float Delay)
+{
+    FTSTicker::GetCoreTicker().RemoveTicker(DebounceTickerHandle);
+
+    DebounceTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FSettingsTransaction::OnDebounceElapsed), Delay);
+}
+
+bool FSettingsTransaction::OnDebounceElapsed(float DeltaTime)
+{
+    DebounceTickerHandle.Reset();//removed by returning false
+
+    Commit();
+
+    return false;
+}
+
+void FSettingsTransaction::Reset()
+{
+    FTSTicker::GetCoreTicker().RemoveTicker(DebounceTickerHandle);
+    DebounceTickerHandle.Reset();
+
+    PendingChanges = ESettingsChange::None;
+}
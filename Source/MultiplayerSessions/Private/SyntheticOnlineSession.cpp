@@ -0,0 +1,867 @@
+#include "SyntheticOnlineSession.h"
+#include "OnlineSubsystemTypes.h"
+#include "Online/OnlineSessionNames.h"
+#include "Misc/CommandLine.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "SessionSettingsSchema.h"
+#include "SessionLog.h"
+
+namespace SyntheticSession
+{
+    static const FName IdType(TEXT("Synthetic"));
+    static const TCHAR * Maps[] = { TEXT("D_ShootingRange"), TEXT("Arena_2"), TEXT("Canyon"), TEXT("Harbor") };
+    static const int32 Sizes[] = { 2, 4, 8, 16 };
+
+    /**
+     * Session info of the sessions the backend advertises and hosts, identified by a string id.
+     */
+    class FSessionInfo : public FOnlineSessionInfo
+    {
+    public:
+        explicit FSessionInfo(const FString & Id):
+            SessionId(FUniqueNetIdString::Create(Id, IdType))
+        {
+        }
+
+        virtual const uint8 * GetBytes() const override { return nullptr; }
+        virtual int32 GetSize() const override { return sizeof(FSessionInfo); }
+        virtual bool IsValid() const override { return true; }
+        virtual FString ToString() const override { return SessionId->ToString(); }
+        virtual FString ToDebugString() const override { return FString::Printf(TEXT("Synthetic session %s"), *SessionId->ToString()); }
+        virtual const FUniqueNetId & GetSessionId() const override { return *SessionId; }
+
+    private:
+        FUniqueNetIdStringRef SessionId;
+    };
+
+    static bool IsEarlier(const double DueTime, const uint64 Sequence, const double OtherDueTime, const uint64 OtherSequence)
+    {
+        return DueTime < OtherDueTime || (DueTime == OtherDueTime && Sequence < OtherSequence);
+    }
+}
+
+bool USyntheticSessionBackendSettings::IsEnabled()
+{
+    return GetDefault<USyntheticSessionBackendSettings>()->bEnabled || FParse::Param(FCommandLine::Get(), TEXT("SyntheticSessions"));
+}
+
+/**
+ * Seeds the random stream, advertises the generated sessions and starts completing calls on the core ticker.
+ *
+ * @param InSettings The settings, must outlive the backend (the class default object does).
+ */
+FSyntheticOnlineSession::FSyntheticOnlineSession(const USyntheticSessionBackendSettings & InSettings):
+    Settings(InSettings),
+    Random(InSettings.RandomSeed)
+{
+    AdvertiseSessions();
+
+    TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FSyntheticOnlineSession::Tick));
+
+    SESSION_LOG(Display, TEXT("Synthetic session backend: %d sessions advertised, seed %d"), NumGeneratedSessions, Settings.RandomSeed);
+}
+
+/**
+ * Calls that have not completed yet are dropped, like a backend that went away.
+ */
+FSyntheticOnlineSession::~FSyntheticOnlineSession()
+{
+    FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+}
+
+void FSyntheticOnlineSession::AdvertiseSessions()
+{
+    NumGeneratedSessions = FMath::Max(0, Settings.NumAdvertisedSessions);
+
+    Advertised.Reset(NumGeneratedSessions);
+
+    for(int32 Index = 0; Index < NumGeneratedSessions; ++Index)
+    {
+        Advertised.Add(MakeAdvertisedSession());
+    }
+}
+
+/**
+ * Generates a session somebody else hosts. A few of them are of another game or build, so the search filters have something to do.
+ *
+ * @return The session.
+ */
+FOnlineSession FSyntheticOnlineSession::MakeAdvertisedSession()
+{
+    FOnlineSession Session;
+    FOnlineSessionSettings & SessionSettings = Session.SessionSettings;
+
+    Session.SessionInfo = MakeShared<SyntheticSession::FSessionInfo>(FString::Printf(TEXT("SYN-%08X"), Random.GetUnsignedInt()));
+    Session.OwningUserName = FString::Printf(TEXT("Synthetic_%05u"), Random.GetUnsignedInt() % 100000);
+
+    SessionSettings.NumPublicConnections = SyntheticSession::Sizes[Random.RandHelper(UE_ARRAY_COUNT(SyntheticSession::Sizes))];
+    SessionSettings.bShouldAdvertise = true;
+    SessionSettings.bAllowJoinInProgress = true;
+    SessionSettings.bUsesPresence = true;
+    SessionSettings.bUseLobbiesIfAvailable = true;
+
+    const bool bOtherGame = Random.FRand() < 0.03f;
+    const bool bOtherBuild = Random.FRand() < 0.05f;
+
+    SessionSchema::Set<SessionSchema::FMatchType>(SessionSettings, FString(SyntheticSession::Maps[Random.RandHelper(UE_ARRAY_COUNT(SyntheticSession::Maps))]));
+    SessionSchema::Set<SessionSchema::FGameType>(SessionSettings, FString(bOtherGame ? TEXT("SomeOtherGame") : UMultiplayerSessionsSubsystem::SessionGameType));
+    SessionSchema::Set<SessionSchema::FBuildId>(SessionSettings, bOtherBuild ? UMultiplayerSessionsSubsystem::SessionBuildId + 1 : UMultiplayerSessionsSubsystem::SessionBuildId);
+
+    SessionSettings.BuildUniqueId = bOtherBuild ? UMultiplayerSessionsSubsystem::SessionBuildId + 1 : UMultiplayerSessionsSubsystem::SessionBuildId;
+
+    Session.NumOpenPublicConnections = Random.RandRange(0, SessionSettings.NumPublicConnections);
+
+    return Session;
+}
+
+/**
+ * Completes the calls that are due, in due time and then call order. A completion may schedule further calls.
+ */
+bool FSyntheticOnlineSession::Tick(float DeltaTime)
+{
+    const double Now = FPlatformTime::Seconds();
+
+    auto Earlier = [](const FPendingCall & A, const FPendingCall & B) { return SyntheticSession::IsEarlier(A.DueTime, A.Sequence, B.DueTime, B.Sequence); };
+
+    while(PendingCalls.Num() > 0 && PendingCalls.HeapTop().DueTime <= Now)
+    {
+        FPendingCall Call;
+        PendingCalls.HeapPop(Call, Earlier, false);
+
+        Call.Complete();
+    }
+
+    return true;
+}
+
+/**
+ * Completes a call after Delay seconds, never synchronously, so callers always see their delegate fire after the call returned.
+ *
+ * @param Delay Seconds until the call completes.
+ * @param Complete Triggers the completion delegates.
+ */
+void FSyntheticOnlineSession::Schedule(double Delay, TFunction<void()> && Complete)
+{
+    FPendingCall Call;
+    Call.DueTime = FPlatformTime::Seconds() + Delay;
+    Call.Sequence = NextCallSequence++;
+    Call.Complete = MoveTemp(Complete);
+
+    PendingCalls.HeapPush(MoveTemp(Call), [](const FPendingCall & A, const FPendingCall & B) { return SyntheticSession::IsEarlier(A.DueTime, A.Sequence, B.DueTime, B.Sequence); });
+}
+
+/**
+ * @return A latency in seconds, normally distributed (Box-Muller) with an occasional tail spike on top.
+ */
+double FSyntheticOnlineSession::RollLatency()
+{
+    const double U1 = FMath::Max((double)Random.GetFraction(), 1e-6);
+    const double U2 = Random.GetFraction();
+    const double Normal = FMath::Sqrt(-2.0 * FMath::Loge(U1)) * FMath::Cos(2.0 * PI * U2);
+
+    double Latency = Settings.LatencyMean + Settings.LatencyStdDev * Normal;
+
+    if(Roll(Settings.LatencyTailChance))
+    {
+        Latency += Settings.LatencyTail * Random.GetFraction();
+    }
+
+    return FMath::Max(Latency, 0.0);
+}
+
+bool FSyntheticOnlineSession::Roll(float Chance)
+{
+    return Chance > 0.f && Random.GetFraction() < Chance;
+}
+
+/**
+ * Counts the call against a one second window.
+ *
+ * @return True if the call is over MaxCallsPerSecond and has to fail.
+ */
+bool FSyntheticOnlineSession::IsThrottled()
+{
+    if(Settings.MaxCallsPerSecond <= 0) return false;
+
+    const double Now = FPlatformTime::Seconds();
+
+    int32 Expired = 0;
+    while(Expired < RecentCallTimes.Num() && RecentCallTimes[Expired] <= Now - 1.0) ++Expired;
+
+    RecentCallTimes.RemoveAt(0, Expired, false);
+
+    if(RecentCallTimes.Num() >= Settings.MaxCallsPerSecond)
+    {
+        SESSION_LOG(Verbose, TEXT("Synthetic session backend: call throttled"));
+        return true;
+    }
+
+    RecentCallTimes.Add(Now);
+
+    return false;
+}
+
+int32 FSyntheticOnlineSession::FindAdvertised(const FString & SessionId) const
+{
+    return Advertised.IndexOfByPredicate([&SessionId](const FOnlineSession & Session) { return Session.GetSessionIdStr() == SessionId; });
+}
+
+/**
+ * Applies the query of a search to an advertised session. Keys a session does not advertise are not filtered on,
+ * like the presence and lobby keys the real backends interpret themselves.
+ *
+ * @param Session The advertised session.
+ * @param Query The query settings of the search.
+ * @return True if the search finds the session.
+ */
+bool FSyntheticOnlineSession::Matches(const FOnlineSession & Session, const FOnlineSearchSettings & Query) const
+{
+    for(const TPair<FName, FOnlineSessionSearchParam> & Param : Query.SearchParams)
+    {
+        if(Param.Key == SEARCH_MINSLOTSAVAILABLE)
+        {
+            int32 MinSlots = 0;
+            Param.Value.Data.GetValue(MinSlots);
+
+            if(Session.NumOpenPublicConnections < MinSlots) return false;
+            continue;
+        }
+
+        const FOnlineSessionSetting * Setting = Session.SessionSettings.Settings.Find(Param.Key);
+
+        if(!Setting) continue;
+
+        switch(Param.Value.ComparisonOp)
+        {
+        case EOnlineComparisonOp::Equals:
+            if(!(Setting->Data == Param.Value.Data)) return false;
+            break;
+        case EOnlineComparisonOp::NotEquals:
+            if(Setting->Data == Param.Value.Data) return false;
+            break;
+        default:
+            break;//the plugin only queries for equality
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Between two searches other players join and leave the generated sessions and hosts go away, their slot is taken by a new session.
+ */
+void FSyntheticOnlineSession::ChurnAdvertisedSessions()
+{
+    for(int32 Index = 0; Index < NumGeneratedSessions; ++Index)
+    {
+        if(!Roll(Settings.SessionChurnRate)) continue;
+
+        FOnlineSession & Session = Advertised[Index];
+
+        switch(Random.RandHelper(3))
+        {
+        case 0:
+            Session.NumOpenPublicConnections = FMath::Min(Session.NumOpenPublicConnections + 1, Session.SessionSettings.NumPublicConnections);
+            break;
+        case 1:
+            Session.NumOpenPublicConnections = FMath::Max(Session.NumOpenPublicConnections - 1, 0);
+            break;
+        default:
+            Session = MakeAdvertisedSession();
+            break;
+        }
+    }
+}
+
+/**
+ * Appends one slice of the matches to the results of the current search.
+ *
+ * @param Slice The slice to deliver.
+ * @param NumSlices The number of slices the matches are delivered in.
+ */
+void FSyntheticOnlineSession::DeliverSearchSlice(int32 Slice, int32 NumSlices)
+{
+    const int32 Begin = CurrentSearchMatches.Num() * Slice / NumSlices;
+    const int32 End = CurrentSearchMatches.Num() * (Slice + 1) / NumSlices;
+
+    TArray<FOnlineSessionSearchResult> & Results = CurrentSearch->SearchResults;
+    Results.Reserve(CurrentSearchMatches.Num());
+
+    for(int32 Index = Begin; Index < End; ++Index)
+    {
+        const FOnlineSession & Session = Advertised[CurrentSearchMatches[Index]];
+
+        FOnlineSessionSearchResult & Result = Results.AddDefaulted_GetRef();
+        Result.Session = Session;
+        Result.PingInMs = 10 + GetTypeHash(Session.GetSessionIdStr()) % 190;//stable per session
+    }
+}
+
+void FSyntheticOnlineSession::FinishSearch(bool bWasSuccessful)
+{
+    TSharedPtr<FOnlineSessionSearch> Search = MoveTemp(CurrentSearch);
+    CurrentSearchMatches.Reset();
+
+    if(!Search) return;
+
+    Search->SearchState = bWasSuccessful ? EOnlineAsyncTaskState::Done : EOnlineAsyncTaskState::Failed;
+
+    TriggerOnFindSessionsCompleteDelegates(bWasSuccessful);
+}
+
+FUniqueNetIdPtr FSyntheticOnlineSession::CreateSessionIdFromString(const FString & SessionIdStr)
+{
+    return SessionIdStr.IsEmpty() ? nullptr : FUniqueNetIdString::Create(SessionIdStr, SyntheticSession::IdType);
+}
+
+FNamedOnlineSession * FSyntheticOnlineSession::GetNamedSession(FName SessionName)
+{
+    for(FNamedOnlineSession & Session : Sessions)
+    {
+        if(Session.SessionName == SessionName) return &Session;
+    }
+
+    return nullptr;
+}
+
+void FSyntheticOnlineSession::RemoveNamedSession(FName SessionName)
+{
+    for(int32 Index = 0; Index < Sessions.Num(); ++Index)
+    {
+        if(Sessions[Index].SessionName == SessionName)
+        {
+            Sessions.RemoveAt(Index);
+            return;
+        }
+    }
+}
+
+EOnlineSessionState::Type FSyntheticOnlineSession::GetSessionState(FName SessionName) const
+{
+    for(const FNamedOnlineSession & Session : Sessions)
+    {
+        if(Session.SessionName == SessionName) return Session.SessionState;
+    }
+
+    return EOnlineSessionState::NoSession;
+}
+
+bool FSyntheticOnlineSession::HasPresenceSession()
+{
+    for(const FNamedOnlineSession & Session : Sessions)
+    {
+        if(Session.SessionSettings.bUsesPresence) return true;
+    }
+
+    return false;
+}
+
+FNamedOnlineSession * FSyntheticOnlineSession::AddNamedSession(FName SessionName, const FOnlineSessionSettings & SessionSettings)
+{
+    return &Sessions[Sessions.Add(new FNamedOnlineSession(SessionName, SessionSettings))];
+}
+
+FNamedOnlineSession * FSyntheticOnlineSession::AddNamedSession(FName SessionName, const FOnlineSession & Session)
+{
+    return &Sessions[Sessions.Add(new FNamedOnlineSession(SessionName, Session))];
+}
+
+bool FSyntheticOnlineSession::CreateSession(int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings & NewSessionSettings)
+{
+    return CreateSession(*FUniqueNetIdString::Create(FString::Printf(TEXT("SyntheticPlayer_%d"), HostingPlayerNum), SyntheticSession::IdType), SessionName, NewSessionSettings);
+}
+
+/**
+ * Hosts a session that searches of this backend find once the create completed.
+ */
+bool FSyntheticOnlineSession::CreateSession(const FUniqueNetId & HostingPlayerId, FName SessionName, const FOnlineSessionSettings & NewSessionSettings)
+{
+    if(GetNamedSession(SessionName)) return false;
+
+    FNamedOnlineSession * Session = AddNamedSession(SessionName, NewSessionSettings);
+    Session->SessionState = EOnlineSessionState::Creating;
+    Session->OwningUserId = HostingPlayerId.AsShared();
+    Session->OwningUserName = TEXT("SyntheticHost");
+    Session->LocalOwnerId = HostingPlayerId.AsShared();
+    Session->bHosting = true;
+    Session->NumOpenPublicConnections = NewSessionSettings.NumPublicConnections;
+    Session->NumOpenPrivateConnections = NewSessionSettings.NumPrivateConnections;
+    Session->SessionInfo = MakeShared<SyntheticSession::FSessionInfo>(FString::Printf(TEXT("SYN-HOST-%u"), ++NextSessionNumber));
+
+    const bool bFail = IsThrottled() || Roll(Settings.FailureRate);
+
+    Schedule(RollLatency(), [this, SessionName, bFail]()
+    {
+        FNamedOnlineSession * Created = GetNamedSession(SessionName);
+
+        if(!Created || bFail)
+        {
+            RemoveNamedSession(SessionName);
+            TriggerOnCreateSessionCompleteDelegates(SessionName, false);
+            return;
+        }
+
+        Created->SessionState = EOnlineSessionState::Pending;
+
+        if(Created->SessionSettings.bShouldAdvertise)
+        {
+            Advertised.Add(*Created);
+        }
+
+        TriggerOnCreateSessionCompleteDelegates(SessionName, true);
+    });
+
+    return true;
+}
+
+bool FSyntheticOnlineSession::StartSession(FName SessionName)
+{
+    FNamedOnlineSession * Session = GetNamedSession(SessionName);
+
+    if(!Session || (Session->SessionState != EOnlineSessionState::Pending && Session->SessionState != EOnlineSessionState::Ended)) return false;
+
+    Session->SessionState = EOnlineSessionState::Starting;
+
+    const bool bFail = IsThrottled() || Roll(Settings.FailureRate);
+
+    Schedule(RollLatency(), [this, SessionName, bFail]()
+    {
+        FNamedOnlineSession * Started = GetNamedSession(SessionName);
+
+        if(Started)
+        {
+            Started->SessionState = bFail ? EOnlineSessionState::Pending : EOnlineSessionState::InProgress;
+        }
+
+        TriggerOnStartSessionCompleteDelegates(SessionName, Started && !bFail);
+    });
+
+    return true;
+}
+
+bool FSyntheticOnlineSession::UpdateSession(FName SessionName, FOnlineSessionSettings & UpdatedSessionSettings, bool bShouldRefreshOnlineData)
+{
+    FNamedOnlineSession * Session = GetNamedSession(SessionName);
+
+    if(!Session) return false;
+
+    Session->SessionSettings = UpdatedSessionSettings;
+
+    const int32 Index = FindAdvertised(Session->GetSessionIdStr());
+
+    if(Index != INDEX_NONE)
+    {
+        Advertised[Index].SessionSettings = UpdatedSessionSettings;
+    }
+
+    Schedule(RollLatency(), [this, SessionName]()
+    {
+        TriggerOnUpdateSessionCompleteDelegates(SessionName, GetNamedSession(SessionName) != nullptr);
+    });
+
+    return true;
+}
+
+bool FSyntheticOnlineSession::EndSession(FName SessionName)
+{
+    FNamedOnlineSession * Session = GetNamedSession(SessionName);
+
+    if(!Session || Session->SessionState != EOnlineSessionState::InProgress) return false;
+
+    Session->SessionState = EOnlineSessionState::Ending;
+
+    Schedule(RollLatency(), [this, SessionName]()
+    {
+        FNamedOnlineSession * Ended = GetNamedSession(SessionName);
+
+        if(Ended)
+        {
+            Ended->SessionState = EOnlineSessionState::Ended;
+        }
+
+        TriggerOnEndSessionCompleteDelegates(SessionName, Ended != nullptr);
+    });
+
+    return true;
+}
+
+/**
+ * Destroys a hosted or joined session. A failed destroy leaves the session as it was, so the caller can retry.
+ */
+bool FSyntheticOnlineSession::DestroySession(FName SessionName, const FOnDestroySessionCompleteDelegate & CompletionDelegate)
+{
+    FNamedOnlineSession * Session = GetNamedSession(SessionName);
+
+    if(!Session || Session->SessionState == EOnlineSessionState::Destroying) return false;
+
+    const EOnlineSessionState::Type PreviousState = Session->SessionState;
+    Session->SessionState = EOnlineSessionState::Destroying;
+
+    const bool bFail = IsThrottled() || Roll(Settings.FailureRate);
+
+    Schedule(RollLatency(), [this, SessionName, CompletionDelegate, PreviousState, bFail]()
+    {
+        FNamedOnlineSession * Destroyed = GetNamedSession(SessionName);
+
+        if(Destroyed && bFail)
+        {
+            Destroyed->SessionState = PreviousState;
+        }
+        else if(Destroyed)
+        {
+            if(Destroyed->bHosting)
+            {
+                const int32 Index = FindAdvertised(Destroyed->GetSessionIdStr());
+
+                if(Index != INDEX_NONE)
+                {
+                    Advertised.RemoveAt(Index);
+                }
+            }
+
+            RemoveNamedSession(SessionName);
+        }
+
+        const bool bWasSuccessful = Destroyed && !bFail;
+
+        CompletionDelegate.ExecuteIfBound(SessionName, bWasSuccessful);
+        TriggerOnDestroySessionCompleteDelegates(SessionName, bWasSuccessful);
+    });
+
+    return true;
+}
+
+bool FSyntheticOnlineSession::IsPlayerInSession(FName SessionName, const FUniqueNetId & UniqueId)
+{
+    FNamedOnlineSession * Session = GetNamedSession(SessionName);
+
+    return Session && Session->RegisteredPlayers.ContainsByPredicate([&UniqueId](const FUniqueNetIdRef & Player) { return *Player == UniqueId; });
+}
+
+bool FSyntheticOnlineSession::StartMatchmaking(const TArray<FUniqueNetIdRef> & LocalPlayers, FName SessionName, const FOnlineSessionSettings & NewSessionSettings, TSharedRef<FOnlineSessionSearch> & SearchSettings)
+{
+    return false;//not simulated
+}
+
+bool FSyntheticOnlineSession::CancelMatchmaking(int32 SearchingPlayerNum, FName SessionName)
+{
+    return false;
+}
+
+bool FSyntheticOnlineSession::CancelMatchmaking(const FUniqueNetId & SearchingPlayerId, FName SessionName)
+{
+    return false;
+}
+
+bool FSyntheticOnlineSession::FindSessions(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch> & SearchSettings)
+{
+    return FindSessions(*FUniqueNetIdString::Create(FString::Printf(TEXT("SyntheticPlayer_%d"), SearchingPlayerNum), SyntheticSession::IdType), SearchSettings);
+}
+
+/**
+ * Matches the query against the advertised sessions right away and delivers the matches in slices over the simulated latency,
+ * so SearchResults grows while SearchState is InProgress like it does with the real backends.
+ */
+bool FSyntheticOnlineSession::FindSessions(const FUniqueNetId & SearchingPlayerId, const TSharedRef<FOnlineSessionSearch> & SearchSettings)
+{
+    if(CurrentSearch.IsValid()) return false;//one search at a time
+
+    CurrentSearch = SearchSettings;
+    CurrentSearch->SearchState = EOnlineAsyncTaskState::InProgress;
+    CurrentSearch->SearchResults.Reset();
+
+    const uint32 Serial = ++SearchSerial;
+
+    if(IsThrottled())
+    {
+        Schedule(RollLatency(), [this, Serial]() { if(Serial == SearchSerial) FinishSearch(false); });
+        return true;
+    }
+
+    ChurnAdvertisedSessions();
+
+    CurrentSearchMatches.Reset();
+
+    const int32 MaxResults = SearchSettings->MaxSearchResults > 0 ? SearchSettings->MaxSearchResults : MAX_int32;
+
+    for(int32 Index = 0; Index < Advertised.Num() && CurrentSearchMatches.Num() < MaxResults; ++Index)
+    {
+        if(Matches(Advertised[Index], SearchSettings->QuerySettings))
+        {
+            CurrentSearchMatches.Add(Index);
+        }
+    }
+
+    const bool bFail = Roll(Settings.FailureRate);
+    const bool bPartialFailure = Roll(Settings.PartialSearchFailureRate);
+    const int32 NumSlices = FMath::Max(1, Settings.SearchResultSlices);
+    const int32 FailedSlice = bFail ? 0 : bPartialFailure ? FMath::Max(1, NumSlices / 2) : INDEX_NONE;//a partial failure keeps the slices delivered before it
+    const double Latency = RollLatency();
+
+    for(int32 Slice = 0; Slice < NumSlices; ++Slice)
+    {
+        Schedule(Latency * (Slice + 1) / NumSlices, [this, Serial, Slice, NumSlices, FailedSlice]()
+        {
+            if(Serial != SearchSerial || !CurrentSearch) return;//cancelled, or failed in an earlier slice
+
+            if(Slice == FailedSlice)
+            {
+                FinishSearch(false);
+                return;
+            }
+
+            DeliverSearchSlice(Slice, NumSlices);
+
+            if(Slice == NumSlices - 1)
+            {
+                FinishSearch(true);
+            }
+        });
+    }
+
+    return true;
+}
+
+bool FSyntheticOnlineSession::FindSessionById(const FUniqueNetId & SearchingUserId, const FUniqueNetId & SessionId, const FUniqueNetId & FriendId, const FOnSingleSessionResultCompleteDelegate & CompletionDelegate)
+{
+    const FString Id = SessionId.ToString();
+
+    Schedule(RollLatency(), [this, Id, CompletionDelegate]()
+    {
+        FOnlineSessionSearchResult Result;
+        const int32 Index = FindAdvertised(Id);
+
+        if(Index != INDEX_NONE)
+        {
+            Result.Session = Advertised[Index];
+        }
+
+        CompletionDelegate.ExecuteIfBound(0, Index != INDEX_NONE, Result);
+    });
+
+    return true;
+}
+
+bool FSyntheticOnlineSession::CancelFindSessions()
+{
+    if(!CurrentSearch) return false;
+
+    ++SearchSerial;//the pending slices of the search are dropped
+
+    CurrentSearch->SearchState = EOnlineAsyncTaskState::Failed;
+    CurrentSearch.Reset();
+    CurrentSearchMatches.Reset();
+
+    Schedule(0.0, [this]() { TriggerOnCancelFindSessionsCompleteDelegates(true); });
+
+    return true;
+}
+
+bool FSyntheticOnlineSession::PingSearchResults(const FOnlineSessionSearchResult & SearchResult)
+{
+    return false;
+}
+
+bool FSyntheticOnlineSession::JoinSession(int32 LocalUserNum, FName SessionName, const FOnlineSessionSearchResult & DesiredSession)
+{
+    return JoinSession(*FUniqueNetIdString::Create(FString::Printf(TEXT("SyntheticPlayer_%d"), LocalUserNum), SyntheticSession::IdType), SessionName, DesiredSession);
+}
+
+/**
+ * Joins an advertised session. The session can be gone or have filled up since the search, and the join can lose a race for the last slot.
+ */
+bool FSyntheticOnlineSession::JoinSession(const FUniqueNetId & LocalUserId, FName SessionName, const FOnlineSessionSearchResult & DesiredSession)
+{
+    if(GetNamedSession(SessionName)) return false;
+
+    FNamedOnlineSession * Session = AddNamedSession(SessionName, DesiredSession.Session);
+    Session->SessionState = EOnlineSessionState::Creating;
+    Session->LocalOwnerId = LocalUserId.AsShared();
+    Session->bHosting = false;
+
+    const FString Id = DesiredSession.GetSessionIdStr();
+    const bool bFail = IsThrottled() || Roll(Settings.FailureRate);
+    const bool bLoseRace = Roll(Settings.JoinFullRaceRate);
+
+    Schedule(RollLatency(), [this, SessionName, Id, bFail, bLoseRace]()
+    {
+        EOnJoinSessionCompleteResult::Type Result = EOnJoinSessionCompleteResult::Success;
+        const int32 Index = FindAdvertised(Id);
+
+        if(bFail)
+        {
+            Result = EOnJoinSessionCompleteResult::UnknownError;
+        }
+        else if(Index == INDEX_NONE)
+        {
+            Result = EOnJoinSessionCompleteResult::SessionDoesNotExist;
+        }
+        else if(Advertised[Index].NumOpenPublicConnections <= 0 || bLoseRace)
+        {
+            Advertised[Index].NumOpenPublicConnections = 0;
+            Result = EOnJoinSessionCompleteResult::SessionIsFull;
+        }
+        else
+        {
+            --Advertised[Index].NumOpenPublicConnections;
+        }
+
+        FNamedOnlineSession * Joined = GetNamedSession(SessionName);
+
+        if(Result == EOnJoinSessionCompleteResult::Success && Joined)
+        {
+            Joined->SessionState = EOnlineSessionState::Pending;
+        }
+        else
+        {
+            RemoveNamedSession(SessionName);
+        }
+
+        TriggerOnJoinSessionCompleteDelegates(SessionName, Result);
+    });
+
+    return true;
+}
+
+bool FSyntheticOnlineSession::FindFriendSession(int32 LocalUserNum, const FUniqueNetId & Friend)
+{
+    return false;//there are no friends in the synthetic backend
+}
+
+bool FSyntheticOnlineSession::FindFriendSession(const FUniqueNetId & LocalUserId, const FUniqueNetId & Friend)
+{
+    return false;
+}
+
+bool FSyntheticOnlineSession::FindFriendSession(const FUniqueNetId & LocalUserId, const TArray<FUniqueNetIdRef> & FriendList)
+{
+    return false;
+}
+
+bool FSyntheticOnlineSession::SendSessionInviteToFriend(int32 LocalUserNum, FName SessionName, const FUniqueNetId & Friend)
+{
+    return false;
+}
+
+bool FSyntheticOnlineSession::SendSessionInviteToFriend(const FUniqueNetId & LocalUserId, FName SessionName, const FUniqueNetId & Friend)
+{
+    return false;
+}
+
+bool FSyntheticOnlineSession::SendSessionInviteToFriends(int32 LocalUserNum, FName SessionName, const TArray<FUniqueNetIdRef> & Friends)
+{
+    return false;
+}
+
+bool FSyntheticOnlineSession::SendSessionInviteToFriends(const FUniqueNetId & LocalUserId, FName SessionName, const TArray<FUniqueNetIdRef> & Friends)
+{
+    return false;
+}
+
+/**
+ * Every synthetic session resolves to the local machine, so a travel after a join reaches a locally running host, if any.
+ */
+bool FSyntheticOnlineSession::GetResolvedConnectString(FName SessionName, FString & ConnectInfo, FName PortType)
+{
+    FNamedOnlineSession * Session = GetNamedSession(SessionName);
+
+    if(!Session || !Session->SessionInfo.IsValid()) return false;
+
+    ConnectInfo = TEXT("127.0.0.1:7777");
+
+    return true;
+}
+
+bool FSyntheticOnlineSession::GetResolvedConnectString(const FOnlineSessionSearchResult & SearchResult, FName PortType, FString & ConnectInfo)
+{
+    if(!SearchResult.IsValid()) return false;
+
+    ConnectInfo = TEXT("127.0.0.1:7777");
+
+    return true;
+}
+
+FOnlineSessionSettings * FSyntheticOnlineSession::GetSessionSettings(FName SessionName)
+{
+    FNamedOnlineSession * Session = GetNamedSession(SessionName);
+
+    return Session ? &Session->SessionSettings : nullptr;
+}
+
+bool FSyntheticOnlineSession::RegisterPlayer(FName SessionName, const FUniqueNetId & PlayerId, bool bWasInvited)
+{
+    return RegisterPlayers(SessionName, { PlayerId.AsShared() }, bWasInvited);
+}
+
+bool FSyntheticOnlineSession::RegisterPlayers(FName SessionName, const TArray<FUniqueNetIdRef> & Players, bool bWasInvited)
+{
+    FNamedOnlineSession * Session = GetNamedSession(SessionName);
+
+    if(Session)
+    {
+        for(const FUniqueNetIdRef & Player : Players)
+        {
+            if(!Session->RegisteredPlayers.ContainsByPredicate([&Player](const FUniqueNetIdRef & Registered) { return *Registered == *Player; }))
+            {
+                Session->RegisteredPlayers.Add(Player);
+            }
+        }
+    }
+
+    TriggerOnRegisterPlayersCompleteDelegates(SessionName, Players, Session != nullptr);
+
+    return Session != nullptr;
+}
+
+bool FSyntheticOnlineSession::UnregisterPlayer(FName SessionName, const FUniqueNetId & PlayerId)
+{
+    return UnregisterPlayers(SessionName, { PlayerId.AsShared() });
+}
+
+bool FSyntheticOnlineSession::UnregisterPlayers(FName SessionName, const TArray<FUniqueNetIdRef> & Players)
+{
+    FNamedOnlineSession * Session = GetNamedSession(SessionName);
+
+    if(Session)
+    {
+        for(const FUniqueNetIdRef & Player : Players)
+        {
+            Session->RegisteredPlayers.RemoveAll([&Player](const FUniqueNetIdRef & Registered) { return *Registered == *Player; });
+        }
+    }
+
+    TriggerOnUnregisterPlayersCompleteDelegates(SessionName, Players, Session != nullptr);
+
+    return Session != nullptr;
+}
+
+void FSyntheticOnlineSession::RegisterLocalPlayer(const FUniqueNetId & PlayerId, FName SessionName, const FOnRegisterLocalPlayerCompleteDelegate & Delegate)
+{
+    Delegate.ExecuteIfBound(PlayerId, EOnJoinSessionCompleteResult::Success);
+}
+
+void FSyntheticOnlineSession::UnregisterLocalPlayer(const FUniqueNetId & PlayerId, FName SessionName, const FOnUnregisterLocalPlayerCompleteDelegate & Delegate)
+{
+    Delegate.ExecuteIfBound(PlayerId, true);
+}
+
+void FSyntheticOnlineSession::RemovePlayerFromSession(int32 LocalUserNum, FName SessionName, const FUniqueNetId & TargetPlayerId)
+{
+    UnregisterPlayer(SessionName, TargetPlayerId);
+}
+
+int32 FSyntheticOnlineSession::GetNumSessions()
+{
+    return Sessions.Num();
+}
+
+void FSyntheticOnlineSession::DumpSessionState()
+{
+    SESSION_LOG(Display, TEXT("Synthetic session backend: %d advertised, %d pending calls, search %s"), Advertised.Num(), PendingCalls.Num(), CurrentSearch ? TEXT("in progress") : TEXT("idle"));
+
+    for(const FNamedOnlineSession & Session : Sessions)
+    {
+        SESSION_LOG(Display, TEXT("  %s: %s, %s, %d open slots"), *Session.SessionName.ToString(), *Session.GetSessionIdStr(),
+            EOnlineSessionState::ToString(Session.SessionState), Session.NumOpenPublicConnections);
+    }
+}
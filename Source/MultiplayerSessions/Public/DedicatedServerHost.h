@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
+#include "SessionOperation.h"
+#include "DedicatedServerHost.generated.h"
+
+/**
+ * How a dedicated server instance exits, the fleet launcher decides from it how to replace the instance.
+ */
+namespace EDedicatedServerExit
+{
+	enum Type : uint8
+	{
+		Recycled = 0,		// the match ended, a fresh instance takes the slot right away
+		RegisterFailed = 2,	// the session could not be created, the slot is restarted after a back-off
+	};
+}
+
+/**
+ * Hosts the game session of a dedicated server, where there is no local player and no menu to do it.
+ *
+ * Once the server has loaded its first map the session is created and advertised, the match type defaults to the map's name.
+ * When the match ends (RecycleInstance, or the server stays empty for EmptyRecycleSeconds after players joined)
+ * the session is destroyed and the process exits, so the fleet launcher starts a fresh instance in its place
+ * instead of one process carrying the state of every match it ever hosted.
+ *
+ * The launcher passes -FleetInstance=<N> -QosPort=<Port>; -SessionSlots=<N> and -MatchType=<Name> override the config.
+ * The session is advertised without presence, clients find it with a query WithPresence(false):
+ * set MultiplayerSessions.SearchDedicatedServers=1 and FSessionQuery::Default, and every search built on it, does so.
+ * [/Script/MultiplayerSessions.DedicatedServerHost] in the game config tunes it.
+ */
+UCLASS(Config = Game)
+class MULTIPLAYERSESSIONS_API UDedicatedServerHost : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject * Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase & Collection) override;
+	virtual void Deinitialize() override;
+
+	// Ends the match: the session is destroyed and the process exits for the launcher to replace it
+	UFUNCTION(BlueprintCallable, Category = "Sessions")
+	void RecycleInstance();
+
+	FORCEINLINE int32 GetFleetInstance() const { return FleetInstance; }
+	FORCEINLINE bool IsSessionRegistered() const { return bSessionRegistered; }
+
+	UPROPERTY(Config)
+	bool bRegisterSession = true;
+
+	UPROPERTY(Config)
+	int32 NumPublicConnections = 16;
+
+	// Empty uses the short name of the first map the server loads
+	UPROPERTY(Config)
+	FString MatchType;
+
+	// Seconds an instance that had players stays up once the last one left, 0 keeps it up until RecycleInstance
+	UPROPERTY(Config)
+	float EmptyRecycleSeconds = 60.f;
+
+private:
+	void OnPostLoadMap(UWorld * LoadedWorld);
+	void OnSessionComplete(FName SessionName, FSessionOperation::EType Operation, bool bWasSuccessful);
+	bool TickEmptyRecycle(float DeltaTime);
+	void ExitInstance(EDedicatedServerExit::Type ExitCode);
+
+	int32 FleetInstance = INDEX_NONE;
+	bool bSessionRegistered = false;
+	bool bRegistering = false;
+	bool bRecycling = false;
+	bool bHadPlayers = false;
+	double EmptySince = 0.0;
+
+	FDelegateHandle PostLoadMapHandle;
+	FDelegateHandle SessionCompleteHandle;
+	FTSTicker::FDelegateHandle EmptyRecycleTickerHandle;
+};
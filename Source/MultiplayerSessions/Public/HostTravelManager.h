@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
+#include "HostTravelManager.generated.h"
+
+/**
+ * Server side travel of the host, from the menu into the lobby and from the lobby into the match.
+ *
+ * Entering the lobby is a hard travel, a standalone world cannot turn into a listen server seamlessly.
+ * Every travel after it is seamless: the server and the connected clients travel through TransitionMap and stay connected,
+ * instead of tearing the world down and making every client reconnect.
+ * The destination is preloaded while the lobby is still running, PrepareTravel as soon as the map is known,
+ * and the travel waits up to MaxPreloadWaitSeconds for a preload that is still running.
+ *
+ * [/Script/MultiplayerSessions.HostTravelManager] in the game config tunes it.
+ */
+UCLASS(Config = Game)
+class MULTIPLAYERSESSIONS_API UHostTravelManager : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase & Collection) override;
+	virtual void Deinitialize() override;
+
+	// Starts loading a map the host is going to travel to, e.g. the lobby when hosting is requested or the match map once the lobby picked it
+	UFUNCTION(BlueprintCallable, Category = "Sessions")
+	void PrepareTravel(const FString & MapName);
+
+	// Hard travel from the menu into the lobby, listening for clients
+	bool HostLobby(const FString & LobbyUrl);
+
+	// Seamless travel of the server and every connected client, MapName is a match type or a map package
+	UFUNCTION(BlueprintCallable, Category = "Sessions")
+	bool TravelToMatch(const FString & MapName, const FString & Options);
+
+	FORCEINLINE bool IsTravelPending() const { return PendingTravelTickerHandle.IsValid(); }
+
+	UPROPERTY(Config)
+	bool bSeamlessTravel = true;
+
+	// Loaded in between the lobby and the match, keep it small; used when the project does not set a transition map itself
+	UPROPERTY(Config)
+	FString TransitionMap = TEXT("/Game/Maps/Transition");
+
+	UPROPERTY(Config)
+	float MaxPreloadWaitSeconds = 5.f;
+
+private:
+	bool TickPendingTravel(float DeltaTime);
+	bool ServerTravel(const FString & Url, bool bSeamless);
+	void ApplyTransitionMap();
+
+	FString PendingTravelUrl;
+	FName PendingTravelPackage;
+	double PendingTravelDeadline = 0.0;
+	FTSTicker::FDelegateHandle PendingTravelTickerHandle;
+};
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Interfaces/IHttpRequest.h"
+#include "LeaderboardClient.generated.h"
+
+// One leaderboard entry, the name lives in the page's name buffer
+struct FLeaderboardRow
+{
+	int64 Score = 0;
+	int32 Rank = 0;
+	int32 NameOffset = 0;
+	int32 NameLength = 0;
+};
+
+struct MULTIPLAYERSESSIONS_API FLeaderboardPage
+{
+	int32 PageIndex = 0;
+	int32 TotalEntries = 0;//of the whole leaderboard, for the page count
+	TArray<FLeaderboardRow> Rows;
+	FString Names;//the names of all rows back to back, one allocation per page instead of one per row
+
+	FStringView GetName(const FLeaderboardRow & Row) const { return FStringView(Names).Mid(Row.NameOffset, Row.NameLength); }
+};
+
+// bIsFinal is false when a stale cached page is delivered while it is being revalidated, the revalidated page follows
+DECLARE_DELEGATE_TwoParams(FOnLeaderboardPage, const FLeaderboardPage & /*Page*/, bool /*bIsFinal*/);
+DECLARE_DELEGATE(FOnLeaderboardFailed);
+
+/**
+ * Client of the leaderboard service, pages of the top players with an LRU cache that outlives the menus.
+ *
+ *   GET <BaseUrl>/leaderboard/top?offset=<PageIndex * PageSize>&limit=<PageSize>
+ *   200 {"total": 1234, "entries": [{"rank": 1, "name": "Player", "score": 4200}, ...]}, with ETag and/or Last-Modified
+ *   304 when the If-None-Match/If-Modified-Since of a revalidation still match
+ *
+ * A cached page younger than MaxAgeSeconds is served without a request, an older one is served right away and revalidated.
+ * Requests of a page that is already in flight are merged. The body is parsed token by token, without building a JSON DOM.
+ * The HTTP module keeps the connection to the service alive between requests.
+ *
+ * BaseUrl comes from [/Script/MultiplayerSessions.LeaderboardClient] or -LeaderboardUrl=, e.g. a local stand-in server
+ * with -LeaderboardUrl=http://127.0.0.1:8080. Without one every request fails.
+ */
+UCLASS(Config = Game)
+class MULTIPLAYERSESSIONS_API ULeaderboardClient : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase & Collection) override;
+	virtual void Deinitialize() override;
+
+	void GetTopPlayers(int32 PageIndex, FOnLeaderboardPage && OnPage, FOnLeaderboardFailed && OnFailed = FOnLeaderboardFailed());
+
+	// The cached page, without a request and without touching the LRU order, null if it is not cached
+	const FLeaderboardPage * PeekPage(int32 PageIndex) const;
+
+	void ClearCache();
+
+	UPROPERTY(Config)
+	FString BaseUrl;
+
+	UPROPERTY(Config)
+	int32 PageSize = 20;
+
+	UPROPERTY(Config)
+	int32 MaxCachedPages = 8;
+
+	UPROPERTY(Config)
+	float MaxAgeSeconds = 30.f;
+
+	UPROPERTY(Config)
+	float RequestTimeoutSeconds = 10.f;
+
+private:
+	struct FCachedPage
+	{
+		FLeaderboardPage Page;
+		FString ETag;
+		FString LastModified;
+		double FetchedTime = 0.0;
+		uint64 LastUsed = 0;
+	};
+
+	struct FPendingPage
+	{
+		FHttpRequestPtr Request;
+		TArray<FOnLeaderboardPage> OnPage;
+		TArray<FOnLeaderboardFailed> OnFailed;
+	};
+
+	void RequestPage(int32 PageIndex, const FCachedPage * Cached);
+	void OnPageResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bConnectedSuccessfully, int32 PageIndex);
+	FCachedPage & AddToCache(int32 PageIndex);
+
+	static bool ParsePage(const TArray<uint8> & Content, FLeaderboardPage & OutPage);
+
+	TMap<int32, FCachedPage> Cache;
+	uint64 UseCounter = 0;
+
+	TMap<int32, FPendingPage> PendingPages;
+};
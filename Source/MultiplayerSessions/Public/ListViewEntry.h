@@ -4,19 +4,23 @@
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
-#include "Interfaces/OnlineSessionInterface.h"//ovo nebi trebali importati ovdje
-#include "FindSessionsCallbackProxy.h"
+#include "SessionDescriptorTable.h"
 #include "ListViewEntry.generated.h"
 
 /**
- * 
+ * Item object behind one row of the server list view.
+ * The list view only creates entry widgets for the visible rows and hands them these items.
+ * An item only holds a handle into the subsystem's session descriptor table, never a copy of the search result.
  */
 UCLASS()
 class MULTIPLAYERSESSIONS_API UListViewEntry : public UObject
 {
 	GENERATED_BODY()
-	//create constructor
 	
 public:
+	FORCEINLINE void SetSessionHandle(FSessionHandle InSessionHandle) { SessionHandle = InSessionHandle; }
+	FORCEINLINE FSessionHandle GetSessionHandle() const { return SessionHandle; }
 
+private:
+	FSessionHandle SessionHandle;
 };
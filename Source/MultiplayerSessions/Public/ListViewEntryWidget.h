@@ -4,26 +4,45 @@
 
 #include "CoreMinimal.h"
 #include "Blueprint/UserWidget.h"
-#include "Interfaces/OnlineSessionInterface.h"//ovo nebi trebali importati ovdje
-#include "FindSessionsCallbackProxy.h"
+#include "Blueprint/IUserObjectListEntry.h"
+#include "SessionDescriptorTable.h"
 #include "ListViewEntryWidget.generated.h"
 
 /**
- * 
+ * Row widget of the server list view.
+ * Instances are recycled by the list view, NativeOnListItemObjectSet is called every time the widget is handed a different row.
  */
 UCLASS()
-class MULTIPLAYERSESSIONS_API UListViewEntryWidget : public UUserWidget
+class MULTIPLAYERSESSIONS_API UListViewEntryWidget : public UUserWidget, public IUserObjectListEntry
 {
 	GENERATED_BODY()
 
 public:
-	FOnlineSessionSearchResult Session;
-
 	virtual void NativeConstruct() override;
 
 	UPROPERTY(meta = (BindWidget))
 	class UButton * JoinButton;
 
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock * ServerTitle;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock * PingText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock * OpenSlotsText;
+
 	UFUNCTION()
 	void JoinGame();
+
+	// Re-reads the row of the current list item, called when a refresh changed the row in place
+	void UpdateRow();
+
+protected:
+	// IUserObjectListEntry
+	virtual void NativeOnListItemObjectSet(UObject * ListItemObject) override;
+
+private:
+	// Blanks a recycled widget whose row is gone, so it does not keep showing and joining the previous session
+	void ClearRow();
 };
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
+#include "UObject/UObjectGlobals.h"
+#include "MapPreloader.generated.h"
+
+/**
+ * Loads the maps a join or a host is going to travel to ahead of the travel,
+ * so the engine finds the map packages and their dependencies in memory when it travels instead of loading them then.
+ *
+ * A join preloads the maps every client travels through first (JoinTravelMaps, the lobby) and the map the session advertises as its match type.
+ * A preloaded map is held until the engine has loaded it, until the join fails, or for ReleaseDelaySeconds after the next map load.
+ *
+ * [/Script/MultiplayerSessions.MapPreloader] in the game config tunes it.
+ */
+UCLASS(Config = Game)
+class MULTIPLAYERSESSIONS_API UMapPreloader : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase & Collection) override;
+	virtual void Deinitialize() override;
+
+	// Preloads the travel maps of a join to a session that advertises MatchType, maps preloaded for an earlier join are released
+	void PreloadForJoin(const FString & MatchType);
+
+	// Starts loading a map by name (relative to MapDirectory) or package path, travel URL options are ignored. Returns its package name.
+	FName Preload(const FString & MapName);
+
+	void ReleaseAll();
+
+	// Preloaded or still loading
+	bool IsPreloaded(FName PackageName) const;
+	FORCEINLINE bool IsLoading(FName PackageName) const { return PendingPackages.Contains(PackageName); }
+
+	// The long package name of a map name, package path or travel URL, None if it is not a valid one
+	FName ResolvePackageName(const FString & MapName) const;
+
+	UPROPERTY(Config)
+	bool bEnabled = true;
+
+	// Where maps named by a match type live
+	UPROPERTY(Config)
+	FString MapDirectory = TEXT("/Game/Maps");
+
+	// Maps every join travels to before the match map, the lobby the menu hosts
+	UPROPERTY(Config)
+	TArray<FString> JoinTravelMaps = { TEXT("/Game/Maps/Lobby") };
+
+	UPROPERTY(Config)
+	bool bPreloadMatchMap = true;
+
+	UPROPERTY(Config)
+	float ReleaseDelaySeconds = 120.f;
+
+private:
+	void OnPackageLoaded(const FName & PackageName, UPackage * Package, EAsyncLoadingResult::Type Result);
+	void OnPostLoadMap(UWorld * LoadedWorld);
+	bool OnReleaseDelayElapsed(float DeltaTime);
+
+	// Worlds whose packages were loaded ahead of travel, the reference keeps them from being collected until the engine uses them
+	UPROPERTY(Transient)
+	TMap<FName, TObjectPtr<UWorld>> PreloadedWorlds;
+
+	TSet<FName> PendingPackages;
+
+	FDelegateHandle PostLoadMapHandle;
+	FTSTicker::FDelegateHandle ReleaseTickerHandle;
+};
@@ -3,6 +3,10 @@
 #include "CoreMinimal.h"
 #include "Blueprint/UserWidget.h"
 #include "Interfaces/OnlineSessionInterface.h"//ovo nebi trebali importati ovdje
+#include "SessionDescriptorTable.h"
+#include "SessionQuery.h"
+#include "SessionQuickMatch.h"
+#include "SettingsTransaction.h"
 #include "Menu.generated.h"
 
 /**
@@ -12,6 +16,8 @@ UCLASS()
 class MULTIPLAYERSESSIONS_API UMenu : public UUserWidget
 {
 	GENERATED_BODY()
+
+	friend class UMultiplayerSessionsBenchmarkCommandlet;//drives the server browser headless
 	
 public:
 	UFUNCTION(BlueprintCallable, Category = "Menu")
@@ -32,8 +38,10 @@ protected:
 	UFUNCTION()//this needs to be a UFUNCTION() so that we can bind it to the delegate
 	void OnCreateSession(bool bWasSuccessful);
 	void OnFindSessions(const TArray<FOnlineSessionSearchResult> & SessionResults, bool bWasSuccessful);//these are not dynamic delegates so we don't need UFUNCTION
-	
-	void JoinSession(FOnlineSessionSearchResult Session);
+	void OnFindSessionsBatch(TArrayView<const FOnlineSessionSearchResult> NewResults, int32 FirstResultIndex);
+	void OnSessionListUpdated(const FSessionTableDiff & Diff);
+	void OnSessionQosUpdated();
+	void OnQuickMatch(EQuickMatchResult::Type Result);
 	
 	void OnJoinSession(EOnJoinSessionCompleteResult::Type Result);//these are not dynamic delegates so we don't need UFUNCTION
 	UFUNCTION()//this needs to be a UFUNCTION() so that we can bind it to the delegate
@@ -48,6 +56,9 @@ private:
 	UPROPERTY(meta = (BindWidget))
 	class UButton * JoinButton;
 
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UButton * QuickMatchButton;
+
 	UPROPERTY(meta = (BindWidget))
 	class UButton * LowQuality;
 
@@ -84,13 +95,38 @@ private:
 	UPROPERTY(meta = (BindWidget))
 	class UComboBoxString * FullScreenModeSelect;
 
-	UPROPERTY(meta = (BindWidget))
-	class UStackBox * ServerList;
+	// Virtualized, the entry widget class (WBP_ListEntry) is set on the list view in the designer.
+	// Optional so a menu whose ServerList is still the old StackBox keeps loading, it lists no sessions until the widget is a ListView
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UListView * ServerList;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UComboBoxString * MapFilterSelect;//"Any" followed by the options of MapSelect
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UEditableTextBox * HostNameFilterText;
 
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-	TSubclassOf<class UUserWidget> ListEntryWidget;
+	UPROPERTY(meta = (BindWidgetOptional))
+	class USpinBox * MinOpenSlotsFilter;
 
-	TArray<FOnlineSessionSearchResult> SearchResults; 
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UComboBoxString * ServerSortSelect;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock * TopPlayersText;//one line per player of the first leaderboard page
+
+
+	// Unused item objects, kept for the next rows instead of creating new ones
+	UPROPERTY()
+	TArray<class UListViewEntry *> ServerListItemPool;
+
+	// The listed item of every session table row, nullptr for rows that are filtered out
+	UPROPERTY()
+	TArray<class UListViewEntry *> ListedItemsByRow;
+
+	// Seconds between two refreshes of the server list while it is open, 0 disables the auto refresh
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"))
+	float AutoRefreshInterval = 15.f;
 
 	UFUNCTION()
 	void HostButtonClicked();
@@ -101,6 +137,9 @@ private:
 	UFUNCTION()
 	void JoinCanceled();
 
+	UFUNCTION()
+	void QuickMatchButtonClicked();
+
 	UFUNCTION()
 	void GraphicsQualityLowButtonClicked();
 
@@ -116,13 +155,36 @@ private:
 	UFUNCTION()
 	void SaveGraphicsButtonClicked();
 
+	UFUNCTION()
+	void ServerListSelectionFilterChanged(FString SelectedItem, ESelectInfo::Type SelectionType);
+
+	UFUNCTION()
+	void ServerListTextFilterChanged(const FText & Text);
+
+	UFUNCTION()
+	void ServerListValueFilterChanged(float Value);
+
 	void GraphicsQualityUpdate(int32 QualityLevel);
+	void OnSettingsCommitted(const FSettingsCommitResult & Result);
+
+	void OnMenuDataReady(const class UMenuDataCache & MenuData);
+	class UMenuDataCache * GetMenuDataCache() const;
+
+	void AddServerListEntry(FSessionHandle Handle);
+	void ClearServerList();
+	void ShowSessionTable();
+	void RefreshServerListRow(int32 Row);
+	void ApplyServerListFilters();
+	void ShowVisibleServerListRows(bool bRedrawRows = false);
+	class UListViewEntry * AcquireServerListItem();
 
 	void MenuTearDown();
 
 	void SetupWidget();
 	void SetupMultiplayerSubsystem();
 
+	FSessionQuery MakeSessionQuery() const;
+
 	//add multiplayer sessions subsystem
 	class UMultiplayerSessionsSubsystem * MultiplayerSessionsSubsystem;
 
@@ -134,7 +196,15 @@ private:
 
 	FString PathToLobby{TEXT("")};
 
+	// Changes of the settings widgets, applied per changed part instead of ApplySettings() for every click
+	FSettingsTransaction SettingsTransaction;
+
 	bool bIsJoining = false;
+	// The server list shows the first ListedItemsByRow.Num() rows of session table generation ListedGeneration
+	uint32 ListedGeneration = 0;
+
+	int32 MaxSearchResults = 10;//The size of the search results shouldn't really matter.  Epic's documentation for BuildUniqueId is Used to keep different builds from seeing each other during searches
 
 	void GetTopPlayers();
+	void OnTopPlayers(const struct FLeaderboardPage & Page, bool bIsFinal);
 };
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/StreamableManager.h"
+#include "Containers/Ticker.h"
+#include "MenuDataCache.generated.h"
+
+class UMenuDataCache;
+
+DECLARE_DELEGATE_OneParam(FOnMenuDataReady, const UMenuDataCache & /*Data*/);
+
+/**
+ * Data the menu needs that is expensive to produce, prepared once per game instance instead of every time a menu widget is built:
+ * the master sound class is loaded asynchronously and held, the supported fullscreen resolutions are enumerated and formatted
+ * on the first tick after the game instance started. A menu opened after a match finds everything ready.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UMenuDataCache : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject * Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase & Collection) override;
+	virtual void Deinitialize() override;
+
+	// Calls OnReady once the data is prepared, right away if it already is
+	void RequestMenuData(FOnMenuDataReady && OnReady);
+
+	bool IsReady() const { return bResolutionsEnumerated && bMasterSoundClassResolved; }
+
+	// "<Width>x<Height>" of every supported fullscreen resolution, the option strings of the resolution combo box
+	const TArray<FString> & GetResolutionOptions() const { return ResolutionOptions; }
+
+	// Applied to the master sound class now, or as soon as it is loaded
+	void SetMasterVolume(float Volume);
+
+	static FString FormatResolution(FIntPoint Resolution);
+
+private:
+	void OnMasterSoundClassLoaded();
+	bool EnumerateResolutions(float DeltaTime);
+	void NotifyIfReady();
+
+	UPROPERTY()
+	TObjectPtr<class USoundClass> MasterSoundClass;
+
+	FStreamableManager Streamable;
+	TSharedPtr<FStreamableHandle> MasterSoundClassHandle;
+	bool bMasterSoundClassResolved = false;//loaded, or failed to load
+	TOptional<float> MasterVolume;
+
+	TArray<FString> ResolutionOptions;
+	bool bResolutionsEnumerated = false;
+	FTSTicker::FDelegateHandle ResolutionTickerHandle;
+
+	TArray<FOnMenuDataReady> PendingRequests;
+};
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MultiplayerSessionsBenchmarkCommandlet.generated.h"
+
+/**
+ * Benchmarks the search-to-render path of the server browser headless:
+ * synthetic result sets are injected into UMultiplayerSessionsSubsystem and timed, with their allocations counted,
+ * through MultiplayerOnFindSessionsComplete, UMenu::OnFindSessions and the server list.
+ *
+ *   UnrealEditor-Cmd <Project> -run=MultiplayerSessionsBenchmark -ini:Engine:[OnlineSubsystem]:DefaultPlatformService=Null
+ *       [-MenuClass=/MultiplayerSessions/WBP_Menu.WBP_Menu_C] [-Sizes=1,100,1000,10000] [-Iterations=10]
+ *       [-Output=<json>] [-Baseline=<json of an earlier run>] [-Tolerance=0.25]
+ *
+ * The menu class defaults to the plugin's WBP_Menu. It needs a ListView named ServerList, a run whose rows never reach the list fails.
+ * Returns non-zero when a result set is slower or allocates more than its budget or than the baseline allows.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UMultiplayerSessionsBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMultiplayerSessionsBenchmarkCommandlet();
+
+	virtual int32 Main(const FString & Params) override;
+};
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MultiplayerSessionsFleetCommandlet.generated.h"
+
+/**
+ * Runs a fleet of headless dedicated server instances on one machine and keeps it at full size:
+ * every instance gets its own game, Steam query and QoS port and its own cores, registers its session through UDedicatedServerHost,
+ * and is replaced by a fresh process on the same ports and cores when it exits at the end of its match.
+ *
+ *   <Project>Server -run=MultiplayerSessionsFleet -Map=/Game/Maps/Arena [-Instances=8] [-CoresPerInstance=2] [-FirstCore=0]
+ *       [-BasePort=7777] [-QueryPortBase=27015] [-QosPortBase=17777] [-Executable=<server binary>] [-ServerArgs="-SessionSlots=16"]
+ *
+ * Without -Instances the cores of the machine are split between instances, CoresPerInstance each.
+ * Cores are pinned with taskset on Linux, elsewhere instances share every core.
+ * An instance that fails to register or exits soon after starting is restarted after a growing back-off.
+ * Runs until the launcher is interrupted, the instances are stopped with it.
+ * Clients only find the fleet's sessions with MultiplayerSessions.SearchDedicatedServers=1, see UDedicatedServerHost.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UMultiplayerSessionsFleetCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMultiplayerSessionsFleetCommandlet();
+
+	virtual int32 Main(const FString & Params) override;
+};
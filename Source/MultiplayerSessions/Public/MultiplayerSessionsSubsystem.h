@@ -3,6 +3,15 @@
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "Interfaces/OnlineSessionInterface.h"
+#include "Containers/Ticker.h"
+#include "SessionDescriptorTable.h"
+#include "SessionFilterEngine.h"
+#include "SessionQos.h"
+#include "SessionQuery.h"
+#include "SessionQuickMatch.h"
+#include "SessionOperation.h"
+#include "SessionTask.h"
+#include "SessionListSnapshot.h"
 
 #include "MultiplayerSessionsSubsystem.generated.h"
 
@@ -11,9 +20,14 @@
 //
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnCreateSessionComplete, bool, bWasSuccessful);
 DECLARE_MULTICAST_DELEGATE_TwoParams(FMultiplayerOnFindSessionsComplete, const TArray<FOnlineSessionSearchResult> & SessionResults, bool bWasSuccessful);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FMultiplayerOnFindSessionsBatch, TArrayView<const FOnlineSessionSearchResult> NewResults, int32 FirstResultIndex);//streamed slice of the results that arrived since the last batch
+DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnSessionListUpdated, const FSessionTableDiff & Diff);//what changed when a refresh replaced the session table
+DECLARE_MULTICAST_DELEGATE(FMultiplayerOnSessionQosUpdated);//measured pings and packet loss were merged into the session table
 DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnJoinSessionComplete, EOnJoinSessionCompleteResult::Type Result);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnDestroySessionComplete, bool, bWasSuccessful);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnStartSessionComplete, bool, bWasSuccessful);
+DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnQuickMatchComplete, EQuickMatchResult::Type Result);
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FMultiplayerOnNamedSessionComplete, FName SessionName, FSessionOperation::EType Operation, bool bWasSuccessful);//every operation of every named session
 
 /**
  * 
@@ -26,27 +40,108 @@ class MULTIPLAYERSESSIONS_API UMultiplayerSessionsSubsystem : public UGameInstan
 public:
 	UMultiplayerSessionsSubsystem();
 
+	virtual void Initialize(FSubsystemCollectionBase & Collection) override;
+	virtual void Deinitialize() override;
+
 	FORCEINLINE IOnlineSessionPtr GetSessionInterface() const { return SessionInterface; }
 
-	// To handle session functionality the menu class calls these	
+	// Advertised by every session we host, FSessionQuery::Default searches for them
+	static constexpr const TCHAR * SessionGameType = TEXT("DeathEcho");
+	static constexpr int32 SessionBuildId = 385104;//session system will use the id to get the list of games related to this version of the game
+
+	// To handle session functionality the menu class calls these, they act on the game session unless a SessionName is given
 	void CreateSession(int32 NumPublicConnections, FString MatchType);
+	void CreateSession(FName SessionName, const FOnlineSessionSettings & Settings);
 	void FindSessions(int32 MaxSearchResults);
-	void JoinSession(const FOnlineSessionSearchResult & SearchResult);
-	void DestroySession();
-	void StartSession();
+	void FindSessions(const FSessionQuery & Query);
+	void FindSessionsCached(const FSessionQuery & Query);
+	void PrefetchSessions(const FSessionQuery & Query);
+	void StartAutoRefresh(const FSessionQuery & Query, float Interval);
+	void StopAutoRefresh();
+	void AbortSearch();//cancels the running search and reports it as failed, releasing the backend delegate
+	void JoinSession(const FOnlineSessionSearchResult & SearchResult, FName SessionName = NAME_GameSession);
+	void JoinSession(FSessionHandle Handle);
+	void DestroySession(FName SessionName = NAME_GameSession);
+	void StartSession(FName SessionName = NAME_GameSession);
+
+	// Completes a search with the given results without asking the backend, for benchmarks and tests of the server browser
+	void InjectSearchResults(TArray<FOnlineSessionSearchResult> && Results, const FSessionQuery & Query);
+
+	// Searches, joins the best scored session and fails over to the next candidate without searching again, hosts when the deadline passes
+	void QuickMatch(const FQuickMatchParams & Params);
+	void CancelQuickMatch();
+	FORCEINLINE bool IsQuickMatchInProgress() const { return QuickMatchPhase != EQuickMatchPhase::Idle; }
+
+	// Descriptors of the current search generation, row N describes search result N
+	FORCEINLINE const FSessionDescriptorTable & GetSessionTable() const { return SessionTable; }
+	FORCEINLINE const FSessionQuery & GetSessionTableQuery() const { return TableSessionQuery; }
+	const FOnlineSessionSearchResult * FindSearchResult(FSessionHandle Handle) const;
+
+	// Client-side filters and sort order of the session table, kept in sync with every table change before the delegates fire
+	FORCEINLINE FSessionFilterEngine & GetSessionFilter() { return SessionFilter; }
+	FORCEINLINE const FSessionFilterEngine & GetSessionFilter() const { return SessionFilter; }
+
+	// Async versions of the calls above, the task fails with TimedOut if the operation does not complete within Timeout seconds (0 waits forever)
+	FSessionTask CreateSessionAsync(int32 NumPublicConnections, const FString & MatchType, float Timeout = 20.f);
+	FSessionTask StartSessionAsync(float Timeout = 20.f);
+	FSessionTask DestroySessionAsync(float Timeout = 20.f);
+	FSessionTask FindSessionsAsync(const FSessionQuery & Query, float Timeout = 30.f);
+	FSessionTask JoinSessionAsync(FSessionHandle Handle, float Timeout = 20.f);
+
+	// Resolves the task as Cancelled right away and abandons its operation, releasing the backend delegate
+	void CancelSessionTask(uint32 TaskId);
+
+	// Create, start, destroy and join run one at a time per session in the order they were requested, different sessions in parallel
+	ESessionState::Type GetSessionState(FName SessionName = NAME_GameSession) const;
+
+	// The settings the session was last created with, null if we did not create it
+	TSharedPtr<const FOnlineSessionSettings> GetSessionSettings(FName SessionName = NAME_GameSession) const;
+
+	bool IsSearchInProgress() const;
+	bool HasCachedSessions(const FSessionQuery & Query) const;
+	bool IsSessionCacheFresh() const;
+	FORCEINLINE bool IsAutoRefreshEnabled() const { return AutoRefreshTickerHandle.IsValid(); }
 
 	//
 	// Custom delegates for the menu class to bind callbacks to
 	//
 	FMultiplayerOnCreateSessionComplete MultiplayerOnCreateSessionComplete;
 	FMultiplayerOnFindSessionsComplete MultiplayerOnFindSessionsComplete;
+	FMultiplayerOnFindSessionsBatch MultiplayerOnFindSessionsBatch;
+	FMultiplayerOnSessionListUpdated MultiplayerOnSessionListUpdated;
+	FMultiplayerOnSessionQosUpdated MultiplayerOnSessionQosUpdated;
 	FMultiplayerOnJoinSessionComplete MultiplayerOnJoinSessionComplete;
 	FMultiplayerOnDestroySessionComplete MultiplayerOnDestroySessionComplete;
 	FMultiplayerOnStartSessionComplete MultiplayerOnStartSessionComplete;
+	FMultiplayerOnQuickMatchComplete MultiplayerOnQuickMatchComplete;
+
+	// The delegates above report the game session, this one the operations of every session including the game session's
+	FMultiplayerOnNamedSessionComplete MultiplayerOnNamedSessionComplete;
 
 	int32 DesiredNumberOfPublicConnections{};//this will initialize it to an empty string
 	FString DesiredMatchType{};
 
+	// Starts a created session right away instead of waiting for a StartSession call
+	bool bStartSessionOnCreate{ true };
+
+	// Seconds before a backend call that never completes is abandoned and reported as failed, 0 waits forever
+	float SearchTimeout{ 30.f };
+	float SessionOperationTimeout{ 20.f };
+
+	// When true FindSessions polls the running search and broadcasts MultiplayerOnFindSessionsBatch as results come in,
+	// MultiplayerOnFindSessionsComplete is still broadcast once the backend finishes the query
+	bool bStreamSearchResults{ true };
+	float SearchStreamInterval{ 0.1f };//seconds between two polls of the running search
+
+	// How long (in seconds) the last good result set is served without searching again,
+	// past that it is still served right away but a new search revalidates it in the background
+	float SessionCacheTTL{ 30.f };
+
+	// After every search the hosts are probed over UDP and the measured round trip replaces the reported ping
+	bool bProbeSessionLatency{ true };
+	int32 QosPort{ 7787 };//UDP port a host answers probes on, the port actually bound is advertised as the QosPort session setting
+	int32 MaxOutstandingQosProbes{ 16 };//hosts probed at the same time
+
 protected:
 	// Internal callbacks for the delegates added to the Online Session Interface delegate list
 	// This will be called inside the MultiplayerSessionsSubsystem.cpp file
@@ -56,13 +151,87 @@ protected:
 	void OnDestroySessionComplete(FName SessionName, bool bWasSuccessful);
 	void OnStartSessionComplete(FName SessionName, bool bWasSuccessful);
 
+	// Session operation queues, one per named session
+	void EnqueueSessionOperation(FSessionOperation && Operation);
+	void RunNextSessionOperation(FName SessionName);
+	void FinishSessionOperation(FName SessionName, ESessionState::Type NewState);
+	void SetSessionState(FName SessionName, ESessionState::Type NewState);
+	void PublishSessionCounters() const;
+	bool WillSessionExist(FName SessionName) const;
+	bool IsDestroyPending(FName SessionName) const;
+	void RunCreateSession(const FSessionOperation & Operation);
+	void RunStartSession(FName SessionName);
+	void RunDestroySession(FName SessionName);
+	void RunJoinSession(const FSessionOperation & Operation);
+	void BroadcastSessionComplete(FName SessionName, FSessionOperation::EType Type, bool bWasSuccessful);
+	FUniqueNetIdPtr GetLocalUserId() const;//null without a local player, e.g. on a dedicated server
+
+	// Timeouts and async tasks
+	bool TickSessionTimeouts(float DeltaTime);
+	void AbortSessionOperation(FName SessionName);
+	void CancelSessionOperation(FSessionOperation::EType Type);//of the game session, the async tasks only track that one
+	FSessionTask AddSessionTask(ESessionTaskType::Type Type, float Timeout);
+	void ResolveSessionTasks(ESessionTaskType::Type Type, const FSessionTaskResult & Result);
+	void EndSessionTask(uint32 TaskId, ESessionTaskStatus Status);
+
+	UFUNCTION()
+	void OnCreateSessionTaskComplete(bool bWasSuccessful);
+	UFUNCTION()
+	void OnStartSessionTaskComplete(bool bWasSuccessful);
+	UFUNCTION()
+	void OnDestroySessionTaskComplete(bool bWasSuccessful);
+	void OnFindSessionsTaskComplete(const TArray<FOnlineSessionSearchResult> & SessionResults, bool bWasSuccessful);
+	void OnJoinSessionTaskComplete(EOnJoinSessionCompleteResult::Type Result);
+
+	// Search streaming
+	bool TickSearchStream(float DeltaTime);
+	void FlushSearchStream();
+	void StopSearchStream();
+
+	// Session table and cache
+	void SyncSessionTable();
+	void CommitRevalidatedSearch();
+	bool TickAutoRefresh(float DeltaTime);
+
+	// Server list snapshot of the last launch
+	void LoadLastSeenSessions(const FSessionQuery & Query);
+	void SaveLastSeenSessions();
+	void ReleaseLastSeenSessions();
+
+	// QoS probing
+	void StartQosProbes();
+	void OnQosProbesComplete(const TArray<FSessionQosResult> & Results, uint32 Generation);
+
+	// Quick match
+	void OnQuickMatchSearchComplete(const TArray<FOnlineSessionSearchResult> & SessionResults, bool bWasSuccessful);
+	void TryNextQuickMatchCandidate();
+	bool TickQuickMatch(float DeltaTime);
+	void HostQuickMatchFallback();
+	void FinishQuickMatch(EQuickMatchResult::Type Result);
+	void BroadcastJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result);
+
 private:
 	IOnlineSessionPtr SessionInterface;//Online Session Interface
-	TSharedPtr<FOnlineSessionSettings> LastSessionSettings;//these are the settings used when we last created a session
 	TSharedPtr<FOnlineSessionSearch> LastSessionSearch;
 
+	FSessionDescriptorTable SessionTable;
+	TSharedPtr<FOnlineSessionSearch> TableSessionSearch;//the search SessionTable describes, stays on the last good search while LastSessionSearch revalidates it
+	FSessionQuery TableSessionQuery;
+	FSessionQuery LastSessionQuery;
+	FSessionFilterEngine SessionFilter;
+	uint32 SearchGeneration{ 0 };//bumped whenever SessionTable is rebuilt, invalidates the handles of the previous table
+	double LastGoodSearchTime{ 0.0 };
+	bool bRevalidatingSessionTable{ false };
+	bool bInjectedSearch{ false };//the table holds InjectSearchResults rows, they are neither saved to the snapshot nor probed
+
+	TUniquePtr<FSessionListSnapshot> LastSeenSnapshot;//mapped while SessionTable shows its rows, they point into it
+	bool bTriedLastSeenSnapshot{ false };//the snapshot is only looked at by the first search of a launch
+	TFuture<void> PendingSnapshotWrite;
+
 	// To add to the online session interface delegate functions
 	// we will bind our MultiplayerSessionsSubsystem functions to the delegate functions
+	// create, join, destroy and start stay bound while the subsystem lives and route each completion by its session name,
+	// so operations on different sessions never replace each other's handle
 	FOnCreateSessionCompleteDelegate CreateSessionCompleteDelegate;
 	FDelegateHandle CreateSessionCompleteDelegateHandle;
 	FOnFindSessionsCompleteDelegate FindSessionsCompleteDelegate;
@@ -74,7 +243,50 @@ private:
 	FOnStartSessionCompleteDelegate StartSessionCompleteDelegate;
 	FDelegateHandle StartSessionCompleteDelegateHandle;
 
-	bool bCreateSessionOnDestroy{ false };
-	int32 LastNumPublicConnections;
-	FString LastMatchType;
+	FTSTicker::FDelegateHandle SearchStreamTickerHandle;
+	FTSTicker::FDelegateHandle AutoRefreshTickerHandle;
+	FSessionQuery AutoRefreshQuery;
+	int32 NumStreamedResults{ 0 };//how many entries of LastSessionSearch->SearchResults were already broadcast as batches
+
+	TUniquePtr<FSessionQosProber> QosProber;
+	TUniquePtr<FSessionQosResponder> QosResponder;//answers probes while we host
+
+	FQuickMatchParams QuickMatchParams;
+	EQuickMatchPhase::Type QuickMatchPhase{ EQuickMatchPhase::Idle };
+	TArray<FSessionHandle> QuickMatchCandidates;//best first
+	int32 NextQuickMatchCandidate{ 0 };
+	TSet<uint32> QuickMatchTriedSessions;//session id hashes, a failed session is not tried again by the same quick match
+	double QuickMatchDeadline{ 0.0 };
+	double QuickMatchRetryTime{ 0.0 };
+	FTSTicker::FDelegateHandle QuickMatchTickerHandle;
+	FDelegateHandle QuickMatchSearchHandle;
+
+	struct FNamedSessionSlot
+	{
+		ESessionState::Type State = ESessionState::Idle;//never Searching, GetSessionState adds the search
+		TArray<FSessionOperation> PendingOperations;//oldest first
+		bool bOperationRunning = false;//an operation was sent to the session interface and its completion is outstanding
+		FSessionOperation::EType RunningOperation = FSessionOperation::EType::Destroy;
+		double OperationStartTime = 0.0;
+		TSharedPtr<FOnlineSessionSettings> Settings;//the settings the session was last created with
+	};
+
+	// Only looked up by name, a reference into it does not survive a call that may add another session
+	TMap<FName, FNamedSessionSlot> SessionSlots;
+
+	// The session's slot if Type is the operation it is waiting on, null for completions of abandoned operations and of sessions we do not manage
+	FNamedSessionSlot * FindRunningOperation(FName SessionName, FSessionOperation::EType Type);
+	double SearchStartTime{ 0.0 };
+
+	struct FPendingSessionTask
+	{
+		uint32 Id = 0;
+		ESessionTaskType::Type Type = ESessionTaskType::Find;
+		double Deadline = 0.0;//0 never expires
+		TPromise<FSessionTaskResult> Promise;
+	};
+
+	TArray<FPendingSessionTask> PendingSessionTasks;
+	uint32 LastSessionTaskId{ 0 };
+	FTSTicker::FDelegateHandle TimeoutTickerHandle;
 };
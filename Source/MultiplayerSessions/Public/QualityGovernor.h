@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
+#include "Scalability.h"
+#include "QualityGovernor.generated.h"
+
+class UGameUserSettings;
+
+// What the governor adjusted in a step, the scalability groups and the screen percentage
+namespace EQualityKnob
+{
+	enum Type : uint8
+	{
+		ScreenPercentage,
+		Shadow,
+		PostProcess,
+		Effects,
+		Foliage,
+		Reflection,
+		GlobalIllumination,
+		Shading,
+		ViewDistance,
+		AntiAliasing,
+		Num
+	};
+
+	MULTIPLAYERSESSIONS_API const TCHAR * ToString(Type Knob);
+}
+
+// One step of the governor, for telemetry
+struct FQualityGovernorDecision
+{
+	double Time = 0.0;//FPlatformTime::Seconds() of the step
+	EQualityKnob::Type Knob = EQualityKnob::ScreenPercentage;
+	int32 OldValue = 0;
+	int32 NewValue = 0;//a scalability level, or the screen percentage
+	float FrameMs = 0.f;//smoothed frame and GPU time that led to the step
+	float GpuMs = 0.f;
+	float TargetMs = 0.f;
+
+	bool IsDownshift() const { return NewValue < OldValue; }
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnQualityGovernorDecision, const FQualityGovernorDecision & /*Decision*/);
+
+/**
+ * Holds a target frame rate during play by stepping single scalability groups and the screen percentage down or up.
+ * The quality the player picked in the menu is the ceiling, the governor never goes above it and does not save its steps.
+ *
+ * Frame and GPU time are smoothed; a downshift needs the frame time over the target by DownshiftMargin for DownshiftHoldSeconds,
+ * an upshift needs it under by UpshiftMargin for the longer UpshiftHoldSeconds, and every step is followed by a cooldown.
+ * A downshift only happens while the GPU is the bottleneck, when the game thread is, lower settings would not help.
+ * An upshift that is undone by a downshift doubles the hold before the next upshift, so the governor does not oscillate.
+ *
+ * [/Script/MultiplayerSessions.QualityGovernor] in the game config tunes it, 'MultiplayerSessions.QualityGovernor 0' pauses it.
+ */
+UCLASS(Config = Game)
+class MULTIPLAYERSESSIONS_API UQualityGovernor : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject * Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase & Collection) override;
+	virtual void Deinitialize() override;
+
+	// Takes the current scalability settings as the new ceiling and starts from them, call after the player changed the quality
+	void ResetCeiling();
+
+	// Saves the game user settings with the ceiling in place of the governed levels, which stay applied.
+	// UGameUserSettings::SaveSettings saves the live levels, a temporary downshift would become the player's quality otherwise.
+	void SaveSettingsAtCeiling(UGameUserSettings & Settings) const;
+
+	void SetActive(bool bInActive);
+	bool IsActive() const { return bActive; }
+
+	// Runs the engine's hardware benchmark and applies its results, unless it ran in an earlier launch. Stalls for a moment.
+	bool RunInitialBenchmarkIfNeeded();
+
+	const TArray<FQualityGovernorDecision> & GetRecentDecisions() const { return RecentDecisions; }
+
+	FOnQualityGovernorDecision OnDecision;
+
+	UPROPERTY(Config)
+	bool bEnabled = true;
+
+	UPROPERTY(Config)
+	bool bRunBenchmarkOnFirstLaunch = true;
+
+	// 0 uses the frame rate limit of the game user settings, or 60 without one
+	UPROPERTY(Config)
+	float TargetFrameRate = 0.f;
+
+	UPROPERTY(Config)
+	float DownshiftMargin = 0.1f;
+
+	UPROPERTY(Config)
+	float UpshiftMargin = 0.2f;
+
+	UPROPERTY(Config)
+	float DownshiftHoldSeconds = 2.f;
+
+	UPROPERTY(Config)
+	float UpshiftHoldSeconds = 10.f;
+
+	UPROPERTY(Config)
+	float CooldownSeconds = 3.f;
+
+	UPROPERTY(Config)
+	int32 MinScreenPercentage = 50;
+
+	UPROPERTY(Config)
+	int32 ScreenPercentageStep = 10;
+
+private:
+	bool Tick(float DeltaTime);
+	float GetTargetMs() const;
+
+	int32 GetKnobValue(const Scalability::FQualityLevels & Levels, EQualityKnob::Type Knob) const;
+	void SetKnobValue(Scalability::FQualityLevels & Levels, EQualityKnob::Type Knob, int32 Value) const;
+	// Step index of a knob, the screen percentage counts in ScreenPercentageStep steps above MinScreenPercentage
+	int32 GetKnobStep(const Scalability::FQualityLevels & Levels, EQualityKnob::Type Knob) const;
+
+	bool StepDown();
+	bool StepUp();
+	void Apply(EQualityKnob::Type Knob, const Scalability::FQualityLevels & Levels, int32 OldValue);
+
+	Scalability::FQualityLevels Ceiling;
+	bool bHasCeiling = false;
+	bool bActive = false;
+
+	float SmoothedFrameMs = 0.f;
+	float SmoothedGpuMs = 0.f;
+	double OverBudgetSeconds = 0.0;
+	double UnderBudgetSeconds = 0.0;
+	double CooldownRemaining = 0.0;
+	float UpshiftHoldScale = 1.f;//doubled when an upshift is followed by a downshift, reset once quality is back at the ceiling
+	bool bLastStepWasUpshift = false;
+
+	static constexpr int32 MaxRecentDecisions = 32;
+	TArray<FQualityGovernorDecision> RecentDecisions;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+};
@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "SessionTask.h"
+#include "SessionAsyncActions.generated.h"
+
+class UMultiplayerSessionsSubsystem;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FSessionAsyncActionPin, ESessionTaskStatus, Status, int32, NumSearchResults);
+
+/**
+ * Latent Blueprint node waiting for one async task of the MultiplayerSessionsSubsystem.
+ * Exactly one of the output pins fires, OnFailure also when the task timed out or was cancelled.
+ */
+UCLASS(Abstract)
+class MULTIPLAYERSESSIONS_API USessionAsyncAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintAssignable)
+	FSessionAsyncActionPin OnSuccess;
+
+	UPROPERTY(BlueprintAssignable)
+	FSessionAsyncActionPin OnFailure;
+
+	// Stops waiting right away, OnFailure fires with Cancelled and the backend operation is abandoned
+	UFUNCTION(BlueprintCallable, Category = "Sessions")
+	void Cancel();
+
+protected:
+	void Setup(const UObject * WorldContextObject, float InTimeout);
+	void WaitFor(FSessionTask && Task);
+	void Finish(const FSessionTaskResult & Result);
+
+	TWeakObjectPtr<UMultiplayerSessionsSubsystem> Subsystem;
+	float Timeout = 0.f;
+
+private:
+	uint32 TaskId = 0;
+	bool bFinished = false;
+};
+
+UCLASS()
+class MULTIPLAYERSESSIONS_API UCreateSessionAsyncAction : public USessionAsyncAction
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, Category = "Sessions", meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject", DisplayName = "Create Session (Async)"))
+	static UCreateSessionAsyncAction * CreateSessionAsync(UObject * WorldContextObject, int32 NumPublicConnections = 4, FString MatchType = TEXT("D_ShootingRange"), float Timeout = 20.f);
+
+	virtual void Activate() override;
+
+private:
+	int32 NumPublicConnections = 0;
+	FString MatchType;
+};
+
+UCLASS()
+class MULTIPLAYERSESSIONS_API UFindSessionsAsyncAction : public USessionAsyncAction
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, Category = "Sessions", meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject", DisplayName = "Find Sessions (Async)"))
+	static UFindSessionsAsyncAction * FindSessionsAsync(UObject * WorldContextObject, int32 MaxSearchResults = 10, float Timeout = 30.f);
+
+	virtual void Activate() override;
+
+private:
+	int32 MaxSearchResults = 0;
+};
+
+UCLASS()
+class MULTIPLAYERSESSIONS_API UJoinSessionAsyncAction : public USessionAsyncAction
+{
+	GENERATED_BODY()
+
+public:
+	// Joins row ResultIndex of the last completed search
+	UFUNCTION(BlueprintCallable, Category = "Sessions", meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject", DisplayName = "Join Session (Async)"))
+	static UJoinSessionAsyncAction * JoinSessionAsync(UObject * WorldContextObject, int32 ResultIndex, float Timeout = 20.f);
+
+	virtual void Activate() override;
+
+private:
+	int32 ResultIndex = INDEX_NONE;
+};
+
+UCLASS()
+class MULTIPLAYERSESSIONS_API UDestroySessionAsyncAction : public USessionAsyncAction
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, Category = "Sessions", meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject", DisplayName = "Destroy Session (Async)"))
+	static UDestroySessionAsyncAction * DestroySessionAsync(UObject * WorldContextObject, float Timeout = 20.f);
+
+	virtual void Activate() override;
+};
@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/UniquePtr.h"
+
+class FOnlineSessionSearchResult;
+class FMemStackBase;
+
+/**
+ * Lightweight reference to a row of the session descriptor table.
+ * Handles of an older search generation stop resolving as soon as a new search replaces the table.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionHandle
+{
+	uint32 Generation = 0;
+	int32 Index = INDEX_NONE;
+
+	FORCEINLINE bool IsSet() const { return Index != INDEX_NONE; }
+	FORCEINLINE bool operator==(const FSessionHandle & Other) const { return Generation == Other.Generation && Index == Other.Index; }
+};
+
+/**
+ * Difference between two consecutive generations of the session table, keyed by session id.
+ * Row indices refer to the new table unless stated otherwise.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionTableDiff
+{
+	uint32 PreviousGeneration = 0;
+	uint32 Generation = 0;
+
+	TArray<int32> PreviousRows;	// for every row of the new table, its row in the previous table or INDEX_NONE
+	TArray<int32> Added;		// sessions that were not listed before
+	TArray<int32> Changed;		// sessions whose ping or open slots changed, or that were listed again after disappearing
+	TArray<int32> Removed;		// sessions that disappeared in this refresh, kept in the table flagged as Disappeared
+	TArray<int32> Dropped;		// rows of the previous table that are not part of the new table at all
+
+	FORCEINLINE bool IsEmpty() const { return Added.Num() == 0 && Changed.Num() == 0 && Removed.Num() == 0 && Dropped.Num() == 0; }
+};
+
+/**
+ * Per-row state of a session descriptor.
+ */
+namespace ESessionRowFlags
+{
+	enum Type : uint8
+	{
+		None		= 0,
+		Disappeared	= 1 << 0,	// listed by the previous search but missing from the latest one, the row can no longer be joined
+		Probed		= 1 << 1,	// ping and packet loss were measured by the QoS probes instead of reported by the backend
+		LastSeen	= 1 << 2,	// read from the snapshot of an earlier launch, shown until a live search lists or drops the session
+	};
+}
+
+/**
+ * Compact, structure-of-arrays description of the sessions found by one search.
+ * Row N describes LastSessionSearch->SearchResults[N]; only the values the browser needs are extracted, once per result.
+ * Rows keep their flags and a hash of the session id so consecutive generations can be compared cheaply.
+ * Columns and strings live in an arena that is released in one go when the table is reset for the next search.
+ */
+class MULTIPLAYERSESSIONS_API FSessionDescriptorTable
+{
+public:
+	FSessionDescriptorTable();
+	~FSessionDescriptorTable();
+
+	FSessionDescriptorTable(const FSessionDescriptorTable &) = delete;
+	FSessionDescriptorTable & operator=(const FSessionDescriptorTable &) = delete;
+	FSessionDescriptorTable(FSessionDescriptorTable && Other);
+	FSessionDescriptorTable & operator=(FSessionDescriptorTable && Other);
+
+	// Frees every row and starts a new generation with room for ExpectedNum rows
+	void Reset(uint32 InGeneration, int32 ExpectedNum);
+
+	// Extracts the descriptor of Result into a new row and returns its index
+	int32 Append(const FOnlineSessionSearchResult & Result);
+
+	// Copies row OtherIndex of another table, the strings are copied into this table's arena
+	int32 AppendFrom(const FSessionDescriptorTable & Other, int32 OtherIndex, uint8 Flags);
+
+	// Appends a row whose strings are not copied, they must stay valid for as long as this generation of the table
+	int32 AppendExternal(FStringView SessionId, uint32 SessionIdHash, FStringView OwnerName, FStringView MapName, FStringView GameType, int32 PingInMs, int32 InOpenSlots, int32 InPublicSlots, uint8 Flags);
+
+	FORCEINLINE int32 Num() const { return NumRows; }
+	FORCEINLINE uint32 GetGeneration() const { return Generation; }
+
+	FORCEINLINE bool IsValid(FSessionHandle Handle) const { return Handle.Generation == Generation && Handle.Index >= 0 && Handle.Index < NumRows; }
+	FORCEINLINE FSessionHandle MakeHandle(int32 Index) const { return FSessionHandle{ Generation, Index }; }
+
+	static uint32 HashSessionId(FStringView SessionId);
+
+	FORCEINLINE FStringView GetSessionId(int32 Index) const { return SessionIds[Index]; }
+	FORCEINLINE uint32 GetSessionIdHash(int32 Index) const { return SessionIdHashes[Index]; }
+	FORCEINLINE uint8 GetRowFlags(int32 Index) const { return RowFlags[Index]; }
+	FORCEINLINE FStringView GetOwnerName(int32 Index) const { return OwnerNames[Index]; }
+	FORCEINLINE FStringView GetMapName(int32 Index) const { return MapNames[Index]; }
+	FORCEINLINE FStringView GetGameType(int32 Index) const { return GameTypes[Index]; }
+	FORCEINLINE int32 GetPingInMs(int32 Index) const { return PingsInMs[Index]; }
+	FORCEINLINE int32 GetOpenSlots(int32 Index) const { return OpenSlots[Index]; }
+	FORCEINLINE int32 GetPublicSlots(int32 Index) const { return PublicSlots[Index]; }
+	FORCEINLINE uint8 GetPacketLoss(int32 Index) const { return PacketLoss[Index]; }
+
+	// Stores a measured round trip time (INDEX_NONE keeps the reported ping) and packet loss percentage
+	void SetQos(int32 Index, int32 RttMs, uint8 LossPercent);
+
+	// Row indices ordered from best to worst connection, disappeared rows last
+	void SortRowsByLatency(TArray<int32> & OutRows) const;
+
+	// Effective latency of a row as used by SortRowsByLatency, lower is better
+	int64 GetLatencySortKey(int32 Index) const;
+
+private:
+	void Grow(int32 NewCapacity);
+	FStringView CopyString(FStringView Source);
+	int32 AddRow();
+
+	void ResetColumns();
+
+	template<typename T>
+	void GrowColumn(T *& Column, int32 NewCapacity);
+
+	template<typename T>
+	T * AllocColumn(int32 Count);
+
+	TUniquePtr<FMemStackBase> Arena;
+
+	// columns, all NumRows long and Capacity large
+	FStringView * SessionIds = nullptr;
+	FStringView * OwnerNames = nullptr;
+	FStringView * MapNames = nullptr;
+	FStringView * GameTypes = nullptr;
+	int32 * PingsInMs = nullptr;
+	int32 * OpenSlots = nullptr;
+	int32 * PublicSlots = nullptr;
+	uint8 * PacketLoss = nullptr;
+	uint32 * SessionIdHashes = nullptr;
+	uint8 * RowFlags = nullptr;
+
+	int32 NumRows = 0;
+	int32 Capacity = 0;
+	uint32 Generation = 0;
+
+	FString ScratchString;//attributes are read into it before they are copied into the arena
+};
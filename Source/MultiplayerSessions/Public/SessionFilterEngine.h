@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/BitArray.h"
+
+class FSessionDescriptorTable;
+
+/**
+ * Column the server list is ordered by.
+ */
+namespace ESessionSortKey
+{
+	enum Type : uint8
+	{
+		Latency,
+		OpenSlots,
+		HostName,
+		MapName,
+		Num
+	};
+}
+
+/**
+ * Client-side filter and sort index over the session descriptor table.
+ * Sort keys and filter columns are extracted once per row when the row is indexed, every predicate keeps its own bitmap
+ * so changing one filter only re-evaluates that predicate and ANDs the bitmaps again.
+ * Rows of the same generation are indexed incrementally as they stream in, a new generation rebuilds the index.
+ */
+class MULTIPLAYERSESSIONS_API FSessionFilterEngine
+{
+public:
+	// Indexes the rows added to Table since the last sync, or the whole table if its generation changed
+	void Sync(const FSessionDescriptorTable & Table);
+
+	// Re-extracts the latency keys after the QoS probes updated the table
+	void RefreshLatency(const FSessionDescriptorTable & Table);
+
+	// The setters return true if the visible rows may have changed; an empty map name or host name disables that filter
+	bool SetMapFilter(FStringView MapName);
+	bool SetMinOpenSlots(int32 InMinOpenSlots);
+	bool SetHostNameFilter(FStringView HostName);
+	bool SetSortKey(ESessionSortKey::Type InSortKey, bool bInDescending = false);
+
+	// Row indices that pass every filter, in sort order
+	void GetVisibleRows(TArray<int32> & OutRows) const;
+
+	FORCEINLINE bool IsRowVisible(int32 Row) const { return Passing.IsValidIndex(Row) && Passing[Row]; }
+	FORCEINLINE int32 Num() const { return NumRows; }
+	FORCEINLINE uint32 GetGeneration() const { return Generation; }
+
+	FORCEINLINE const FString & GetMapFilter() const { return MapFilter; }
+	FORCEINLINE int32 GetMinOpenSlots() const { return MinOpenSlots; }
+	FORCEINLINE const FString & GetHostNameFilter() const { return HostNameFilter; }
+	FORCEINLINE ESessionSortKey::Type GetSortKey() const { return SortKey; }
+
+private:
+	// Rows whose host name predicate has to be tested again after the filter text changed
+	enum class ERecheck : uint8
+	{
+		All,
+		Passing,	// the new text contains the old one, only rows that passed can fail now
+		Failing,	// the old text contains the new one, only rows that failed can pass now
+	};
+
+	void Reset(uint32 InGeneration);
+
+	void EvaluateMap(int32 FirstRow);
+	void EvaluateOpenSlots(int32 FirstRow);
+	void EvaluateHostName(int32 FirstRow, ERecheck Recheck);
+	void CombineFilters();
+
+	const TArray<int32> & GetSortedRows() const;
+
+	uint32 Generation = 0;
+	int32 NumRows = 0;
+
+	// columns extracted once per row
+	TArray<int32> MapIds;
+	TArray<int32> OpenSlots;
+	TArray<int64> LatencyKeys;
+	TArray<FString> HostNames;//lower case
+
+	// index of the distinct map names, one bitmap of rows per map
+	TMap<FString, int32> MapIdsByName;//lower case
+	TArray<FString> MapNames;
+	TArray<TBitArray<>> RowsByMap;
+	TArray<int32> MapRanks;//alphabetical position of every map id, the map name sort key
+
+	// predicates, strings kept lower case
+	FString MapFilter;
+	int32 MapFilterId = INDEX_NONE;
+	int32 MinOpenSlots = 0;
+	FString HostNameFilter;
+
+	// one bitmap per predicate and their combination
+	TBitArray<> MapPass;
+	TBitArray<> OpenSlotsPass;
+	TBitArray<> HostNamePass;
+	TBitArray<> Passing;
+
+	ESessionSortKey::Type SortKey = ESessionSortKey::Latency;
+	bool bDescending = false;
+
+	mutable TArray<int32> SortedRows;
+	mutable bool bSortDirty = true;
+};
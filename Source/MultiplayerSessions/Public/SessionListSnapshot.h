@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/UniquePtr.h"
+
+class FSessionDescriptorTable;
+class IMappedFileHandle;
+class IMappedFileRegion;
+struct FSessionQuery;
+
+/**
+ * The server list of the last successful search, saved so the next launch can show it before its first search completes.
+ *
+ *   FHeader | FRecord * NumRecords | TCHAR * NumChars
+ *
+ * Records are fixed width and point into the string table behind them, so the file is used in place once it is mapped:
+ * opening it checks the header and the size, no row is parsed and nothing is allocated per row.
+ * The file is native endian and TCHAR wide, a file of another platform fails the header check and is ignored.
+ */
+class MULTIPLAYERSESSIONS_API FSessionListSnapshot
+{
+public:
+	static constexpr uint32 Magic = 0x4C53534D;//'MSSL'
+	static constexpr uint32 Version = 1;
+
+	struct FHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 CharSize;
+		uint32 QueryHash;//of the query that found the sessions, a snapshot is only shown for the same query
+		int64 SavedTime;//unix time
+		int32 NumRecords;
+		int32 NumChars;
+	};
+
+	struct FRecord
+	{
+		uint32 SessionIdHash;
+		uint32 SessionIdOffset;//into the string table, in characters
+		uint32 OwnerNameOffset;
+		uint32 MapNameOffset;
+		uint32 GameTypeOffset;
+		uint16 SessionIdLength;
+		uint16 OwnerNameLength;
+		uint16 MapNameLength;
+		uint16 GameTypeLength;
+		int32 PingInMs;
+		int16 OpenSlots;
+		int16 PublicSlots;
+	};
+
+	~FSessionListSnapshot();
+
+	// Where the snapshot of this project lives, under Saved/
+	static FString GetDefaultPath();
+
+	static uint32 HashQuery(const FSessionQuery & Query);
+
+	// Writes the rows of the table that are still listed into a buffer in the snapshot layout
+	static void Write(const FSessionDescriptorTable & Table, uint32 QueryHash, TArray<uint8> & OutBuffer);
+
+	// Maps the snapshot, null if it is missing or was not written by this build's layout
+	static TUniquePtr<FSessionListSnapshot> Open(const FString & Path);
+
+	FORCEINLINE int32 Num() const { return Header->NumRecords; }
+	FORCEINLINE uint32 GetQueryHash() const { return Header->QueryHash; }
+	FDateTime GetSavedTime() const;
+
+	FORCEINLINE const FRecord & GetRecord(int32 Index) const { return Records[Index]; }
+
+	// A string of a record, empty if the record points outside of the string table
+	FStringView GetString(uint32 Offset, uint16 Length) const;
+
+private:
+	FSessionListSnapshot() = default;
+
+	bool Bind(const uint8 * Data, int64 Size);
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray<uint8> LoadedFile;//when the platform cannot map files the snapshot is read in one go
+
+	const FHeader * Header = nullptr;
+	const FRecord * Records = nullptr;
+	const TCHAR * Strings = nullptr;
+};
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Logging/LogMacros.h"
+#include "Misc/StringBuilder.h"
+
+MULTIPLAYERSESSIONS_API DECLARE_LOG_CATEGORY_EXTERN(LogMultiplayerSessions, Log, All);
+
+/**
+ * Logging of the plugin, compiled out in shipping builds.
+ *
+ *   SESSION_LOG(Warning, TEXT("Join of %s failed (%d)"), *SessionId, (int32)Result);
+ *
+ * The arguments are only evaluated and formatted when LogMultiplayerSessions lets the verbosity through
+ * ('log LogMultiplayerSessions Verbose' at runtime). Display and more severe messages are shown on screen too,
+ * every message that is written also goes to a ring buffer of recent events that is dumped into the log on a crash
+ * and by the MultiplayerSessions.DumpEvents console command.
+ */
+#ifndef MULTIPLAYERSESSIONS_LOGGING
+#define MULTIPLAYERSESSIONS_LOGGING !UE_BUILD_SHIPPING
+#endif
+
+#if MULTIPLAYERSESSIONS_LOGGING
+
+/**
+ * Fixed size ring of the most recent log events. Writers never block or allocate, so it can be written from any thread
+ * and read from a crash handler. Every slot carries a sequence number, a reader skips slots that are being overwritten.
+ */
+class MULTIPLAYERSESSIONS_API FSessionEventRing
+{
+public:
+	static constexpr int32 Capacity = 128;
+	static constexpr int32 MaxMessageLength = 240;//longer messages are truncated
+
+	static FSessionEventRing & Get();
+
+	void Record(ELogVerbosity::Type Verbosity, const TCHAR * Message);
+
+	// Writes the recorded events to Ar, oldest first
+	void Dump(FOutputDevice & Ar) const;
+
+private:
+	struct FSlot
+	{
+		TAtomic<uint64> Sequence{ 0 };//index + 1 of the event in the slot, 0 while empty or being written
+		double Time = 0.0;
+		ELogVerbosity::Type Verbosity = ELogVerbosity::Log;
+		TCHAR Message[MaxMessageLength] = {};
+	};
+
+	FSlot Slots[Capacity];
+	TAtomic<uint64> NextIndex{ 0 };
+};
+
+namespace SessionLog
+{
+	// Writes an already formatted message to the log, the event ring and (Display and above) the screen
+	MULTIPLAYERSESSIONS_API void Write(ELogVerbosity::Type Verbosity, const TCHAR * Message);
+	// Writes the event ring to the log, registered as a system error handler by the module
+	MULTIPLAYERSESSIONS_API void DumpRecentEvents();
+}
+
+#define SESSION_LOG(Verbosity, Format, ...) \
+	do \
+	{ \
+		if(UE_LOG_ACTIVE(LogMultiplayerSessions, Verbosity)) \
+		{ \
+			TStringBuilder<256> SessionLogMessage; \
+			SessionLogMessage.Appendf(Format, ##__VA_ARGS__); \
+			SessionLog::Write(ELogVerbosity::Verbosity, SessionLogMessage.ToString()); \
+		} \
+	} while(0)
+
+#else
+
+#define SESSION_LOG(Verbosity, Format, ...)
+
+#endif
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+/**
+ * What a named session is doing, UMultiplayerSessionsSubsystem runs one operation at a time per session.
+ */
+namespace ESessionState
+{
+	enum Type : uint8
+	{
+		Idle,		// no session and nothing running
+		Searching,	// no session, a search is running; searches never wait for or block session operations
+		Creating,
+		Starting,
+		InSession,	// hosting or joined
+		Destroying,
+		Joining,
+	};
+}
+
+/**
+ * A queued operation on a named session.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionOperation
+{
+	enum class EType : uint8
+	{
+		Create,
+		Start,
+		Destroy,
+		Join,
+	};
+
+	EType Type = EType::Destroy;
+	FName SessionName = NAME_GameSession;
+
+	// Create, either the game session settings built from these two or Settings as they are
+	int32 NumPublicConnections = 0;
+	FString MatchType;
+	TSharedPtr<FOnlineSessionSettings> Settings;
+
+	// Join
+	FOnlineSessionSearchResult SearchResult;
+
+	static FSessionOperation MakeCreate(int32 InNumPublicConnections, const FString & InMatchType);
+	static FSessionOperation MakeCreate(FName InSessionName, const FOnlineSessionSettings & InSettings);
+	static FSessionOperation MakeJoin(const FOnlineSessionSearchResult & InSearchResult, FName InSessionName = NAME_GameSession);
+	FORCEINLINE static FSessionOperation Make(EType InType, FName InSessionName = NAME_GameSession) { FSessionOperation Operation; Operation.Type = InType; Operation.SessionName = InSessionName; return Operation; }
+};
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+
+class FSocket;
+class FInternetAddr;
+class FRunnableThread;
+
+/**
+ * A host to probe, Row is passed back untouched in the result.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionQosTarget
+{
+	int32 Row = INDEX_NONE;
+	TSharedPtr<FInternetAddr> Address;
+};
+
+/**
+ * Measured round trip time and packet loss of one host.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionQosResult
+{
+	int32 Row = INDEX_NONE;
+	int32 RttMs = INDEX_NONE;//average of the answered probes, INDEX_NONE if none was answered
+	uint8 LossPercent = 100;
+};
+
+DECLARE_DELEGATE_OneParam(FOnSessionQosProbesComplete, const TArray<FSessionQosResult> & Results);
+
+/**
+ * Sends small UDP probes to many hosts at once and measures how many come back and how fast.
+ * Runs on its own thread so the measurement does not include game thread frame time; the completion delegate is called on the game thread.
+ * At most MaxOutstandingTargets hosts are probed at the same time, the rest wait in a queue.
+ */
+class MULTIPLAYERSESSIONS_API FSessionQosProber : public FRunnable
+{
+public:
+	struct FSettings
+	{
+		int32 MaxOutstandingTargets = 16;
+		int32 ProbesPerTarget = 3;
+		float ProbeInterval = 0.05f;//seconds between two probes to the same host
+		float ProbeTimeout = 1.f;//seconds to wait for the answer to the last probe of a host
+	};
+
+	explicit FSessionQosProber(const FSettings & InSettings);
+	virtual ~FSessionQosProber();
+
+	// Starts probing on a new thread, returns false if the socket could not be created
+	bool Start(TArray<FSessionQosTarget> && InTargets, FOnSessionQosProbesComplete InOnComplete);
+
+	// Stops the thread, the completion delegate is not called
+	void Cancel();
+
+	// FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override { bStopRequested = true; }
+
+private:
+	struct FTargetState
+	{
+		int32 Target = INDEX_NONE;
+		int32 ProbesSent = 0;
+		int32 Replies = 0;
+		uint32 RepliedMask = 0;
+		double RttSum = 0.0;
+		double NextProbeTime = 0.0;
+		double LastProbeTime = 0.0;
+		TArray<double, TInlineAllocator<8>> SendTimes;
+	};
+
+	void SendProbe(FTargetState & State, double Now);
+	void ReceiveReplies(TArray<FTargetState> & Active, FInternetAddr & FromAddress);
+	void FinishTarget(const FTargetState & State);
+
+	FSettings Settings;
+	TArray<FSessionQosTarget> Targets;
+	TArray<FSessionQosResult> Results;
+	FOnSessionQosProbesComplete OnComplete;
+
+	FSocket * Socket = nullptr;
+	FRunnableThread * Thread = nullptr;
+	uint32 Nonce = 0;//per run, replies to probes of an older run are ignored
+	TAtomic<bool> bStopRequested{ false };
+};
+
+/**
+ * Answers the probes of FSessionQosProber, run by the host while its session is advertised.
+ * Echoes every valid probe straight from its own thread.
+ */
+class MULTIPLAYERSESSIONS_API FSessionQosResponder : public FRunnable
+{
+public:
+	virtual ~FSessionQosResponder();
+
+	// Binds the UDP port (0 picks a free one) and starts answering
+	bool Start(int32 Port);
+	void Shutdown();
+
+	FORCEINLINE int32 GetPort() const { return BoundPort; }
+
+	// FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override { bStopRequested = true; }
+
+private:
+	FSocket * Socket = nullptr;
+	FRunnableThread * Thread = nullptr;
+	int32 BoundPort = 0;
+	TAtomic<bool> bStopRequested{ false };
+};
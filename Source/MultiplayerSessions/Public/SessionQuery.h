@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Optional.h"
+
+class FOnlineSessionSearch;
+class FSessionDescriptorTable;
+
+/**
+ * Typed description of a session search.
+ * Every constraint is sent to the backend as a query setting, so a round trip only returns sessions we can use.
+ *
+ *   FSessionQuery Query = FSessionQuery::Default().WithMatchType(TEXT("Arena_2")).WithMinOpenSlots(2).WithMaxResults(50);
+ *   MultiplayerSessionsSubsystem->FindSessions(Query);
+ */
+struct MULTIPLAYERSESSIONS_API FSessionQuery
+{
+	// Sessions of this game and build, the constraints every search of the plugin should start from.
+	// Presence sessions (player hosts) unless MultiplayerSessions.SearchDedicatedServers is set
+	static FSessionQuery Default();
+
+	FSessionQuery & WithGameType(const FString & InGameType) { GameType = InGameType; return *this; }
+	FSessionQuery & WithMatchType(const FString & InMatchType) { MatchType = InMatchType; return *this; }
+	FSessionQuery & WithBuildId(int32 InBuildId) { BuildId = InBuildId; return *this; }
+	FSessionQuery & WithMinOpenSlots(int32 InMinOpenSlots) { MinOpenSlots = InMinOpenSlots; return *this; }
+	FSessionQuery & WithMaxResults(int32 InMaxResults) { MaxResults = InMaxResults; return *this; }
+	FSessionQuery & WithPresence(bool bInPresence) { bPresence = bInPresence; return *this; }
+
+	// Writes the constraints into the query settings of a search
+	void ApplyTo(FOnlineSessionSearch & Search) const;
+
+	// Client side check of the constraints the descriptor table knows about, for backends that ignore some query settings (e.g. the NULL LAN search)
+	bool Matches(const FSessionDescriptorTable & Table, int32 Row) const;
+
+	bool operator==(const FSessionQuery & Other) const;
+	bool operator!=(const FSessionQuery & Other) const { return !(*this == Other); }
+
+	TOptional<FString> GameType;
+	TOptional<FString> MatchType;
+	TOptional<int32> BuildId;
+	int32 MinOpenSlots = 0;
+	int32 MaxResults = 10;
+	bool bPresence = true;
+};
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SessionQuery.h"
+
+class FSessionDescriptorTable;
+
+/**
+ * What UMultiplayerSessionsSubsystem::QuickMatch should look for and what to do when nothing fits.
+ */
+struct MULTIPLAYERSESSIONS_API FQuickMatchParams
+{
+	FSessionQuery Query = FSessionQuery::Default().WithMinOpenSlots(1);
+
+	FString PreferredMatchType;//sessions on this map score higher, empty scores every map the same
+	int32 MaxPingMs = 250;//sessions with a worse effective latency are never joined
+
+	// Weights of the score terms, every term is normalized to 0..1
+	float PingWeight = 1.f;//1 for a 0 ms host, 0 at MaxPingMs
+	float FillWeight = 0.5f;//prefers fuller sessions, they start sooner
+	float MatchTypeWeight = 0.5f;
+
+	float Deadline = 10.f;//seconds to find and join a session before hosting one instead
+	float RetryInterval = 2.f;//seconds between two searches once every candidate failed
+
+	// The session hosted when the deadline passes
+	int32 FallbackNumPublicConnections = 4;
+	FString FallbackMatchType;
+};
+
+/**
+ * How a quick match ended.
+ */
+namespace EQuickMatchResult
+{
+	enum Type : uint8
+	{
+		Joined,		// joined a found session, MultiplayerOnJoinSessionComplete was broadcast with Success
+		Hosting,	// nothing suitable within the deadline, CreateSession was called
+		Failed,		// the session interface is not available
+		Cancelled,
+	};
+}
+
+/**
+ * Phase of the running quick match.
+ */
+namespace EQuickMatchPhase
+{
+	enum Type : uint8
+	{
+		Idle,
+		Searching,
+		Joining,
+		Waiting,	// every candidate failed, the next search starts after RetryInterval
+	};
+}
+
+namespace SessionQuickMatch
+{
+	// Scores every joinable row of the table and returns the rows worth trying, best first.
+	// Rows that are disappeared, full, too far away, do not match the query or whose session id hash is in Excluded are left out.
+	MULTIPLAYERSESSIONS_API void RankCandidates(const FSessionDescriptorTable & Table, const FQuickMatchParams & Params, const TSet<uint32> & Excluded, TArray<int32> & OutRows);
+
+	// Scores gathered candidates four at a time, all arrays are Num long and padded to a multiple of four
+	MULTIPLAYERSESSIONS_API void ScoreBatch(const float * Latencies, const float * FillRatios, const float * MatchTypeHits, float * OutScores, int32 Num, const FQuickMatchParams & Params);
+}
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+/**
+ * Every custom attribute our sessions advertise: key, value type and advertisement mode, declared once.
+ * Each entry becomes a schema type SessionSchema::F<Key> with a key FName that is interned once at module load,
+ * so reads and writes never build an FName from a string and a wrong key or value type does not compile.
+ *
+ *   SessionSchema::Set<SessionSchema::FMatchType>(Settings, MapName);
+ *   SessionSchema::Get<SessionSchema::FQosPort>(SearchResult.Session.SessionSettings, Port);
+ *   SessionSchema::SetQuery<SessionSchema::FBuildId>(Search, BuildId, EOnlineComparisonOp::Equals);
+ */
+#define SESSION_SCHEMA_ATTRIBUTES(Attribute) \
+	Attribute(MatchType,	FString,	ViaOnlineServiceAndPing)	/* the map the session plays on */ \
+	Attribute(GameType,		FString,	ViaOnlineServiceAndPing)	/* UMultiplayerSessionsSubsystem::SessionGameType */ \
+	Attribute(BuildId,		int32,		ViaOnlineService)			/* BuildUniqueId itself cannot be queried, so it is advertised again */ \
+	Attribute(QosPort,		int32,		ViaOnlineServiceAndPing)	/* where searching clients send their latency probes */
+
+/**
+ * Compile-time description of one session attribute, the base of the generated schema types.
+ */
+template<typename InValueType, EOnlineDataAdvertisementType::Type InAdvertisement>
+struct TSessionAttribute
+{
+	using ValueType = InValueType;
+
+	static constexpr EOnlineDataAdvertisementType::Type Advertisement = InAdvertisement;
+};
+
+namespace SessionSchema
+{
+#define SESSION_SCHEMA_DECLARE_ATTRIBUTE(Key, Type, AdvertisementType) \
+	struct MULTIPLAYERSESSIONS_API F##Key : TSessionAttribute<Type, EOnlineDataAdvertisementType::AdvertisementType> \
+	{ \
+		static const FName Name; \
+	};
+
+	SESSION_SCHEMA_ATTRIBUTES(SESSION_SCHEMA_DECLARE_ATTRIBUTE)
+
+#undef SESSION_SCHEMA_DECLARE_ATTRIBUTE
+
+	// Host side: advertises the attribute with the advertisement mode of the schema
+	template<typename AttributeType>
+	FORCEINLINE void Set(FOnlineSessionSettings & Settings, const typename AttributeType::ValueType & Value)
+	{
+		Settings.Set(AttributeType::Name, Value, AttributeType::Advertisement);
+	}
+
+	// Browser side: reads the attribute of a found session, strings reuse the allocation of OutValue
+	template<typename AttributeType>
+	FORCEINLINE bool Get(const FOnlineSessionSettings & Settings, typename AttributeType::ValueType & OutValue)
+	{
+		return Settings.Get(AttributeType::Name, OutValue);
+	}
+
+	// Browser side: constrains a search on the attribute
+	template<typename AttributeType>
+	FORCEINLINE void SetQuery(FOnlineSessionSearch & Search, const typename AttributeType::ValueType & Value, EOnlineComparisonOp::Type Comparison)
+	{
+		static_assert(AttributeType::Advertisement == EOnlineDataAdvertisementType::ViaOnlineService || AttributeType::Advertisement == EOnlineDataAdvertisementType::ViaOnlineServiceAndPing,
+			"Only attributes advertised via the online service can be searched for");
+
+		Search.QuerySettings.Set(AttributeType::Name, Value, Comparison);
+	}
+}
@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/MiscTrace.h"
+
+/**
+ * Instrumentation of the plugin, compiled out in shipping builds.
+ *
+ * - 'stat MultiplayerSessions' shows the scoped timings, the in-flight counters and the lifecycle latencies
+ * - Unreal Insights: run with -trace=cpu,counters,bookmark,region,MultiplayerSessions, the scopes are on the MultiplayerSessions channel,
+ *   the lifecycle spans (host click to ServerTravel, search click to first row, join click to ClientTravel) are timing regions
+ * - -llm shows the search results and the server list widgets under MultiplayerSessions
+ */
+#ifndef MULTIPLAYERSESSIONS_INSTRUMENTATION
+#define MULTIPLAYERSESSIONS_INSTRUMENTATION !UE_BUILD_SHIPPING
+#endif
+
+DECLARE_STATS_GROUP(TEXT("MultiplayerSessions"), STATGROUP_MultiplayerSessions, STATCAT_Advanced);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Session Operations In Flight"), STAT_SessionOperationsInFlight, STATGROUP_MultiplayerSessions, MULTIPLAYERSESSIONS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Searches In Flight"), STAT_SessionSearchesInFlight, STATGROUP_MultiplayerSessions, MULTIPLAYERSESSIONS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Async Tasks In Flight"), STAT_SessionTasksInFlight, STATGROUP_MultiplayerSessions, MULTIPLAYERSESSIONS_API);
+
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Host To Created (ms)"), STAT_HostToCreatedMs, STATGROUP_MultiplayerSessions, MULTIPLAYERSESSIONS_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Host To Started (ms)"), STAT_HostToStartedMs, STATGROUP_MultiplayerSessions, MULTIPLAYERSESSIONS_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Host To ServerTravel (ms)"), STAT_HostToTravelMs, STATGROUP_MultiplayerSessions, MULTIPLAYERSESSIONS_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Search To First Row (ms)"), STAT_SearchToFirstRowMs, STATGROUP_MultiplayerSessions, MULTIPLAYERSESSIONS_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Join To ClientTravel (ms)"), STAT_JoinToTravelMs, STATGROUP_MultiplayerSessions, MULTIPLAYERSESSIONS_API);
+
+LLM_DECLARE_TAG_API(MultiplayerSessions, MULTIPLAYERSESSIONS_API);
+LLM_DECLARE_TAG_API(MultiplayerSessions_SearchResults, MULTIPLAYERSESSIONS_API);
+LLM_DECLARE_TAG_API(MultiplayerSessions_Widgets, MULTIPLAYERSESSIONS_API);
+
+/**
+ * Spans of the session lifecycle that cross frames and callbacks, measured from the click that started them.
+ */
+namespace ESessionSpan
+{
+	enum Type : uint8
+	{
+		Host,	// host clicked -> created -> started -> ServerTravel
+		Search,	// search clicked -> first row in the server list
+		Join,	// join clicked -> ClientTravel
+		Num,
+	};
+}
+
+#if MULTIPLAYERSESSIONS_INSTRUMENTATION
+
+UE_TRACE_CHANNEL_EXTERN(MultiplayerSessionsChannel, MULTIPLAYERSESSIONS_API);
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(SessionOperationsInFlight);
+TRACE_DECLARE_INT_COUNTER_EXTERN(SessionSearchesInFlight);
+TRACE_DECLARE_INT_COUNTER_EXTERN(SessionTasksInFlight);
+
+namespace SessionStats
+{
+	// Restarts the span, a span that is still open is ended without a sample
+	MULTIPLAYERSESSIONS_API void BeginSpan(ESessionSpan::Type Span);
+	// Milliseconds since the span began, negative if it is not open
+	MULTIPLAYERSESSIONS_API double GetSpanMs(ESessionSpan::Type Span);
+	MULTIPLAYERSESSIONS_API void EndSpan(ESessionSpan::Type Span);
+}
+
+// Times the enclosing scope under the stat group and on the trace channel
+#define SESSION_SCOPE_CYCLE_COUNTER(Name) \
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT(#Name), STAT_MultiplayerSessions_##Name, STATGROUP_MultiplayerSessions); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Name, MultiplayerSessionsChannel)
+
+#define SESSION_LLM_SCOPE(Tag) LLM_SCOPE_BYTAG(MultiplayerSessions_##Tag)
+
+#define SESSION_SET_COUNTER(Name, Value) \
+	SET_DWORD_STAT(STAT_##Name, Value); \
+	TRACE_COUNTER_SET(Name, Value)
+
+#define SESSION_SPAN_BEGIN(Span) SessionStats::BeginSpan(ESessionSpan::Span)
+
+// Samples a milestone of an open span into a latency stat and drops a bookmark, does nothing if the span is not open
+#define SESSION_SPAN_MARK(Span, Stat) \
+	do \
+	{ \
+		const double SpanMs = SessionStats::GetSpanMs(ESessionSpan::Span); \
+		if(SpanMs >= 0.0) \
+		{ \
+			SET_FLOAT_STAT(Stat, SpanMs); \
+			TRACE_BOOKMARK(TEXT(#Stat " %.1f ms"), SpanMs); \
+		} \
+	} while(0)
+
+#define SESSION_SPAN_END(Span, Stat) \
+	do \
+	{ \
+		SESSION_SPAN_MARK(Span, Stat); \
+		SessionStats::EndSpan(ESessionSpan::Span); \
+	} while(0)
+
+// Closes a span that did not reach its end, e.g. a failed create or a cancelled search
+#define SESSION_SPAN_CANCEL(Span) SessionStats::EndSpan(ESessionSpan::Span)
+
+#else
+
+#define SESSION_SCOPE_CYCLE_COUNTER(Name)
+#define SESSION_LLM_SCOPE(Tag)
+#define SESSION_SET_COUNTER(Name, Value)
+#define SESSION_SPAN_BEGIN(Span)
+#define SESSION_SPAN_MARK(Span, Stat)
+#define SESSION_SPAN_END(Span, Stat)
+#define SESSION_SPAN_CANCEL(Span)
+
+#endif
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "SessionTask.generated.h"
+
+/**
+ * How an async session task ended.
+ */
+UENUM(BlueprintType)
+enum class ESessionTaskStatus : uint8
+{
+	Succeeded,
+	Failed,
+	TimedOut,	// the deadline passed, the backend operation was abandoned and its delegate released
+	Cancelled,
+};
+
+/**
+ * The operation a session task waits for.
+ */
+namespace ESessionTaskType
+{
+	enum Type : uint8
+	{
+		Create,
+		Start,
+		Destroy,
+		Find,
+		Join,
+	};
+}
+
+struct MULTIPLAYERSESSIONS_API FSessionTaskResult
+{
+	ESessionTaskStatus Status = ESessionTaskStatus::Failed;
+	EOnJoinSessionCompleteResult::Type JoinResult = EOnJoinSessionCompleteResult::UnknownError;//Join tasks only
+	int32 NumSearchResults = 0;//Find tasks only
+
+	FORCEINLINE bool IsSuccess() const { return Status == ESessionTaskStatus::Succeeded; }
+};
+
+/**
+ * A running async session operation. The future is fulfilled on the game thread exactly once,
+ * pass Id to UMultiplayerSessionsSubsystem::CancelSessionTask to give up on it early.
+ */
+struct MULTIPLAYERSESSIONS_API FSessionTask
+{
+	uint32 Id = 0;
+	TFuture<FSessionTaskResult> Result;
+
+	FORCEINLINE bool IsValid() const { return Id != 0 && Result.IsValid(); }
+};
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "GenericPlatform/GenericWindow.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+// The parts of the game user settings that are applied independently of each other, combinable as flags
+namespace ESettingsChange
+{
+	enum Type : uint8
+	{
+		None = 0,
+		Scalability = 1 << 0,
+		Resolution = 1 << 1,
+		WindowMode = 1 << 2,
+		Audio = 1 << 3,
+		Input = 1 << 4,
+	};
+}
+
+struct FSettingsCommitResult
+{
+	uint8 Applied = ESettingsChange::None;//ESettingsChange flags that were applied
+	uint8 ModeSwitches = ESettingsChange::None;//applied changes that switched the display mode, the screen goes black for a moment
+	uint8 RestartRequired = ESettingsChange::None;//changes that are saved but only take effect after a restart
+
+	bool HasChanges() const { return Applied != ESettingsChange::None; }
+};
+
+DECLARE_DELEGATE_OneParam(FOnSettingsCommitted, const FSettingsCommitResult & /*Result*/);
+
+/**
+ * Stages changes to UDESettings and applies only what actually changed, instead of ApplySettings() for every click.
+ * Every staged value is compared against the current setting, a value that is set back to the current one drops out again.
+ *
+ *   SettingsTransaction.SetScalabilityLevel(2);
+ *   SettingsTransaction.CommitDebounced();//clicks within the debounce delay end up in one apply
+ *
+ * Scalability goes through ApplyNonResolutionSettings, resolution and window mode through ApplyResolutionSettings,
+ * audio and input are only stored, the settings are saved once per commit.
+ */
+class MULTIPLAYERSESSIONS_API FSettingsTransaction
+{
+public:
+	static constexpr float DefaultDebounceDelay = 0.3f;
+
+	FSettingsTransaction() = default;
+	~FSettingsTransaction();
+
+	FSettingsTransaction(const FSettingsTransaction &) = delete;
+	FSettingsTransaction & operator=(const FSettingsTransaction &) = delete;
+
+	void SetScalabilityLevel(int32 Level);
+	void SetResolution(FIntPoint Resolution);
+	void SetWindowMode(EWindowMode::Type WindowMode);
+	void SetMasterVolume(float Volume);
+	void SetMouseSensitivity(float Sensitivity);
+
+	// ESettingsChange flags of the staged changes
+	uint8 GetPendingChanges() const { return PendingChanges; }
+
+	// Applies the staged changes now, a scheduled debounced commit is dropped
+	FSettingsCommitResult Commit();
+
+	// Applies the staged changes once no further commit was requested for Delay seconds
+	void CommitDebounced(float Delay = DefaultDebounceDelay);
+
+	// Drops the staged changes
+	void Reset();
+
+	// Called after every commit that applied something
+	FOnSettingsCommitted OnCommitted;
+
+	// Commits save through the governor, so its temporary steps are not saved as the player's quality
+	void SetQualityGovernor(class UQualityGovernor * InQualityGovernor) { QualityGovernor = InQualityGovernor; }
+
+private:
+	bool OnDebounceElapsed(float DeltaTime);
+	void Stage(ESettingsChange::Type Change, bool bDiffers);
+
+	uint8 PendingChanges = ESettingsChange::None;
+
+	int32 ScalabilityLevel = 0;
+	FIntPoint Resolution = FIntPoint::ZeroValue;
+	EWindowMode::Type WindowMode = EWindowMode::Windowed;
+	float MasterVolume = 0.f;
+	float MouseSensitivity = 0.f;
+
+	TWeakObjectPtr<class UQualityGovernor> QualityGovernor;
+
+	FTSTicker::FDelegateHandle DebounceTickerHandle;
+};
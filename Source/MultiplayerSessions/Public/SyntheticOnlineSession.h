@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "OnlineSessionSettings.h"
+#include "Containers/Ticker.h"
+#include "Math/RandomStream.h"
+#include "SyntheticOnlineSession.generated.h"
+
+/**
+ * Configuration of the in-process session backend, read from the game config:
+ *
+ *   [/Script/MultiplayerSessions.SyntheticSessionBackendSettings]
+ *   bEnabled=True
+ *   NumAdvertisedSessions=5000
+ *   FailureRate=0.05
+ *
+ * -SyntheticSessions on the command line enables it too. Latencies are in seconds.
+ */
+UCLASS(Config = Game)
+class MULTIPLAYERSESSIONS_API USyntheticSessionBackendSettings : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	// UMultiplayerSessionsSubsystem uses the synthetic backend instead of the online subsystem's session interface
+	UPROPERTY(Config)
+	bool bEnabled = false;
+
+	// Seeds the advertised sessions and every random decision, the same seed and calls give the same outcomes
+	UPROPERTY(Config)
+	int32 RandomSeed = 1337;
+
+	UPROPERTY(Config)
+	int32 NumAdvertisedSessions = 2000;
+
+	// Per call latency: normally distributed around the mean, with an occasional tail spike
+	UPROPERTY(Config)
+	float LatencyMean = 0.15f;
+
+	UPROPERTY(Config)
+	float LatencyStdDev = 0.05f;
+
+	UPROPERTY(Config)
+	float LatencyTailChance = 0.02f;
+
+	UPROPERTY(Config)
+	float LatencyTail = 2.f;
+
+	// Chance that a call completes with a failure
+	UPROPERTY(Config)
+	float FailureRate = 0.f;
+
+	// Chance that a search fails after having delivered only a part of its results
+	UPROPERTY(Config)
+	float PartialSearchFailureRate = 0.f;
+
+	// Calls beyond this many per second fail as throttled, 0 disables throttling
+	UPROPERTY(Config)
+	int32 MaxCallsPerSecond = 0;
+
+	// Chance that a session with open slots fills up between search and join
+	UPROPERTY(Config)
+	float JoinFullRaceRate = 0.05f;
+
+	// Chance per search that an advertised session gains or loses a player or goes away
+	UPROPERTY(Config)
+	float SessionChurnRate = 0.02f;
+
+	// A search delivers its results in this many slices while it is in progress
+	UPROPERTY(Config)
+	int32 SearchResultSlices = 4;
+
+	static bool IsEnabled();
+};
+
+/**
+ * IOnlineSession implemented entirely in-process, for load tests of the create/find/join/destroy paths without a network or accounts.
+ * Thousands of sessions are advertised from a seeded random stream, every call completes on the game thread after a simulated latency
+ * and may be throttled, fail, deliver partial results or lose a join race, all decided by the same stream.
+ */
+class MULTIPLAYERSESSIONS_API FSyntheticOnlineSession : public IOnlineSession
+{
+public:
+	explicit FSyntheticOnlineSession(const USyntheticSessionBackendSettings & InSettings);
+	virtual ~FSyntheticOnlineSession();
+
+	// IOnlineSession
+	virtual FUniqueNetIdPtr CreateSessionIdFromString(const FString & SessionIdStr) override;
+	virtual FNamedOnlineSession * GetNamedSession(FName SessionName) override;
+	virtual void RemoveNamedSession(FName SessionName) override;
+	virtual EOnlineSessionState::Type GetSessionState(FName SessionName) const override;
+	virtual bool HasPresenceSession() override;
+	virtual bool CreateSession(int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings & NewSessionSettings) override;
+	virtual bool CreateSession(const FUniqueNetId & HostingPlayerId, FName SessionName, const FOnlineSessionSettings & NewSessionSettings) override;
+	virtual bool StartSession(FName SessionName) override;
+	virtual bool UpdateSession(FName SessionName, FOnlineSessionSettings & UpdatedSessionSettings, bool bShouldRefreshOnlineData = true) override;
+	virtual bool EndSession(FName SessionName) override;
+	virtual bool DestroySession(FName SessionName, const FOnDestroySessionCompleteDelegate & CompletionDelegate = FOnDestroySessionCompleteDelegate()) override;
+	virtual bool IsPlayerInSession(FName SessionName, const FUniqueNetId & UniqueId) override;
+	virtual bool StartMatchmaking(const TArray<FUniqueNetIdRef> & LocalPlayers, FName SessionName, const FOnlineSessionSettings & NewSessionSettings, TSharedRef<FOnlineSessionSearch> & SearchSettings) override;
+	virtual bool CancelMatchmaking(int32 SearchingPlayerNum, FName SessionName) override;
+	virtual bool CancelMatchmaking(const FUniqueNetId & SearchingPlayerId, FName SessionName) override;
+	virtual bool FindSessions(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch> & SearchSettings) override;
+	virtual bool FindSessions(const FUniqueNetId & SearchingPlayerId, const TSharedRef<FOnlineSessionSearch> & SearchSettings) override;
+	virtual bool FindSessionById(const FUniqueNetId & SearchingUserId, const FUniqueNetId & SessionId, const FUniqueNetId & FriendId, const FOnSingleSessionResultCompleteDelegate & CompletionDelegate) override;
+	virtual bool CancelFindSessions() override;
+	virtual bool PingSearchResults(const FOnlineSessionSearchResult & SearchResult) override;
+	virtual bool JoinSession(int32 LocalUserNum, FName SessionName, const FOnlineSessionSearchResult & DesiredSession) override;
+	virtual bool JoinSession(const FUniqueNetId & LocalUserId, FName SessionName, const FOnlineSessionSearchResult & DesiredSession) override;
+	virtual bool FindFriendSession(int32 LocalUserNum, const FUniqueNetId & Friend) override;
+	virtual bool FindFriendSession(const FUniqueNetId & LocalUserId, const FUniqueNetId & Friend) override;
+	virtual bool FindFriendSession(const FUniqueNetId & LocalUserId, const TArray<FUniqueNetIdRef> & FriendList) override;
+	virtual bool SendSessionInviteToFriend(int32 LocalUserNum, FName SessionName, const FUniqueNetId & Friend) override;
+	virtual bool SendSessionInviteToFriend(const FUniqueNetId & LocalUserId, FName SessionName, const FUniqueNetId & Friend) override;
+	virtual bool SendSessionInviteToFriends(int32 LocalUserNum, FName SessionName, const TArray<FUniqueNetIdRef> & Friends) override;
+	virtual bool SendSessionInviteToFriends(const FUniqueNetId & LocalUserId, FName SessionName, const TArray<FUniqueNetIdRef> & Friends) override;
+	virtual bool GetResolvedConnectString(FName SessionName, FString & ConnectInfo, FName PortType = NAME_GamePort) override;
+	virtual bool GetResolvedConnectString(const FOnlineSessionSearchResult & SearchResult, FName PortType, FString & ConnectInfo) override;
+	virtual FOnlineSessionSettings * GetSessionSettings(FName SessionName) override;
+	virtual bool RegisterPlayer(FName SessionName, const FUniqueNetId & PlayerId, bool bWasInvited) override;
+	virtual bool RegisterPlayers(FName SessionName, const TArray<FUniqueNetIdRef> & Players, bool bWasInvited = false) override;
+	virtual bool UnregisterPlayer(FName SessionName, const FUniqueNetId & PlayerId) override;
+	virtual bool UnregisterPlayers(FName SessionName, const TArray<FUniqueNetIdRef> & Players) override;
+	virtual void RegisterLocalPlayer(const FUniqueNetId & PlayerId, FName SessionName, const FOnRegisterLocalPlayerCompleteDelegate & Delegate) override;
+	virtual void UnregisterLocalPlayer(const FUniqueNetId & PlayerId, FName SessionName, const FOnUnregisterLocalPlayerCompleteDelegate & Delegate) override;
+	virtual void RemovePlayerFromSession(int32 LocalUserNum, FName SessionName, const FUniqueNetId & TargetPlayerId) override;
+	virtual int32 GetNumSessions() override;
+	virtual void DumpSessionState() override;
+
+protected:
+	virtual FNamedOnlineSession * AddNamedSession(FName SessionName, const FOnlineSessionSettings & SessionSettings) override;
+	virtual FNamedOnlineSession * AddNamedSession(FName SessionName, const FOnlineSession & Session) override;
+
+private:
+	struct FPendingCall
+	{
+		double DueTime = 0.0;
+		uint64 Sequence = 0;//completes calls that are due at the same time in call order
+		TFunction<void()> Complete;
+	};
+
+	void AdvertiseSessions();
+	bool Tick(float DeltaTime);
+	void Schedule(double Delay, TFunction<void()> && Complete);
+	double RollLatency();
+	bool Roll(float Chance);
+	bool IsThrottled();
+
+	int32 FindAdvertised(const FString & SessionId) const;
+	bool Matches(const FOnlineSession & Session, const FOnlineSearchSettings & Query) const;
+	void ChurnAdvertisedSessions();
+	void DeliverSearchSlice(int32 Slice, int32 NumSlices);
+
+	FOnlineSession MakeAdvertisedSession();
+	void FinishSearch(bool bWasSuccessful);
+
+	const USyntheticSessionBackendSettings & Settings;
+	FRandomStream Random;
+
+	TIndirectArray<FNamedOnlineSession> Sessions;
+	TArray<FOnlineSession> Advertised;//what a search can find, the generated sessions followed by the ones hosted through this backend
+	int32 NumGeneratedSessions = 0;
+
+	TSharedPtr<FOnlineSessionSearch> CurrentSearch;
+	TArray<int32> CurrentSearchMatches;//indices into Advertised, delivered in slices
+	uint32 SearchSerial = 0;//invalidates the pending slices of a cancelled search
+
+	TArray<FPendingCall> PendingCalls;
+	uint64 NextCallSequence = 0;
+	TArray<double> RecentCallTimes;//for the throttling window
+	uint32 NextSessionNumber = 0;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+};